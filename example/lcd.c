@@ -33,48 +33,71 @@
 
 
 
+#define LCD_COLS    80
+#define LCD_ROWS    4
+
 struct coord {
 	short x, y;
 };
 
-void lcd_putc( short x, short y, char c )
+/* Write a run of characters to one row of the display in one transfer */
+static void * lcd_blit( void * ap, unsigned int x, unsigned int y, 
+                        const char *s, size_t n )
 {
-	printf( "(%2d,%2d) \"%c\"\n", x, y, c );
+	fprintf( (FILE *)ap, "(%2u,%2u) \"%.*s\"\n", x, y, (int)n, s );
+	
+	return ap;
 }
 
+static char lcd_line[LCD_COLS];
+static struct format_screen lcd;
+
 
-void * lcd_putat( void * ap, const char *s, size_t n )
+static int lcd_printf( struct coord loc, const char *fmt, ... )
+{
+    va_list arg;
+    int done;
+    
+    if ( format_screen_move( &lcd, loc.x, loc.y ) < 0 )
+        return -1;
+    
+    va_start ( arg, fmt );
+    done = format( format_screen_put, &lcd, fmt, arg );
+    va_end ( arg );
+    
+    if ( format_screen_flush( &lcd ) < 0 )
+        return -1;
+    
+    return done;
+}
+
+
+/* Write one changed span of a template shown at the given location */
+static void * lcd_update( void * ap, size_t offset, const char *s, size_t n )
 {
 	struct coord *pc = (struct coord *)ap;
 	
-	while ( n-- )
-	{
-		lcd_putc( pc->x++, pc->y, *s++ );
-		if ( pc->x >= 80 )
-		{
-			pc->x = 0;
-			pc->y++;
-		}
-	}
+	if ( format_screen_move( &lcd, pc->x + (unsigned int)offset, pc->y ) < 0
+	     || format_screen_put( &lcd, s, n ) == NULL
+	     || format_screen_flush( &lcd ) < 0 )
+		return NULL;
 	
-	return (void *)pc;
+	return ap;
 }
 
 
-int lcd_printf( struct coord loc, const char *fmt, ... )
+static int lcd_refresh( struct format_template *t, struct coord loc, ... )
 {
     va_list arg;
     int done;
     
-    va_start ( arg, fmt );
-    done = format( lcd_putat, &loc, fmt, arg );
+    va_start ( arg, loc );
+    done = format_template_update( t, lcd_update, &loc, arg );
     va_end ( arg );
     
     return done;
 }
 
-
-
     
 
 int main( void )
@@ -83,6 +106,8 @@ int main( void )
     int temperature;
     int status;
     
+    format_screen_init( &lcd, lcd_blit, stdout, LCD_COLS, LCD_ROWS, lcd_line );
+    
     temperature = 32;
     loc.x = 5;
     loc.y = 2;
@@ -92,5 +117,31 @@ int main( void )
     	/* error handler */
     }
     
+    /* A status line which is redrawn each frame, but only the characters 
+     * which change are sent to the display.
+     */
+    {
+        static struct format_template status_line;
+        static struct format_cell cells[3];
+        static char text[40];
+        int frame;
+        
+        if ( format_template_init( &status_line, "Temp %+4d C  Fan %3u%%  %-6s", 
+                                   cells, 3, text, sizeof text ) < 0 )
+        {
+            /* error handler */
+        }
+        
+        loc.x = 0;
+        loc.y = 3;
+        for ( frame = 0; frame < 3; frame++ )
+        {
+            printf( "Frame %d\n", frame );
+            lcd_refresh( &status_line, loc, temperature, 40u + frame / 2, 
+                         frame < 2 ? "OK" : "ALARM" );
+            temperature++;
+        }
+    }
+    
     return 0;
 }
@@ -0,0 +1,141 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+/* fwrite_unlocked() is a GNU extension; flockfile() and putc_unlocked()
+   are POSIX. */
+#define _GNU_SOURCE
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+#include "format.h"
+
+#include "fprintf.h"
+
+/*****************************************************************************/
+/* Private function prototypes.  Declare as static.                          */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/**
+    Stream output consumer function.
+
+    The caller holds the stream lock, so each span goes straight into the
+    stream's buffer without locking it again.  Single characters, which
+    format sends for padding and short literals, go through putc_unlocked().
+
+    @param op      Stream to write to.
+    @param buf     Pointer to input buffer.
+    @param n       Number of characters from buffer to send to output.
+
+    @return op, or NULL if the stream reports an error.
+**/
+static void * file_write( void * op, const char * buf, size_t n )
+{
+    FILE *fp = (FILE *)op;
+
+    if ( n == 1 )
+        return putc_unlocked( *buf, fp ) == EOF ? NULL : op;
+
+#if defined(__GLIBC__)
+    return fwrite_unlocked( buf, 1, n, fp ) == n ? op : NULL;
+#else
+    while ( n-- )
+        if ( putc_unlocked( *buf++, fp ) == EOF )
+            return NULL;
+
+    return op;
+#endif
+}
+
+/*****************************************************************************/
+/* Public functions.  Declared as per header file.                           */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/**
+    Produce output to a stream according to a format string, with optional
+    argument list.
+
+    The stream is locked once for the whole call, so output from other
+    threads writing to the same stream is never mixed into it.
+
+    @param fp       Stream to write to.
+    @param fmt      Format specifier.
+    @param ap       Argument list.
+
+    @return Number of characters printed to the stream, or -1.
+**/
+int vfprintf ( FILE *fp, const char *fmt, va_list ap )
+{
+    int done;
+
+    flockfile( fp );
+    done = format( file_write, fp, fmt, ap );
+    funlockfile( fp );
+
+    return done;
+}
+
+/*****************************************************************************/
+/**
+    Produce output to a stream according to a format string, with optional
+    arguments.
+
+    @param fp       Stream to write to.
+    @param fmt      Format specifier.
+
+    @return Number of characters printed to the stream, or -1.
+**/
+int fprintf ( FILE *fp, const char *fmt, ... )
+{
+    va_list arg;
+    int done;
+
+    va_start ( arg, fmt );
+    done = vfprintf( fp, fmt, arg );
+    va_end ( arg );
+
+    return done;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
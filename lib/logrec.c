@@ -0,0 +1,422 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2011-2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+#include "format.h"
+#include "format_config.h"
+
+#include "logrec.h"
+
+#if !defined(CONFIG_WITH_TYPED_ARGS)
+#error "logrec.c needs CONFIG_WITH_TYPED_ARGS, for format_args()"
+#endif
+
+/**
+    Each thread builds its records in its own buffer, as format.c keeps its
+    timestamp cache.  Define CONFIG_THREAD_LOCAL to override the storage
+    class, for example as nothing on a single-threaded target.
+**/
+#if defined(CONFIG_THREAD_LOCAL)
+    #define THREAD_LOCAL    CONFIG_THREAD_LOCAL
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+    #define THREAD_LOCAL    _Thread_local
+#elif defined(__GNUC__)
+    #define THREAD_LOCAL    __thread
+#else
+    #define THREAD_LOCAL
+#endif
+
+/*****************************************************************************/
+/* Data types                                                                */
+/*****************************************************************************/
+
+/**
+    A record being built.  One character is always kept back for the
+    newline which ends the record.
+**/
+typedef struct {
+    char *          p;      /**< start of the buffer                **/
+    size_t          len;    /**< characters stored                  **/
+    size_t          max;    /**< characters which fit, less one     **/
+} T_Record;
+
+/*****************************************************************************/
+/* Private Data.  Declare as static.                                         */
+/*****************************************************************************/
+
+/**
+    The record of each thread, and its sink, which is NULL when there is no
+    record or it has been dropped.
+**/
+static THREAD_LOCAL char cur_text[LOGREC_BUF_SZ];
+static THREAD_LOCAL T_Record cur;
+static THREAD_LOCAL const struct logrec_sink * cur_sink;
+
+/**
+    Deferred records without a binary path are rendered here, so that they
+    can be logged while a record is being built.
+**/
+static THREAD_LOCAL char defer_text[LOGREC_BUF_SZ];
+
+static const char * const level_name[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+/*****************************************************************************/
+/* Private function prototypes.  Declare as static.                          */
+/*****************************************************************************/
+
+static void * rec_put( void *, const char *, size_t );
+static int rec_printf( T_Record *, const char *, ... );
+static void rec_head( T_Record *, int, unsigned long long, enum logrec_level );
+static int rec_vbegin( const struct logrec_sink *, enum logrec_level,
+                       const char *, va_list );
+static int rec_send( void );
+
+/*****************************************************************************/
+/* Private functions.  Declare as static.                                    */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/**
+    Format consumer function appending to a record.  Characters which do not
+    fit are dropped, so a long record is cut short rather than lost.
+
+    @param p        Pointer to the record.
+    @param s        Pointer to characters to append.
+    @param n        Number of characters.
+
+    @return @a p
+**/
+static void * rec_put( void * p, const char * s, size_t n )
+{
+    T_Record *pr = (T_Record *)p;
+    char *d;
+
+    if ( n > pr->max - pr->len )
+        n = pr->max - pr->len;
+
+    for ( d = pr->p + pr->len, pr->len += n; n--; )
+        *d++ = *s++;
+
+    return p;
+}
+
+/*****************************************************************************/
+/**
+    Append formatted text to a record.
+
+    @param pr       Pointer to the record.
+    @param fmt      Format specification.
+
+    @return Number of characters formatted, or EXBADFORMAT.
+**/
+static int rec_printf( T_Record * pr, const char * fmt, ... )
+{
+    va_list arg;
+    int done;
+
+    va_start( arg, fmt );
+    done = format( rec_put, pr, fmt, arg );
+    va_end( arg );
+
+    return done;
+}
+
+/*****************************************************************************/
+/**
+    Write the start of a record: the time in seconds, if there is one, and
+    the severity.
+
+    @param pr       Pointer to the record.
+    @param timed    Non-zero if @a time is valid.
+    @param time     Time in nanoseconds.
+    @param level    Severity.
+**/
+static void rec_head( T_Record *         pr,
+                      int                timed,
+                      unsigned long long time,
+                      enum logrec_level  level )
+{
+    if ( timed )
+        rec_printf( pr, "%lu.%06lu ",
+                (unsigned long)( time / 1000000000u ),
+                (unsigned long)( time % 1000000000u / 1000u ) );
+
+    rec_printf( pr, "%-5s ", level_name[level] );
+}
+
+/*****************************************************************************/
+/**
+    Start the record of the calling thread.
+
+    @param sink     Where the record goes.
+    @param level    Severity.
+    @param fmt      Message format.
+    @param ap       Its arguments.
+
+    @return 0, or EXBADFORMAT if the format is bad.
+**/
+static int rec_vbegin( const struct logrec_sink * sink,
+                       enum logrec_level          level,
+                       const char *               fmt,
+                       va_list                    ap )
+{
+    cur_sink = NULL;
+    if ( level < sink->level )
+        return 0;
+
+    cur.p   = cur_text;
+    cur.len = 0;
+    cur.max = sizeof cur_text - 1;
+
+    rec_head( &cur, sink->clock != NULL, sink->clock ? sink->clock() : 0,
+              level );
+
+    if ( format( rec_put, &cur, fmt, ap ) < 0 )
+        return EXBADFORMAT;
+
+    cur_sink = sink;
+
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+    End the record of the calling thread with a newline and send it.
+
+    @return Length of the record, 0 if there is none, or EXBADFORMAT if the
+            sink failed.
+**/
+static int rec_send( void )
+{
+    const struct logrec_sink *sink = cur_sink;
+
+    if ( sink == NULL )
+        return 0;
+    cur_sink = NULL;
+
+    cur.p[cur.len++] = '\n';
+
+    if ( sink->write( sink->arg, cur.p, cur.len ) < 0 )
+        return EXBADFORMAT;
+
+    return (int)cur.len;
+}
+
+/*****************************************************************************/
+/* Public functions.  Declared as per header file.                           */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/**
+    Start a record in the buffer of the calling thread.
+
+    @param sink     Where the record goes.
+    @param level    Severity.
+    @param fmt      Message format.
+
+    @return 0, or EXBADFORMAT if the format is bad.
+**/
+int logrec_begin( const struct logrec_sink * sink,
+                  enum logrec_level          level,
+                  const char *               fmt,
+                  ... )
+{
+    va_list arg;
+    int done;
+
+    va_start( arg, fmt );
+    done = rec_vbegin( sink, level, fmt, arg );
+    va_end( arg );
+
+    return done;
+}
+
+/*****************************************************************************/
+/**
+    Add a key=value field to the record of the calling thread.
+
+    @param key      Name of the field.
+    @param fmt      Format of the value.
+
+    @return 0, or EXBADFORMAT if the format is bad.
+**/
+int logrec_field( const char * key,
+                  const char * fmt,
+                  ... )
+{
+    va_list arg;
+    int done;
+
+    if ( cur_sink == NULL )
+        return 0;
+
+    rec_printf( &cur, " %s=", key );
+
+    va_start( arg, fmt );
+    done = format( rec_put, &cur, fmt, arg );
+    va_end( arg );
+
+    return done < 0 ? EXBADFORMAT : 0;
+}
+
+/*****************************************************************************/
+/**
+    Finish the record of the calling thread and send it.
+
+    @return Length of the record, 0 if it was dropped, or EXBADFORMAT.
+**/
+int logrec_end( void )
+{
+    return rec_send();
+}
+
+/*****************************************************************************/
+/**
+    Send a record with no fields.
+
+    @param sink     Where the record goes.
+    @param level    Severity.
+    @param fmt      Message format.
+
+    @return Length of the record, 0 if it was dropped, or EXBADFORMAT.
+**/
+int logrec( const struct logrec_sink * sink,
+            enum logrec_level          level,
+            const char *               fmt,
+            ... )
+{
+    va_list arg;
+    int done;
+
+    va_start( arg, fmt );
+    done = rec_vbegin( sink, level, fmt, arg );
+    va_end( arg );
+
+    return done < 0 ? done : rec_send();
+}
+
+/*****************************************************************************/
+/**
+    Send a record with its arguments in binary form.
+
+    @param sink     Where the record goes.
+    @param level    Severity.
+    @param fmt      Message format.
+    @param args     Table of arguments.
+    @param tags     FORMAT_ARG_ type of each argument.
+    @param nargs    Number of arguments.
+
+    @return 0 or the length of the record, or EXBADFORMAT.
+**/
+int logrec_defer( const struct logrec_sink * sink,
+                  enum logrec_level          level,
+                  const char *               fmt,
+                  const union format_arg *   args,
+                  const unsigned char *      tags,
+                  unsigned int               nargs )
+{
+    struct logrec_deferred d;
+    unsigned int i;
+    int n;
+
+    if ( level < sink->level )
+        return 0;
+    if ( nargs > LOGREC_MAX_ARGS )
+        return EXBADFORMAT;
+
+    d.time  = sink->clock ? sink->clock() : 0;
+    d.level = level;
+    d.fmt   = fmt;
+    d.nargs = nargs;
+    for ( i = 0; i < nargs; i++ )
+    {
+        d.tags[i] = tags[i];
+        d.args[i] = args[i];
+    }
+
+    if ( sink->defer )
+        return sink->defer( sink->arg, &d ) < 0 ? EXBADFORMAT : 0;
+
+    /* No binary path, so render the record now */
+    if ( ( n = logrec_render( &d, defer_text, sizeof defer_text ) ) < 0
+         || sink->write( sink->arg, defer_text, (size_t)n ) < 0 )
+        return EXBADFORMAT;
+
+    return n;
+}
+
+/*****************************************************************************/
+/**
+    Render a deferred record as text.
+
+    @param rec      The deferred record.
+    @param buf      Buffer for the text.
+    @param size     Size of @a buf.
+
+    @return Length of the text, or EXBADFORMAT.
+**/
+int logrec_render( const struct logrec_deferred * rec,
+                   char *                         buf,
+                   size_t                         size )
+{
+    T_Record r;
+
+    if ( size < 2 )
+        return EXBADFORMAT;
+
+    r.p   = buf;
+    r.len = 0;
+    r.max = size - 1;
+
+    rec_head( &r, rec->time != 0, rec->time, rec->level );
+
+    if ( format_args( rec_put, &r, rec->fmt, rec->args, rec->tags,
+                      rec->nargs ) < 0 )
+        return EXBADFORMAT;
+
+    r.p[r.len++] = '\n';
+
+    return (int)r.len;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
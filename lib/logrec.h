@@ -0,0 +1,205 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2011-2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+#ifndef LOGREC_H
+#define LOGREC_H
+
+#include <stddef.h> /* for size_t */
+
+#include "format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+    Size of the per-thread record buffer.  Longer records are cut short,
+    but still end with a newline.
+**/
+#ifndef LOGREC_BUF_SZ
+#define LOGREC_BUF_SZ       ( 256 )
+#endif
+
+/**
+    Most arguments a deferred record can hold.
+**/
+#ifndef LOGREC_MAX_ARGS
+#define LOGREC_MAX_ARGS     ( 8 )
+#endif
+
+/**
+    Severity of a record.
+**/
+enum logrec_level {
+    LOGREC_DEBUG,
+    LOGREC_INFO,
+    LOGREC_WARN,
+    LOGREC_ERROR
+};
+
+/**
+    A record kept in binary form, to be rendered later by logrec_render().
+    Strings and pointers are kept by address, so must outlive the record.
+**/
+struct logrec_deferred {
+    unsigned long long      time;   /**< sink's clock, or 0 if it has none **/
+    enum logrec_level       level;  /**< severity                         **/
+    const char *            fmt;    /**< message format                   **/
+    unsigned int            nargs;  /**< number of arguments              **/
+    unsigned char           tags[LOGREC_MAX_ARGS]; /**< FORMAT_ARG_ types **/
+    union format_arg        args[LOGREC_MAX_ARGS]; /**< the arguments     **/
+};
+
+/**
+    Where the records go.  write is called once for each finished record,
+    with the text ending in a newline, and returns 0 or a negative value on
+    failure; it may copy into a ring buffer, write to a file descriptor or
+    store into mapped memory.  defer, if not NULL, is given the deferred
+    records to copy instead of text.  clock, if not NULL, returns a
+    monotonic time in nanoseconds.  Records below level are dropped.
+**/
+struct logrec_sink {
+    int  (* write)( void *, const char *, size_t );
+    int  (* defer)( void *, const struct logrec_deferred * );
+    unsigned long long (* clock)( void );
+    void *                  arg;    /**< passed to write and defer        **/
+    enum logrec_level       level;  /**< lowest level sent                **/
+};
+
+/**
+    Start a record in the buffer of the calling thread, with the time, the
+    severity and the message.  The record is sent by logrec_end(), and each
+    thread builds one record at a time.
+    
+    @param sink         Where the record goes.
+    @param level        Severity.
+    @param fmt          Message format, then its arguments.
+    
+    @returns            0, or EXBADFORMAT if the message format is bad.
+**/
+extern int logrec_begin( const struct logrec_sink * /* sink  */,
+             enum logrec_level          /* level */,
+             const char *               /* fmt   */,
+             ...
+);
+
+/**
+    Add a key=value field to the record of the calling thread.  Use %q for
+    values which may contain spaces or quotes.
+    
+    @param key          Name of the field.
+    @param fmt          Format of the value, then its arguments.
+    
+    @returns            0, or EXBADFORMAT if the format is bad.
+**/
+extern int logrec_field( const char * /* key */,
+             const char * /* fmt */,
+             ...
+);
+
+/**
+    Finish the record of the calling thread and send it to the sink with
+    one call.
+    
+    @returns            Length of the record, 0 if it was dropped, or
+                        EXBADFORMAT if the sink failed.
+**/
+extern int logrec_end( void );
+
+/**
+    Send a record with no fields, as logrec_begin() then logrec_end().
+    
+    @returns            Length of the record, 0 if it was dropped, or
+                        EXBADFORMAT.
+**/
+extern int logrec( const struct logrec_sink * /* sink  */,
+             enum logrec_level          /* level */,
+             const char *               /* fmt   */,
+             ...
+);
+
+/**
+    Send a record with its arguments in binary form, for the sink's defer
+    function to copy, or render and write it now if the sink has none.
+    Normally called through the LOGREC_DEFER() macro below.
+    
+    @param sink         Where the record goes.
+    @param level        Severity.
+    @param fmt          Message format, which must outlive the record.
+    @param args         Table of arguments.
+    @param tags         FORMAT_ARG_ type of each argument.
+    @param nargs        Number of arguments, at most LOGREC_MAX_ARGS.
+    
+    @returns            0 or the length of the record, or EXBADFORMAT.
+**/
+extern int logrec_defer( const struct logrec_sink * /* sink  */,
+             enum logrec_level          /* level */,
+             const char *               /* fmt   */,
+             const union format_arg *   /* args  */,
+             const unsigned char *      /* tags  */,
+             unsigned int               /* nargs */
+);
+
+/**
+    Render a deferred record as text, in the same form as the other records.
+    
+    @param rec          The deferred record.
+    @param buf          Buffer for the text.
+    @param size         Size of @a buf, at least 2.
+    
+    @returns            Length of the text, which ends with a newline and is
+                        not terminated, or EXBADFORMAT.
+**/
+extern int logrec_render( const struct logrec_deferred * /* rec  */,
+             char *                         /* buf  */,
+             size_t                         /* size */
+);
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__cplusplus)
+/**
+    LOGREC_DEFER( sink, level, fmt, ... ) calls logrec_defer() with the
+    argument table built at the call site, as FORMAT() does.
+    
+        LOGREC_DEFER( &sink, LOGREC_WARN, "queue %s at %d%%", name, fill );
+**/
+#define LOGREC_DEFER(sink, level, ...)                                      \
+    FORMAT_APPLY( logrec_defer, (sink), (level), __VA_ARGS__ )
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOGREC_H */
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
@@ -0,0 +1,715 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+/* The shim replaces the functions themselves, not the fortified wrappers */
+#undef _FORTIFY_SOURCE
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+#include "format.h"
+#include "format_config.h"
+
+/**
+    Output to a file descriptor is gathered into blocks of this size.
+**/
+#define FDBUF_SZ            ( 512 )
+
+/**
+    First allocation for asprintf().
+**/
+#define DBUF_MIN            ( 64 )
+
+/**
+    Largest width and precision format takes, as MAXWIDTH in format.c.
+**/
+#define MAX_WIDTH           ( 500 )
+
+/**
+    Format strings remembered by each thread, and the longest remembered,
+    including its null character.
+**/
+#define SEEN_N              ( 16 )
+#define SEEN_SZ             ( 32 )
+
+#define MIN(a,b)            ( (a) < (b) ? (a) : (b) )
+
+/**
+    Look up, once, the C library's own definition of @a fn.
+**/
+#define REAL(fn)            ( real_##fn ? real_##fn                          \
+                              : ( *(void **)&real_##fn =                     \
+                                  dlsym( RTLD_NEXT, #fn ), real_##fn ) )
+
+/*****************************************************************************/
+/* Data types                                                                */
+/*****************************************************************************/
+
+/** Bounded memory output, as for snprintf() **/
+struct nbuf {
+    char *          ptr;    /**< next destination byte                  **/
+    size_t          n;      /**< remaining buffer space                 **/
+};
+
+/** Output to a file descriptor, as for dprintf() **/
+struct fdbuf {
+    int             fd;     /**< destination                            **/
+    size_t          len;    /**< characters held in buf                 **/
+    char            buf[FDBUF_SZ];
+};
+
+/** Output to allocated memory, as for asprintf() **/
+struct dbuf {
+    char *          ptr;    /**< start of the allocation                **/
+    size_t          len;    /**< characters held                        **/
+    size_t          size;   /**< size of the allocation                 **/
+};
+
+/** A format string which scan_format() has decided without the arguments **/
+struct seen {
+    const char *    fmt;    /**< where the string was                   **/
+    int             plain;  /**< what scan_format() decided             **/
+    char            text[SEEN_SZ]; /**< copy of the string              **/
+};
+
+/*****************************************************************************/
+/* Private Data.  Declare as static.                                         */
+/*****************************************************************************/
+
+/**
+    The shim is preloaded at startup, so its thread-local data can be
+    reached without a call into the dynamic linker.
+**/
+static __thread struct seen seen[SEEN_N]
+    __attribute__(( tls_model( "initial-exec" ) ));
+
+static int (* real_vfprintf)( FILE *, const char *, va_list );
+static int (* real_vsprintf)( char *, const char *, va_list );
+static int (* real_vsnprintf)( char *, size_t, const char *, va_list );
+static int (* real_vdprintf)( int, const char *, va_list );
+static int (* real_vasprintf)( char * *, const char *, va_list );
+
+static int (* real___vfprintf_chk)( FILE *, int, const char *, va_list );
+static int (* real___vsprintf_chk)( char *, int, size_t, const char *, va_list );
+static int (* real___vsnprintf_chk)( char *, size_t, int, size_t,
+                                     const char *, va_list );
+static int (* real___vdprintf_chk)( int, int, const char *, va_list );
+static int (* real___vasprintf_chk)( char * *, int, const char *, va_list );
+
+/*****************************************************************************/
+/* Public function prototypes.                                               */
+/*****************************************************************************/
+
+/**
+    The C library declares these only for programs built with
+    _FORTIFY_SOURCE, which call them in place of printf() and friends.
+**/
+extern int __printf_chk( int, const char *, ... );
+extern int __vprintf_chk( int, const char *, va_list );
+extern int __fprintf_chk( FILE *, int, const char *, ... );
+extern int __vfprintf_chk( FILE *, int, const char *, va_list );
+extern int __sprintf_chk( char *, int, size_t, const char *, ... );
+extern int __vsprintf_chk( char *, int, size_t, const char *, va_list );
+extern int __snprintf_chk( char *, size_t, int, size_t, const char *, ... );
+extern int __vsnprintf_chk( char *, size_t, int, size_t, const char *, va_list );
+extern int __dprintf_chk( int, int, const char *, ... );
+extern int __vdprintf_chk( int, int, const char *, va_list );
+extern int __asprintf_chk( char * *, int, const char *, ... );
+extern int __vasprintf_chk( char * *, int, const char *, va_list );
+
+/*****************************************************************************/
+/* Private functions.  Declare as static.                                    */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/**
+    Decide if format writes exactly what the C library would.
+
+    Only the integer conversions, %c, %s and %% are taken, with the flags,
+    field widths, precisions and length modifiers of C99.  Everything else
+    -- floating point, %p, %n, positional arguments, wide characters and
+    the GNU extensions -- goes to the C library, as do the corners where
+    format gives a different result: widths or precisions over MAX_WIDTH,
+    any width, precision or flag with %c (a precision is a repeat count in
+    format), the # flag with %s (a ROM string) or with a precision on %o,
+    and a null pointer for %s with a precision under 6, which the C library
+    writes as nothing.
+
+    The format string alone usually decides, so the arguments are only
+    read, from a copy, for a * width or precision or a %s with a precision
+    under 6.
+
+    @param fmt      Format string.
+    @param ap       Arguments.
+    @param walk     Non-zero to read the arguments.
+
+    @return 1 if format is safe to use, 0 if not, or -1 if the arguments
+            are needed to decide and @p walk is zero.
+**/
+static int scan_format( const char * fmt, va_list ap, int walk )
+{
+    va_list aq;
+    int plain = 0;
+
+    if ( walk )
+        va_copy( aq, ap );
+
+    for ( ;; fmt++ )
+    {
+        const char * p;
+        int hash = 0, zero = 0, other = 0;
+        int width = 0, prec = -1;
+        int qual = 0;
+
+        for ( ; *fmt != '%'; fmt++ )
+            if ( *fmt == '\0' )
+                break;
+
+        if ( *fmt == '\0' )
+        {
+            plain = 1;
+            break;
+        }
+        p = fmt + 1;
+
+        for ( ;; p++ )
+        {
+            if      ( *p == '#' ) hash  = 1;
+            else if ( *p == '0' ) zero  = 1;
+            else if ( *p == '+' || *p == ' ' ) other = 1;
+            else if ( *p != '-' ) break;
+        }
+
+        if ( *p == '*' )
+        {
+            if ( !walk )
+            {
+                plain = -1;
+                break;
+            }
+            width = va_arg( aq, int );
+            if ( width < 0 )
+                width = ( width < -MAX_WIDTH ) ? MAX_WIDTH + 1 : -width;
+            p++;
+        }
+        else
+            for ( ; *p >= '0' && *p <= '9'; p++ )
+                width = MIN( width * 10 + ( *p - '0' ), MAX_WIDTH + 1 );
+
+        if ( *p == '.' )
+        {
+            p++;
+            if ( *p == '*' )
+            {
+                if ( !walk )
+                {
+                    plain = -1;
+                    break;
+                }
+                prec = va_arg( aq, int );
+                p++;
+            }
+            else
+                for ( prec = 0; *p >= '0' && *p <= '9'; p++ )
+                    prec = MIN( prec * 10 + ( *p - '0' ), MAX_WIDTH + 1 );
+        }
+
+        if ( width > MAX_WIDTH || prec > MAX_WIDTH )
+            break;
+
+        if ( p[0] == 'h' )
+            qual = 'h', p += ( p[1] == 'h' ) ? 2 : 1;
+        else if ( p[0] == 'l' && p[1] == 'l' )
+            qual = 'q', p += 2;
+        else if ( *p == 'l' || *p == 'j' || *p == 'z' || *p == 't' )
+            qual = *p++;
+
+#if !defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+        if ( qual == 'q' || qual == 'j' )
+            break;
+#endif
+
+        if ( *p == 'd' || *p == 'i' || *p == 'o' || *p == 'u'
+             || *p == 'x' || *p == 'X' )
+        {
+            if ( *p == 'o' && hash && prec >= 0 )
+                break;
+
+            if ( !walk )
+                ;
+            else if ( qual == 'l' ) (void)va_arg( aq, long );
+            else if ( qual == 'q' ) (void)va_arg( aq, long long );
+            else if ( qual == 'j' ) (void)va_arg( aq, intmax_t );
+            else if ( qual == 'z' ) (void)va_arg( aq, size_t );
+            else if ( qual == 't' ) (void)va_arg( aq, ptrdiff_t );
+            else                    (void)va_arg( aq, int );
+        }
+        else if ( *p == 'c' )
+        {
+            if ( qual || hash || zero || other || width || prec >= 0 )
+                break;
+            if ( walk )
+                (void)va_arg( aq, int );
+        }
+        else if ( *p == 's' )
+        {
+            if ( qual || hash )
+                break;
+            if ( prec >= 0 && prec < 6 )
+            {
+                if ( !walk )
+                {
+                    plain = -1;
+                    break;
+                }
+                if ( va_arg( aq, const char * ) == NULL )
+                    break;
+            }
+            else if ( walk )
+                (void)va_arg( aq, const char * );
+        }
+        else if ( *p != '%' || p != fmt + 1 )
+            break;
+
+        fmt = p;
+    }
+
+    if ( walk )
+        va_end( aq );
+    return plain;
+}
+
+/*****************************************************************************/
+/**
+    Decide if format writes exactly what the C library would, reading the
+    arguments only if the format string alone cannot tell.
+
+    A program usually passes the same few format strings over and over, so
+    the decision for each short string is kept, with a copy of the string.
+    Comparing with the copy is much quicker than scanning again, and is
+    still right if the string is in a buffer which has since been changed.
+**/
+static int is_plain( const char * fmt, va_list ap )
+{
+    uintptr_t     key = (uintptr_t)fmt;
+    struct seen * ps  = &seen[( key ^ ( key >> 5 ) ) % SEEN_N];
+    int plain;
+
+    if ( ps->fmt == fmt && strcmp( ps->text, fmt ) == 0 )
+        plain = ps->plain;
+    else
+    {
+        size_t len = strnlen( fmt, SEEN_SZ );
+
+        plain = scan_format( fmt, ap, 0 );
+        if ( len < SEEN_SZ )
+        {
+            memcpy( ps->text, fmt, len + 1 );
+            ps->fmt   = fmt;
+            ps->plain = plain;
+        }
+    }
+
+    return ( plain < 0 ) ? scan_format( fmt, ap, 1 ) : plain;
+}
+
+/*****************************************************************************/
+/**
+    Consumer writing to a stdio stream, which the caller has locked.
+**/
+static void * file_write( void * op, const char * buf, size_t n )
+{
+    FILE * fp = (FILE *)op;
+
+    if ( n == 1 )
+        return putc_unlocked( *buf, fp ) == EOF ? NULL : op;
+
+    return fwrite_unlocked( buf, 1, n, fp ) == n ? op : NULL;
+}
+
+/*****************************************************************************/
+/**
+    Consumer copying into a bounded buffer, silently dropping characters
+    once it is full.
+**/
+static void * bufnwrite( void * op, const char * buf, size_t n )
+{
+    struct nbuf * pnbuf = (struct nbuf *)op;
+    size_t len = MIN( pnbuf->n, n );
+
+    memcpy( pnbuf->ptr, buf, len );
+    pnbuf->ptr += len;
+    pnbuf->n   -= len;
+
+    return op;
+}
+
+/*****************************************************************************/
+/**
+    Write all of @p n characters to a file descriptor.
+
+    @return 0 if successful, or -1 with errno set.
+**/
+static int write_all( int fd, const char * buf, size_t n )
+{
+    while ( n > 0 )
+    {
+        ssize_t done = write( fd, buf, n );
+
+        if ( done < 0 && errno == EINTR )
+            continue;
+        if ( done <= 0 )
+            return -1;
+
+        buf += done;
+        n   -= (size_t)done;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+    Consumer gathering output for a file descriptor into blocks.
+**/
+static void * fdwrite( void * op, const char * buf, size_t n )
+{
+    struct fdbuf * pfd = (struct fdbuf *)op;
+
+    if ( pfd->len + n > sizeof pfd->buf )
+    {
+        if ( write_all( pfd->fd, pfd->buf, pfd->len ) < 0 )
+            return NULL;
+        pfd->len = 0;
+
+        if ( n > sizeof pfd->buf )
+            return write_all( pfd->fd, buf, n ) < 0 ? NULL : op;
+    }
+
+    memcpy( pfd->buf + pfd->len, buf, n );
+    pfd->len += n;
+
+    return op;
+}
+
+/*****************************************************************************/
+/**
+    Consumer appending to allocated memory, always leaving room for the
+    terminating null character.
+**/
+static void * dbufwrite( void * op, const char * buf, size_t n )
+{
+    struct dbuf * pd = (struct dbuf *)op;
+
+    if ( pd->len + n >= pd->size )
+    {
+        size_t size = pd->size ? pd->size : DBUF_MIN;
+        char * p;
+
+        while ( size <= pd->len + n )
+            size *= 2;
+
+        if ( ( p = realloc( pd->ptr, size ) ) == NULL )
+            return NULL;
+        pd->ptr  = p;
+        pd->size = size;
+    }
+
+    memcpy( pd->ptr + pd->len, buf, n );
+    pd->len += n;
+
+    return op;
+}
+
+/*****************************************************************************/
+/**
+    The fast paths, for format strings which pass is_plain().
+**/
+static int file_vprintf( FILE * fp, const char * fmt, va_list ap )
+{
+    int done;
+
+    flockfile( fp );
+    done = format( file_write, fp, fmt, ap );
+    funlockfile( fp );
+
+    return done;
+}
+
+static int buf_vprintf( char * buf, size_t n, const char * fmt, va_list ap )
+{
+    struct nbuf nbuf = { buf, n };
+    int done = format( bufnwrite, &nbuf, fmt, ap );
+
+    if ( done >= 0 && n > 0 )
+        buf[MIN( (size_t)done, n - 1 )] = '\0';
+
+    return done;
+}
+
+static int fd_vprintf( int fd, const char * fmt, va_list ap )
+{
+    struct fdbuf fdbuf;
+    int done;
+
+    fdbuf.fd  = fd;
+    fdbuf.len = 0;
+
+    done = format( fdwrite, &fdbuf, fmt, ap );
+    if ( done >= 0 && write_all( fd, fdbuf.buf, fdbuf.len ) < 0 )
+        done = -1;
+
+    return done;
+}
+
+static int alloc_vprintf( char * * strp, const char * fmt, va_list ap )
+{
+    struct dbuf dbuf = { NULL, 0, 0 };
+    int done = format( dbufwrite, &dbuf, fmt, ap );
+
+    if ( done >= 0 && dbufwrite( &dbuf, "", 0 ) != NULL )
+    {
+        dbuf.ptr[dbuf.len] = '\0';
+        *strp = dbuf.ptr;
+        return done;
+    }
+
+    free( dbuf.ptr );
+    *strp = NULL;
+    return -1;
+}
+
+/*****************************************************************************/
+/* Public functions.  Declared as per header file.                           */
+/*****************************************************************************/
+
+int vfprintf( FILE * fp, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) || fwide( fp, 0 ) > 0 )
+        return REAL( vfprintf )( fp, fmt, ap );
+
+    return file_vprintf( fp, fmt, ap );
+}
+
+int vprintf( const char * fmt, va_list ap )
+{
+    return vfprintf( stdout, fmt, ap );
+}
+
+int vsnprintf( char * buf, size_t n, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) )
+        return REAL( vsnprintf )( buf, n, fmt, ap );
+
+    return buf_vprintf( buf, n, fmt, ap );
+}
+
+int vsprintf( char * buf, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) )
+        return REAL( vsprintf )( buf, fmt, ap );
+
+    return buf_vprintf( buf, SIZE_MAX, fmt, ap );
+}
+
+int vdprintf( int fd, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) )
+        return REAL( vdprintf )( fd, fmt, ap );
+
+    return fd_vprintf( fd, fmt, ap );
+}
+
+int vasprintf( char * * strp, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) )
+        return REAL( vasprintf )( strp, fmt, ap );
+
+    return alloc_vprintf( strp, fmt, ap );
+}
+
+int __vfprintf_chk( FILE * fp, int flag, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) || fwide( fp, 0 ) > 0 )
+        return REAL( __vfprintf_chk )( fp, flag, fmt, ap );
+
+    return file_vprintf( fp, fmt, ap );
+}
+
+int __vprintf_chk( int flag, const char * fmt, va_list ap )
+{
+    return __vfprintf_chk( stdout, flag, fmt, ap );
+}
+
+/**
+    The C library stops the program if @p maxlen is bigger than the buffer
+    really is, so leave that to it.
+**/
+int __vsnprintf_chk( char * buf, size_t maxlen, int flag, size_t slen,
+                     const char * fmt, va_list ap )
+{
+    if ( maxlen > slen || !is_plain( fmt, ap ) )
+        return REAL( __vsnprintf_chk )( buf, maxlen, flag, slen, fmt, ap );
+
+    return buf_vprintf( buf, maxlen, fmt, ap );
+}
+
+/**
+    The output is bounded by the size of the buffer, and if it does not fit
+    the C library is called again to stop the program.
+**/
+int __vsprintf_chk( char * buf, int flag, size_t slen,
+                    const char * fmt, va_list ap )
+{
+    va_list aq;
+    int done;
+
+    if ( slen == 0 || !is_plain( fmt, ap ) )
+        return REAL( __vsprintf_chk )( buf, flag, slen, fmt, ap );
+
+    va_copy( aq, ap );
+    done = buf_vprintf( buf, slen, fmt, aq );
+    va_end( aq );
+
+    if ( done >= 0 && (size_t)done >= slen )
+        return REAL( __vsprintf_chk )( buf, flag, slen, fmt, ap );
+
+    return done;
+}
+
+int __vdprintf_chk( int fd, int flag, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) )
+        return REAL( __vdprintf_chk )( fd, flag, fmt, ap );
+
+    return fd_vprintf( fd, fmt, ap );
+}
+
+int __vasprintf_chk( char * * strp, int flag, const char * fmt, va_list ap )
+{
+    if ( !is_plain( fmt, ap ) )
+        return REAL( __vasprintf_chk )( strp, flag, fmt, ap );
+
+    return alloc_vprintf( strp, fmt, ap );
+}
+
+/*****************************************************************************/
+/**
+    The variadic functions, each passing its arguments on to the va_list
+    function above.
+**/
+#define VA_CALL(call)       do { va_list ap; int done;                      \
+                                 va_start( ap, fmt );                       \
+                                 done = call;                               \
+                                 va_end( ap );                              \
+                                 return done; } while ( 0 )
+
+int printf( const char * fmt, ... )
+{
+    VA_CALL( vfprintf( stdout, fmt, ap ) );
+}
+
+int fprintf( FILE * fp, const char * fmt, ... )
+{
+    VA_CALL( vfprintf( fp, fmt, ap ) );
+}
+
+int sprintf( char * buf, const char * fmt, ... )
+{
+    VA_CALL( vsprintf( buf, fmt, ap ) );
+}
+
+int snprintf( char * buf, size_t n, const char * fmt, ... )
+{
+    VA_CALL( vsnprintf( buf, n, fmt, ap ) );
+}
+
+int dprintf( int fd, const char * fmt, ... )
+{
+    VA_CALL( vdprintf( fd, fmt, ap ) );
+}
+
+int asprintf( char * * strp, const char * fmt, ... )
+{
+    VA_CALL( vasprintf( strp, fmt, ap ) );
+}
+
+int __printf_chk( int flag, const char * fmt, ... )
+{
+    VA_CALL( __vfprintf_chk( stdout, flag, fmt, ap ) );
+}
+
+int __fprintf_chk( FILE * fp, int flag, const char * fmt, ... )
+{
+    VA_CALL( __vfprintf_chk( fp, flag, fmt, ap ) );
+}
+
+int __sprintf_chk( char * buf, int flag, size_t slen, const char * fmt, ... )
+{
+    VA_CALL( __vsprintf_chk( buf, flag, slen, fmt, ap ) );
+}
+
+int __snprintf_chk( char * buf, size_t maxlen, int flag, size_t slen,
+                    const char * fmt, ... )
+{
+    VA_CALL( __vsnprintf_chk( buf, maxlen, flag, slen, fmt, ap ) );
+}
+
+int __dprintf_chk( int fd, int flag, const char * fmt, ... )
+{
+    VA_CALL( __vdprintf_chk( fd, flag, fmt, ap ) );
+}
+
+int __asprintf_chk( char * * strp, int flag, const char * fmt, ... )
+{
+    VA_CALL( __vasprintf_chk( strp, flag, fmt, ap ) );
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
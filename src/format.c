@@ -60,13 +60,13 @@
 /**
     Define the field flags
 **/
-#define FSPACE          ( 0x01U )
-#define FPLUS           ( 0x02U )
-#define FMINUS          ( 0x04U )
-#define FHASH           ( 0x08U )
-#define FZERO           ( 0x10U )
-#define FBANG           ( 0x20U )
-#define FCARET          ( 0x40U )
+#define FSPACE          ( FORMAT_FSPACE )
+#define FPLUS           ( FORMAT_FPLUS )
+#define FMINUS          ( FORMAT_FMINUS )
+#define FHASH           ( FORMAT_FHASH )
+#define FZERO           ( FORMAT_FZERO )
+#define FBANG           ( FORMAT_FBANG )
+#define FCARET          ( FORMAT_FCARET )
 #define F_IS_SIGNED     ( 0x80U )
 
 /**
@@ -78,7 +78,7 @@
     it is certainly convenient!  If this ever changes then we need to review
     this hack and come up with something else.
 **/
-#define DOUBLE_QUAL(q)  ( (q) | 1 )
+#define DOUBLE_QUAL(q)  ( FORMAT_DOUBLE_QUAL(q) )
 
 /**
     Set limits.
@@ -86,6 +86,7 @@
 #define MAXWIDTH        ( 500 )
 #define MAXPREC         ( 500 )
 #define MAXBASE         ( 36 )
+#define MAXPOSARG       ( 16 )   /* Highest positional argument number */
 #define BUFLEN          ( 130 )  /* Must be long enough for 64-bit pointers
                                   * in binary with maximum grouping chars and
                                   * prefix:
@@ -97,6 +98,13 @@
 #define MAX_XP_FRAC     ( (unsigned int)(sizeof(int) * CHAR_BIT) )
 #define MAX_XP_WIDTH    ( (unsigned int)(sizeof(long) * CHAR_BIT) )
 
+/**
+    Length qualifier which makes an integer conversion read a pointer-sized
+    argument, used by the %p conversion.
+**/
+#define PTR_QUAL        ( ( sizeof( void * ) > sizeof( long ) ) ? DOUBLE_QUAL('l') \
+                        : ( sizeof( void * ) > sizeof( int ) )  ? 'l' : 0 )
+
 /**
     Return the maximum/minimum of two scalar values.
 **/
@@ -113,6 +121,71 @@
 **/
 #define ABS(a)          ( (a) < 0 ? -(a) : (a) )
 
+/**
+    All the integer conversions share one handler.  Grouping only applies to
+    them.
+**/
+#if defined(CONFIG_WITH_CONV_D) || defined(CONFIG_WITH_CONV_U) \
+ || defined(CONFIG_WITH_CONV_X) || defined(CONFIG_WITH_CONV_O) \
+ || defined(CONFIG_WITH_CONV_B) || defined(CONFIG_WITH_CONV_P)
+  #define NEED_CONV_NUMERIC
+#else
+  #undef CONFIG_WITH_GROUPING_SUPPORT
+#endif
+
+/**
+    Field widths only apply to conversions which produce a single item.
+**/
+#if defined(NEED_CONV_NUMERIC) || defined(CONFIG_WITH_CONV_S) \
+ || defined(CONFIG_WITH_FP_SUPPORT) || defined(CONFIG_WITH_CONV_T) \
+ || defined(CONFIG_WITH_CONV_Q) || defined(CONFIG_WITH_CONV_NET) \
+ || defined(CONFIG_WITH_CUSTOM_CONV)
+  #define NEED_SPACE_PADDING
+#endif
+
+/**
+    The timestamp and network address conversions write decimal numbers two
+    digits at a time from a table.
+**/
+#if defined(CONFIG_WITH_CONV_T) || defined(CONFIG_WITH_CONV_NET)
+  #define NEED_DIGIT_PAIRS
+#endif
+
+/**
+    The %q conversion finds the runs of characters which need no escaping,
+    and %!s counts UTF-8 code points, a word at a time (SWAR), on hosted
+    machines with at least 32-bit words.  WORD_HAS_ZERO() is non-zero if any
+    byte of word w is zero, and WORD_HAS_LESS() if any byte is less than n
+    (n at most 128).  WORD_SUM() adds up the bytes of w, if the sum is less
+    than 256.
+**/
+#if ( defined(CONFIG_WITH_CONV_Q) || defined(CONFIG_WITH_UTF8) ) \
+ && defined(CONFIG_HAVE_LIBC) && defined(UINTPTR_MAX) && UINTPTR_MAX > 0xFFFFU
+  #define NEED_SWAR
+  #define WORD_ONES           ( (uintptr_t)-1 / 0xFF )
+  #define WORD_HIGHS          ( WORD_ONES * 0x80 )
+  #define WORD_HAS_ZERO(w)    ( ( (w) - WORD_ONES ) & ~(w) & WORD_HIGHS )
+  #define WORD_HAS(w,c)       WORD_HAS_ZERO( (w) ^ ( WORD_ONES * (c) ) )
+  #define WORD_HAS_LESS(w,n)  ( ( (w) - WORD_ONES * (n) ) & ~(w) & WORD_HIGHS )
+  #define WORD_SUM(w)         ( (size_t)( ( (w) * WORD_ONES )                 \
+                                          >> ( 8 * sizeof( uintptr_t ) - 8 ) ) )
+#endif
+
+/**
+    Positional arguments, format_conv() and format_args() pass the arguments
+    to the conversion handlers in a table instead of a va_list.  Positional
+    and typed arguments also need the type each conversion reads.
+**/
+#if defined(CONFIG_WITH_POSITIONAL) || defined(CONFIG_WITH_FORMAT_CONV) \
+ || defined(CONFIG_WITH_TYPED_ARGS) || defined(CONFIG_WITH_TEMPLATE)
+  #define NEED_ARG_TABLE
+#endif
+
+#if defined(CONFIG_WITH_POSITIONAL) || defined(CONFIG_WITH_TYPED_ARGS) \
+ || defined(CONFIG_WITH_TEMPLATE)
+  #define NEED_ARG_TYPES
+#endif
+
 /*****************************************************************************/
 /**
     Some devices have separate memory spaces for normal data and read-only
@@ -165,6 +238,54 @@ enum ptr_mode            { NORMAL_PTR, ALT_PTR };
     #define STRCHR(s,c)     (xx_strchr((s),(c)))
 #endif
 
+/*****************************************************************************/
+/**
+    Keep a function out of line, so that its stack frame is only live while
+    it runs rather than being merged into the frame of its caller.  NOINLINE
+    only does so in the low-stack configuration, OUT_OF_LINE always does.
+**/
+#if defined(__GNUC__)
+    #define OUT_OF_LINE     __attribute__((noinline))
+#else
+    #define OUT_OF_LINE
+#endif
+
+#if defined(CONFIG_LOW_STACK)
+    #define NOINLINE        OUT_OF_LINE
+#else
+    #define NOINLINE
+#endif
+
+/*****************************************************************************/
+/**
+    Storage class for data kept separately by each thread.  Define
+    CONFIG_THREAD_LOCAL to override it, for example as nothing on a
+    single-threaded system whose compiler is not recognised here.
+**/
+#if defined(CONFIG_THREAD_LOCAL)
+    #define THREAD_LOCAL    CONFIG_THREAD_LOCAL
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L \
+   && !defined(__STDC_NO_THREADS__)
+    #define THREAD_LOCAL    _Thread_local
+#elif defined(__GNUC__) && defined(CONFIG_HAVE_LIBC)
+    #define THREAD_LOCAL    __thread
+#else
+    #define THREAD_LOCAL
+#endif
+
+/*****************************************************************************/
+/**
+    Read the next optional argument, of the given type.  With positional
+    arguments, or from format_conv(), it is read from the argument table
+    instead of the va_list.
+**/
+#if defined(NEED_ARG_TABLE)
+    #define ARG(pa,type)    ( (pa)->pos ? *(type const *)(const void *)&(pa)->pos[(pa)->next++] \
+                                        : va_arg( (pa)->ap, type ) )
+#else
+    #define ARG(pa,type)    ( va_arg( (pa)->ap, type ) )
+#endif
+
 /*****************************************************************************/
 /**
     Debugging aids.  Only intended for debugging "format" itself, using
@@ -178,6 +299,19 @@ enum ptr_mode            { NORMAL_PTR, ALT_PTR };
 #define DEBUG_LOG(fmt,val)  ((void)0)
 #endif
 
+/**
+    Step counting, for checking the execution time bounds given in the
+    manual.  A step is one pass of a loop which does not send a character,
+    so the time taken is bounded by the steps plus the characters sent.
+    Only intended for the tests.
+**/
+#ifdef FORMAT_COUNT_STEPS
+unsigned long format_steps;
+#define STEP()              ( format_steps++ )
+#else
+#define STEP()              ((void)0)
+#endif
+
 /*****************************************************************************/
 /* Data types                                                                */
 /*****************************************************************************/
@@ -190,9 +324,13 @@ typedef struct {
     unsigned int    flags;  /**< flags                              **/
     unsigned int    width;  /**< width                              **/
     int             prec;   /**< precision, -1 == default precision **/
+#if defined(CONFIG_WITH_CONV_BASE)
     unsigned int    base;   /**< numeric base                       **/
+#endif
     char            qual;   /**< length qualifier                   **/
+#if defined(CONFIG_WITH_CONV_C)
     char            repchar;/**< Repetition character               **/
+#endif
 #if defined(CONFIG_WITH_GROUPING_SUPPORT)
     struct {
 #if defined(CONFIG_HAVE_ALT_PTR)
@@ -202,7 +340,7 @@ typedef struct {
         size_t        len;  /**< length of grouping spec            **/
     } grouping;
 #endif
-#if defined(CONFIG_WITH_FP_SUPPORT)
+#if defined(CONFIG_WITH_CONV_K)
     struct {
         unsigned int w_int;       /**< fixed-point integer field width    **/
         unsigned int w_frac;      /**< fixed-point fractional field width **/
@@ -210,6 +348,58 @@ typedef struct {
 #endif
 } T_FormatSpec;
 
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+/**
+    State of a right-to-left walk through a grouping specification.
+**/
+typedef struct {
+#if defined(CONFIG_HAVE_ALT_PTR)
+    enum ptr_mode   mode;   /**< grouping spec pointer type         **/
+#endif
+    const void *    ptr;    /**< next grouping spec character       **/
+    size_t          glen;   /**< grouping spec characters remaining **/
+    size_t          wid;    /**< width of current group             **/
+    char            grp;    /**< current grouping character         **/
+} T_GroupWalk;
+#endif
+
+#if defined(NEED_ARG_TABLE)
+/**
+    An entry in the argument table, holding one argument as the type that
+    its conversion will read.  ROM strings are held as the pointer type
+    ROM_PTR_T, in the space of the string pointer.
+**/
+typedef union format_arg T_ArgValue;
+#endif
+
+#if defined(NEED_ARG_TYPES)
+/**
+    Types of the entries in the argument table, as read by the conversions.
+**/
+enum arg_type { ARG_NONE, ARG_INT, ARG_LONG, ARG_LLONG, ARG_INTMAX, ARG_SIZE,
+                ARG_PTRDIFF, ARG_DOUBLE, ARG_PTR, ARG_STR, ARG_ROM };
+#endif
+
+/**
+    The optional arguments.
+**/
+typedef struct {
+    va_list         ap;     /**< arguments, read in order           **/
+#if defined(NEED_ARG_TABLE)
+    const T_ArgValue * pos; /**< argument table, or NULL            **/
+    unsigned int    next;   /**< next entry of pos to read          **/
+#endif
+#if defined(CONFIG_WITH_POSITIONAL)
+    unsigned char * types;  /**< argument types, only when scanning **/
+    unsigned char   numbered; /**< format uses argument numbers     **/
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    const unsigned char * tags; /**< FORMAT_ARG_ type of each entry of
+                                     pos, from format_args(), or NULL **/
+    unsigned int    nargs;  /**< number of entries of pos           **/
+#endif
+} T_Args;
+
 /*****************************************************************************/
 /* Private Data.  Declare as static.                                         */
 /*****************************************************************************/
@@ -221,13 +411,107 @@ typedef struct {
 static const char spaces[] = "                ";
 static const char zeroes[] = "0000000000000000";
 
+#if defined(NEED_DIGIT_PAIRS)
+/**
+    The two digits of each number from 0 to 99.
+**/
+static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+    Write a number from 0 to 99 as two digits.
+**/
+#define PUT_2DIGITS(p,v)    ( (p)[0] = digit_pairs[2 * (v)],                 \
+                              (p)[1] = digit_pairs[2 * (v) + 1] )
+#endif
+
+#if defined(CONFIG_WITH_CONV_T)
+
+/**
+    The date and time last converted by %T, as "YYYY-MM-DDTHH:MM:SS".  A
+    timestamp within the same second is copied from here, and one within the
+    same day only converts the time of day.  Kept per thread.
+**/
+#define TIME_TEXT_LEN       ( 19 )
+static THREAD_LOCAL struct {
+    unsigned long long base;    /* first tick of the cached second      */
+    unsigned long      unit;    /* ticks per second, 0 if nothing cached */
+    long               day;     /* days since 1970-01-01                */
+    char               text[TIME_TEXT_LEN];
+} time_cache;
+#endif
+
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+/**
+    A handler for a custom conversion, registered with format_register().
+**/
+typedef int (* T_CustomConv)( void *(*)(void *, const char *, size_t),
+                              void * *, const struct format_conv *,
+                              const void * );
+
+/**
+    The custom conversion handlers, indexed by conversion letter from 'A' to
+    'z', so a conversion is found with one lookup.  The built-in conversions
+    and the length qualifiers cannot be registered.
+**/
+#define CUSTOM_FIRST        ( 'A' )
+#define CUSTOM_COUNT        ( 'z' - 'A' + 1 )
+#define CUSTOM_CONV(c)      ( (unsigned char)( (c) - CUSTOM_FIRST ) < CUSTOM_COUNT \
+                              ? custom_conv[(unsigned char)( (c) - CUSTOM_FIRST )] \
+                              : NULL )
+static T_CustomConv custom_conv[CUSTOM_COUNT];
+static const char builtin_conv[] = "cCsqndiIuUxXobeEfFgGaAkTNMphljztL";
+#endif
+
 /*****************************************************************************/
 /* Private function prototypes.  Declare as static.                          */
 /*****************************************************************************/
 
-static int do_conv( T_FormatSpec *, va_list *, char,
+static int parse_spec( T_FormatSpec *, T_Args *, const void * *,
+                       enum ptr_mode );
+static int do_format( void *(*)(void *, const char *, size_t), void *,
+                      const char *, T_Args * );
+
+static int do_conv( T_FormatSpec *, T_Args *, char,
                     void *(*)(void *, const char *, size_t), void * * );
 
+static int get_star( T_Args *, const void * *, int * );
+
+#if defined(NEED_ARG_TYPES)
+static unsigned char arg_type( T_FormatSpec *, char );
+#endif
+
+#if defined(CONFIG_WITH_POSITIONAL) || defined(CONFIG_WITH_TEMPLATE)
+static int get_arg( T_Args *, unsigned char, T_ArgValue * );
+#endif
+
+#if defined(CONFIG_WITH_FORMAT_CONV) || defined(CONFIG_WITH_TEMPLATE) \
+ || defined(CONFIG_WITH_CUSTOM_CONV)
+static void set_spec( T_FormatSpec *, const struct format_conv * );
+#endif
+
+#if defined(CONFIG_WITH_TEMPLATE) || defined(CONFIG_WITH_CUSTOM_CONV)
+static void get_spec( struct format_conv *, T_FormatSpec *, char );
+#endif
+
+#if defined(CONFIG_WITH_TYPED_ARGS)
+static int typed_check( T_Args *, unsigned int, unsigned char );
+static int typed_conv( T_FormatSpec *, T_Args *, char );
+#endif
+
+#if defined(CONFIG_WITH_POSITIONAL)
+static int is_positional( const char * );
+static int get_argn( const void * * );
+static int set_type( T_Args *, int, unsigned char );
+static int scan_conv( T_FormatSpec *, T_Args *, char, int );
+static OUT_OF_LINE int do_positional( void *(*)(void *, const char *, size_t),
+                                   void *, const char *, T_Args * );
+#endif
+
 static int emit( const char *, size_t,
                  void * (*)(void *, const char *, size_t ), void * * );
 
@@ -238,7 +522,9 @@ static int gen_out( void *(*)(void *, const char *, size_t), void * *,
                     size_t, const char *, size_t, size_t,
                     const char *, size_t, size_t );
 
+#if defined(NEED_SPACE_PADDING)
 static void calc_space_padding( T_FormatSpec *, size_t, size_t *, size_t * );
+#endif
 
 /* Only declare these prototypes in a freestanding environment */
 #if !defined(CONFIG_HAVE_LIBC)
@@ -251,17 +537,72 @@ static void * memcpy( void *, const void *, size_t );
 #endif
 
 /** Conversion handlers **/
-static int do_conv_n( T_FormatSpec *, va_list * );
+#if defined(CONFIG_WITH_CONV_N)
+static int do_conv_n( T_FormatSpec *, T_Args * );
+#endif
+
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+static int do_conv_custom( T_FormatSpec *, T_Args *, char,
+                           void *(*)(void *, const char *, size_t), void * * );
+#endif
 
-static int do_conv_c( T_FormatSpec *, va_list *, char,
+#if defined(CONFIG_WITH_CONV_C)
+static int do_conv_c( T_FormatSpec *, T_Args *, char,
                       void * (*)(void *, const char *, size_t), void * * );
+#endif
+
+#if defined(CONFIG_WITH_CONV_T)
+static int do_conv_t( T_FormatSpec *, T_Args *,
+                      void *(*)(void *, const char *, size_t), void * * );
+#endif
+
+#if defined(CONFIG_WITH_CONV_NET)
+static char * put_octet( char *, unsigned int );
+static char * put_ipv6( char *, const unsigned char * );
+static int do_conv_net( T_FormatSpec *, T_Args *, char,
+                        void *(*)(void *, const char *, size_t), void * * );
+#endif
 
-static int do_conv_s( T_FormatSpec *, va_list *,
+#if defined(CONFIG_WITH_CONV_Q)
+static size_t quote_span( const char *, size_t, unsigned int );
+static size_t quote_escape( char, unsigned int, char * );
+static int do_conv_q( T_FormatSpec *, T_Args *,
+                      void *(*)(void *, const char *, size_t), void * * );
+#endif
+
+#if defined(CONFIG_WITH_CONV_S)
+static int do_conv_s( T_FormatSpec *, T_Args *,
                       void * (*)(void *, const char *, size_t), void * * );
+#endif
+
+#if defined(CONFIG_WITH_UTF8)
+static size_t utf8_span( const char *, size_t, size_t, size_t * );
+#endif
+
+#if defined(CONFIG_WITH_WIDE_CHARS)
+static size_t utf8_encode( char *, unsigned long );
+#endif
+
+#if defined(CONFIG_WITH_WIDE_CHARS) && defined(CONFIG_WITH_CONV_S)
+static size_t wide_step( const wchar_t * *, char *, size_t *, int );
+static int do_conv_ls( T_FormatSpec *, T_Args *,
+                       void * (*)(void *, const char *, size_t), void * * );
+#endif
 
-static int do_conv_numeric( T_FormatSpec *, va_list *, char,
+#if defined(NEED_CONV_NUMERIC)
+static int do_conv_numeric( T_FormatSpec *, T_Args *, char,
                             void * (*)(void *, const char *, size_t), void * *,
                             unsigned int );
+#endif
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+static void grp_start( T_GroupWalk *, T_FormatSpec * );
+static int grp_next( T_GroupWalk *, T_Args * );
+#if defined(CONFIG_LOW_STACK)
+static NOINLINE size_t grp_find( T_FormatSpec *, T_Args *, size_t, char *,
+                                 size_t *, int );
+#endif
+#endif
 
 /*****************************************************************************/
 /* Private functions.  Declare as static.                                    */
@@ -329,12 +670,24 @@ static char * xx_strchr( const char *s, int c )
     @param cons     Pointer to consumer function
     @param parg     Pointer to opaque pointer arg for @p cons
 
+    When built by format_inline.h with FORMAT_SINK defined, that consumer
+    is called by name so that it can be inlined.  Any other consumer, such
+    as the one format_template_init() stores into the template, is still
+    called through @p cons.
+
     @return 0 if successful, or EXBADFORMAT if failed.
 **/
 static int emit( const char *s, size_t n,
                  void * (* cons)(void *, const char *, size_t), void * * parg )
 {
-    if ( ( *parg = ( *cons )( *parg, s, n ) ) == NULL )
+#if defined(FORMAT_SINK)
+    if ( cons == FORMAT_SINK )
+        *parg = FORMAT_SINK( *parg, s, n );
+    else
+#endif
+        *parg = ( *cons )( *parg, s, n );
+
+    if ( *parg == NULL )
         return EXBADFORMAT;
     else
         return 0;
@@ -415,6 +768,7 @@ static int gen_out( void *(*cons)(void *, const char *, size_t), void * * parg,
     return (int)n;
 }
 
+#if defined(NEED_SPACE_PADDING)
 /*****************************************************************************/
 /**
     Calculate the left and right space padding amount.
@@ -449,6 +803,7 @@ static void calc_space_padding( T_FormatSpec * pspec,
     if ( ps1 ) *ps1 = left;
     if ( ps2 ) *ps2 = right;
 }
+#endif
 
 /*****************************************************************************/
 /**
@@ -459,6 +814,18 @@ static void calc_space_padding( T_FormatSpec * pspec,
 #include "format_fp.c"
 #endif
 
+/**
+    The scanner shares the format specification parser, so is built here.
+**/
+#if defined(CONFIG_WITH_SCAN)
+#include "format_scan.c"
+#endif
+
+#if defined(CONFIG_WITH_TEMPLATE)
+#include "format_template.c"
+#endif
+
+#if defined(CONFIG_WITH_CONV_N)
 /*****************************************************************************/
 /**
     Process a %n conversion.
@@ -469,9 +836,9 @@ static void calc_space_padding( T_FormatSpec * pspec,
     @return 0 as no characters are emitted.
 **/
 static int do_conv_n( T_FormatSpec * pspec,
-                      va_list *      ap )
+                      T_Args *       ap )
 {
-    void *vp = va_arg( *ap, void * );
+    void *vp = ARG( ap, void * );
 
     if ( vp )
     {
@@ -496,7 +863,9 @@ static int do_conv_n( T_FormatSpec * pspec,
     }
     return 0;
 }
+#endif
 
+#if defined(CONFIG_WITH_CONV_C)
 /*****************************************************************************/
 /**
     Process the %c and %C conversions.
@@ -510,19 +879,28 @@ static int do_conv_n( T_FormatSpec * pspec,
     @return Number of emitted characters, or EXBADFORMAT if failure
 **/
 static int do_conv_c( T_FormatSpec * pspec,
-                      va_list *      ap,
+                      T_Args *       ap,
                       char           code,
                       void *      (* cons)(void *, const char *, size_t),
                       void * *       parg )
 {
-    char cc;
+    char cc[4];
+    size_t len = 1;
     int n = 0;
     unsigned int rep;
 
     if ( code == 'c' )
-        cc = (char)va_arg( *ap, int );
+    {
+#if defined(CONFIG_WITH_WIDE_CHARS)
+        /* wint_t is int or unsigned int, either of which reads as unsigned */
+        if ( pspec->qual == 'l' )
+            len = utf8_encode( cc, ARG( ap, unsigned int ) );
+        else
+#endif
+            cc[0] = (char)ARG( ap, int );
+    }
     else
-        cc = pspec->repchar;
+        cc[0] = pspec->repchar;
 
     /* apply default precision */
     if ( pspec->prec < 0 )
@@ -532,7 +910,7 @@ static int do_conv_c( T_FormatSpec * pspec,
 
     for ( ; rep > 0; rep-- )
     {
-        int r = gen_out( cons, parg, 0, NULL, 0, 0, &cc, 1, 0 );
+        int r = gen_out( cons, parg, 0, NULL, 0, 0, cc, len, 0 );
         if ( r == EXBADFORMAT )
             return EXBADFORMAT;
         n += r;
@@ -540,10 +918,13 @@ static int do_conv_c( T_FormatSpec * pspec,
 
     return n;
 }
+#endif
 
+#if defined(CONFIG_WITH_CONV_S)
 /*****************************************************************************/
 /**
-    Process a %s conversion.
+    Process a %s conversion.  With the '!' flag the width and precision count
+    UTF-8 code points rather than bytes.
 
     @param pspec    Pointer to format specification.
     @param ap       Reference to optional format arguments list.
@@ -554,439 +935,2360 @@ static int do_conv_c( T_FormatSpec * pspec,
     @return Number of emitted characters, or EXBADFORMAT if failure
 **/
 static int do_conv_s( T_FormatSpec * pspec,
-                      va_list *      ap,
+                      T_Args *       ap,
                       void *      (* cons)(void *, const char *, size_t),
                       void * *       parg )
 {
     size_t length = 0;
     size_t ps1 = 0, ps2 = 0;
 
-    const char *s = va_arg( *ap, const char * );
+    size_t chars;
+
+    const char *s = ARG( ap, const char * );
 
     if ( s == NULL )
         s = "(null)";
 
     length = STRLEN( s );
-    if ( pspec->prec >= 0 )
-        length = (size_t)MIN( pspec->prec, (int)length );
 
-    calc_space_padding( pspec, length, &ps1, &ps2 );
+#if defined(CONFIG_WITH_UTF8)
+    if ( pspec->flags & FBANG )
+        length = utf8_span( s, length, pspec->prec >= 0 ? (size_t)pspec->prec
+                                                        : (size_t)-1, &chars );
+    else
+#endif
+    {
+        if ( pspec->prec >= 0 )
+            length = (size_t)MIN( pspec->prec, (int)length );
+        chars = length;
+    }
+
+    calc_space_padding( pspec, chars, &ps1, &ps2 );
 
     return gen_out( cons, parg, ps1, NULL, 0, 0, s, length, ps2 );
 }
+#endif
 
+#if defined(CONFIG_WITH_UTF8)
 /*****************************************************************************/
 /**
-    Process a %s conversion that uses the alternate pointer type.
+    Measure the start of a UTF-8 string, counting code points and bytes in
+    one pass.  Every byte except the continuation bytes 10xxxxxx starts a
+    code point.  The measure stops before the code point after the last one
+    wanted, so a string is never cut inside a character.  Where the rest of
+    a word cannot hold the last code point wanted, it is counted a word at a
+    time.
 
-    We split out the alternate functionality into a separate function so that
-    platforms that do not have this behaviour are not unduly loaded with
-    additional code, and it helps keep the main code cleaner.
+    @param s        Pointer to string.
+    @param n        Length of string in bytes.
+    @param max      Maximum number of code points.
+    @param pcp      Pointer to number of code points measured.
+
+    @return Number of bytes measured.
+**/
+static size_t utf8_span( const char * s, size_t n, size_t max, size_t * pcp )
+{
+    size_t i = 0, cp = 0;
+
+#if defined(NEED_SWAR)
+    for ( ; n - i >= sizeof( uintptr_t ) && max - cp > sizeof( uintptr_t );
+            i += sizeof( uintptr_t ) )
+    {
+        uintptr_t w;
+
+        memcpy( &w, s + i, sizeof( w ) );
+        cp += sizeof( w ) - WORD_SUM( ( w & ~( w << 1 ) & WORD_HIGHS ) >> 7 );
+    }
+#endif
+
+    for ( ; i < n; i++ )
+        if ( ( s[i] & 0xC0 ) != 0x80 )
+        {
+            if ( cp == max )
+                break;
+            cp++;
+        }
+
+    *pcp = cp;
+    return i;
+}
+#endif
+
+#if defined(CONFIG_WITH_WIDE_CHARS)
+/*****************************************************************************/
+/**
+    Encode a code point as UTF-8.  Surrogates and values beyond U+10FFFF,
+    which have no encoding, are replaced by U+FFFD.
+
+    @param p        Pointer to output buffer, of at least 4 characters.
+    @param c        Code point.
+
+    @return Number of bytes written.
+**/
+static size_t utf8_encode( char * p, unsigned long c )
+{
+    if ( c < 0x80 )
+    {
+        p[0] = (char)c;
+        return 1;
+    }
+    if ( c < 0x800 )
+    {
+        p[0] = (char)( 0xC0 | c >> 6 );
+        p[1] = (char)( 0x80 | ( c & 0x3F ) );
+        return 2;
+    }
+    if ( ( c >= 0xD800 && c < 0xE000 ) || c > 0x10FFFF )
+        c = 0xFFFD;
+    if ( c < 0x10000 )
+    {
+        p[0] = (char)( 0xE0 | c >> 12 );
+        p[1] = (char)( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+        p[2] = (char)( 0x80 | ( c & 0x3F ) );
+        return 3;
+    }
+    p[0] = (char)( 0xF0 | c >> 18 );
+    p[1] = (char)( 0x80 | ( ( c >> 12 ) & 0x3F ) );
+    p[2] = (char)( 0x80 | ( ( c >> 6 ) & 0x3F ) );
+    p[3] = (char)( 0x80 | ( c & 0x3F ) );
+    return 4;
+}
+#endif
+
+#if defined(CONFIG_WITH_WIDE_CHARS) && defined(CONFIG_WITH_CONV_S)
+/*****************************************************************************/
+/**
+    Encode the next character of a wide string as UTF-8, if it fits in what
+    is left of the precision.  Where wchar_t is 16 bits the string is taken
+    to be UTF-16, so a surrogate pair makes one character.
+
+    @param pws      Pointer to wide string pointer, advanced past the character.
+    @param p        Pointer to output buffer, of at least 4 characters.
+    @param pleft    Pointer to remaining precision, reduced by the character.
+    @param chars    Non-zero to count the precision in characters, not bytes.
+
+    @return Number of bytes written, or 0 at the end of the string or the
+            precision.
+**/
+static size_t wide_step( const wchar_t * * pws,
+                         char *            p,
+                         size_t *          pleft,
+                         int               chars )
+{
+    const wchar_t *w = *pws;
+    unsigned long c = (unsigned long)*w++;
+    size_t n;
+
+    if ( c == 0 )
+        return 0;
+
+#if WCHAR_MAX <= 0xFFFF
+    if ( c >= 0xD800 && c < 0xDC00 && *w >= 0xDC00 && *w < 0xE000 )
+        c = 0x10000 + ( ( c - 0xD800 ) << 10 ) + ( (unsigned long)*w++ - 0xDC00 );
+#endif
+
+    n = utf8_encode( p, c );
+    if ( ( chars ? 1 : n ) > *pleft )
+        return 0;
+
+    *pleft -= chars ? 1 : n;
+    *pws = w;
+    return n;
+}
+
+/*****************************************************************************/
+/**
+    Process a %ls conversion: a wide string, written as UTF-8.  The precision
+    and field width count bytes, or characters with the '!' flag, and a
+    character is never split.  The string is encoded into a small block which
+    is sent to the consumer function each time it fills, and it is only
+    measured first when there is a field width to pad.
 
     @param pspec    Pointer to format specification.
     @param ap       Reference to optional format arguments list.
-    @param code     Conversion specifier code.
     @param cons     Pointer to consumer function.
     @param parg     Pointer to opaque pointer updated by cons.
 
     @return Number of emitted characters, or EXBADFORMAT if failure
 **/
-
-#if defined(CONFIG_HAVE_ALT_PTR)
-static int do_conv_s_alt( T_FormatSpec * pspec,
-                          va_list *      ap,
-                          char           code,
-                          void *      (* cons)(void *, const char *, size_t),
-                          void * *       parg )
+static int do_conv_ls( T_FormatSpec * pspec,
+                       T_Args *       ap,
+                       void *      (* cons)(void *, const char *, size_t),
+                       void * *       parg )
 {
-    size_t length = 0;
+    char buf[32];
+    int chars = ( pspec->flags & FBANG ) != 0;
+    size_t max = pspec->prec >= 0 ? (size_t)pspec->prec : (size_t)-1;
+    size_t left = max, total = 0, i = 0, n;
     size_t ps1 = 0, ps2 = 0;
-    size_t n = 0;
-    static ROM_DECL(char const null_string[]) = "(null)";
 
-    const void *vp = (const void*)va_arg( *ap, ROM_PTR_T );
+    const wchar_t *ws = ARG( ap, const wchar_t * );
 
-    if ( vp == NULL )
-        vp = null_string;
+    if ( ws == NULL )
+        ws = L"(null)";
 
-    length = STRLEN_ALT( (ROM_PTR_T)vp);
-    if ( pspec->prec >= 0 )
-        length = MIN( pspec->prec, length );
+    if ( pspec->width )
+    {
+        const wchar_t *w = ws;
 
-    calc_space_padding( pspec, length, &ps1, &ps2 );
+        while ( ( n = wide_step( &w, buf, &left, chars ) ) != 0 )
+            total += chars ? 1 : n;
+        left = max;
+    }
+
+    calc_space_padding( pspec, total, &ps1, &ps2 );
 
-    /* Inline the relevant parts of gen_out() here as we need to handle
-     *  alternate memory pointers.
-     */
     if ( ps1 && pad( spaces, ps1, cons, parg ) < 0 )
         return EXBADFORMAT;
-    n += ps1;
 
-    while ( length-- )
+    for ( total = 0; ; i = 0 )
     {
-        char c = ROM_CHAR(vp++);
-        if ( emit( &c, 1, cons, parg ) < 0 )
+        while ( i <= sizeof( buf ) - 4
+             && ( n = wide_step( &ws, buf + i, &left, chars ) ) != 0 )
+            i += n;
+        if ( i && emit( buf, i, cons, parg ) < 0 )
             return EXBADFORMAT;
-        n++;
+        total += i;
+        if ( i <= sizeof( buf ) - 4 )
+            break;
     }
 
     if ( ps2 && pad( spaces, ps2, cons, parg ) < 0 )
         return EXBADFORMAT;
-    n += ps2;
 
-    return (int)n;
+    return (int)( ps1 + total + ps2 );
 }
 #endif
 
+#if defined(CONFIG_WITH_CONV_T)
 /*****************************************************************************/
 /**
-    Process the numeric conversions (%b, %d, %i, %I, %o, %u, %U, %x, %X).
+    Process a %T conversion: a long long count of ticks since the Unix
+    epoch, 1970-01-01T00:00:00Z, as an ISO-8601 (RFC 3339) UTC timestamp.
+    The base modifier gives the number of decimal digits of a second in a
+    tick, from 2 to 9 (nanoseconds, the default), and the precision the
+    number of digits of the fraction of a second to print, none by default.
 
     @param pspec    Pointer to format specification.
     @param ap       Reference to optional format arguments list.
-    @param code     Conversion specifier code.
     @param cons     Pointer to consumer function.
     @param parg     Pointer to opaque pointer updated by cons.
 
     @return Number of emitted characters, or EXBADFORMAT if failure
 **/
-static int do_conv_numeric( T_FormatSpec * pspec,
-                            va_list *      ap,
-                            char           code,
-                            void *      (* cons)(void *, const char *, size_t),
-                            void * *       parg,
-                            unsigned int base )
+static int do_conv_t( T_FormatSpec * pspec,
+                      T_Args *       ap,
+                      void *      (* cons)(void *, const char *, size_t),
+                      void * *       parg )
 {
+    char buf[11];                   /* '.', 9 digits and 'Z' */
+    long long t = ARG( ap, long long );
+    unsigned long unit = 1000000000UL;
+    unsigned long frac;
     size_t length = 0;
-    size_t numWidth, digitWidth;
-    char numBuffer[BUFLEN];
-    size_t ps1 = 0, ps2 = 0, pz = 0, pfx_n = 0;
-    const char * pfx_s = NULL;
-#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
-#define T long long
-#else
-#define T long
-#endif
-    unsigned T uv;
-    char prefix[2];
-    size_t pfxWidth = 0;
-    size_t grp_insertions = 0;
-    static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-    /* Get the value.
-     * Signed values need special handling for negative values and the
-     *  extra options for sign output which don't apply to the unsigned
-     *  values.
-     */
-    if ( pspec->flags & F_IS_SIGNED )
-    {
-        T v;
+    size_t ps1 = 0, ps2 = 0;
+    size_t i;
 
-#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
-        if ( pspec->qual == DOUBLE_QUAL( 'l' ) )
-            v = (T)va_arg( *ap, T );
-        else
+#if defined(CONFIG_WITH_CONV_BASE)
+    if ( pspec->base == 1 || pspec->base > 9 )
+        return EXBADFORMAT;
+    for ( i = pspec->base; i > 0 && i < 9; i++ )
+        unit /= 10;
 #endif
-        if ( pspec->qual == 'l' )
-            v = (T)va_arg( *ap, long );
-        else if ( pspec->qual == 'j' )
-            v = (T)va_arg( *ap, intmax_t );
-        else if ( pspec->qual == 'z' )
-            v = (T)va_arg( *ap, size_t );
-        else if ( pspec->qual == 't' )
-            v = (T)va_arg( *ap, ptrdiff_t );
-        else
-            v = (T)va_arg( *ap, int );
-
-        if ( pspec->qual == 'h' )
-            v = (short)v;
-        if ( pspec->qual == DOUBLE_QUAL( 'h' ) )
-            v = (signed char)v;
 
-        /* Get absolute value */
-        uv = (unsigned T)(v < 0 ? -v : v);
-
-        /* Based on original sign and flags work out any prefix */
-        prefix[0] = '\0';
-        if ( v < 0 )
-            prefix[0]     = '-';
-        else if ( pspec->flags & FPLUS )
-            prefix[0]     = '+';
-        else if ( pspec->flags & FSPACE )
-            prefix[0]     = ' ';
+    /* A timestamp in the cached second only needs its fraction */
+    if ( time_cache.unit != unit
+      || (unsigned long long)t - time_cache.base >= unit )
+    {
+        long long secs = t / (long long)unit;
+        long day, sod;
+
+        if ( t % (long long)unit < 0 )
+            secs--;
+        day = (long)( secs / 86400 );
+        sod = (long)( secs % 86400 );
+        if ( sod < 0 )
+        {
+            sod += 86400;
+            day--;
+        }
 
-        if ( prefix[0] != '\0' )
+        /* A new day: convert the date, from Howard Hinnant's civil_from_days() */
+        if ( time_cache.unit != unit || time_cache.day != day )
         {
-            pfxWidth      = 1;
-            pspec->flags |= FHASH;
+            long z   = day + 719468L;
+            long era = ( z >= 0 ? z : z - 146096L ) / 146097L;
+            long doe = z - era * 146097L;
+            long yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+            long doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+            long mp  = ( 5 * doy + 2 ) / 153;
+            long y   = yoe + era * 400 + ( mp >= 10 );
+
+            if ( y < 0 || y > 9999 )
+            {
+                time_cache.unit = 0;
+                return EXBADFORMAT;
+            }
+
+            PUT_2DIGITS( time_cache.text, y / 100 );
+            PUT_2DIGITS( time_cache.text + 2, y % 100 );
+            time_cache.text[4] = '-';
+            PUT_2DIGITS( time_cache.text + 5, mp < 10 ? mp + 3 : mp - 9 );
+            time_cache.text[7] = '-';
+            PUT_2DIGITS( time_cache.text + 8, doy - ( 153 * mp + 2 ) / 5 + 1 );
+            time_cache.text[10] = 'T';
+            time_cache.text[13] = ':';
+            time_cache.text[16] = ':';
+            time_cache.day = day;
         }
+
+        PUT_2DIGITS( time_cache.text + 11, sod / 3600 );
+        PUT_2DIGITS( time_cache.text + 14, sod / 60 % 60 );
+        PUT_2DIGITS( time_cache.text + 17, sod % 60 );
+        time_cache.base = (unsigned long long)secs * unit;
+        time_cache.unit = unit;
     }
-    else
+
+    if ( pspec->prec > 0 )
     {
-#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
-        if ( pspec->qual == DOUBLE_QUAL( 'l' ) )
-            uv = (unsigned T)va_arg( *ap, unsigned T );
-        else
+        /* fraction of a second, in nanoseconds, as 9 digits */
+        frac = (unsigned long)( (unsigned long long)t - time_cache.base )
+               * ( 1000000000UL / unit );
+
+        buf[length++] = '.';
+        for ( i = 9; i > 1; i -= 2, frac /= 100 )
+            PUT_2DIGITS( buf + length + i - 2, frac % 100 );
+        buf[length] = (char)( '0' + frac );
+        length += (size_t)MIN( pspec->prec, 9 );
+    }
+    buf[length++] = 'Z';
+
+    calc_space_padding( pspec, TIME_TEXT_LEN + length, &ps1, &ps2 );
+
+    /* the date and time go straight from the cache, as the prefix */
+    return gen_out( cons, parg, ps1, time_cache.text, TIME_TEXT_LEN, 0,
+                    buf, length, ps2 );
+}
 #endif
-        if ( pspec->qual == 'l' )
-            uv = (unsigned T)va_arg( *ap, unsigned long );
-        else if ( pspec->qual == 'j' )
-            uv = (unsigned T)va_arg( *ap, uintmax_t );
-        else if ( pspec->qual == 'z' )
-            uv = (unsigned T)va_arg( *ap, size_t );
-        else if ( pspec->qual == 't' )
-            uv = (unsigned T)va_arg( *ap, ptrdiff_t );
-        else
-            uv = (unsigned T)va_arg( *ap, unsigned int );
 
-        if ( pspec->qual == 'h' )
-            uv = (unsigned short)uv;
-        if ( pspec->qual == DOUBLE_QUAL( 'h' ) )
-            uv = (unsigned char)uv;
+#if defined(CONFIG_WITH_CONV_NET)
+/*****************************************************************************/
+/**
+    Write a number from 0 to 255 in decimal, without leading zeros.
 
-        prefix[0] = '0';
+    @param p        Pointer to output buffer.
+    @param v        Value to write.
+
+    @return Pointer past the digits written.
+**/
+static char * put_octet( char * p, unsigned int v )
+{
+    if ( v >= 100 )
+    {
+        *p++ = (char)( '0' + v / 100 );
+        PUT_2DIGITS( p, v % 100 );
+        return p + 2;
+    }
+    if ( v >= 10 )
+    {
+        PUT_2DIGITS( p, v );
+        return p + 2;
     }
+    *p++ = (char)( '0' + v );
+    return p;
+}
 
-    if ( code == 'o' && uv )
-        pfxWidth = 1;
+/*****************************************************************************/
+/**
+    Write an IPv6 address in the text form of RFC 5952: lower case hex
+    groups without leading zeros, with the longest run of two or more zero
+    groups (the first, if there are several) replaced by "::".  IPv4-mapped
+    addresses end in dotted decimal.
 
-    if ( code == 'x' || code == 'X' || code == 'b' )
+    @param p        Pointer to output buffer, of at least 39 characters.
+    @param a        Pointer to the 16 bytes of the address.
+
+    @return Pointer past the characters written.
+**/
+#define GROUP(a,i)      ( (unsigned int)(a)[2 * (i)] << 8 | (a)[2 * (i) + 1] )
+
+static char * put_ipv6( char * p, const unsigned char * a )
+{
+    static const char hex[] = "0123456789abcdef";
+    int best = -1, bestlen = 1;
+    int i, j;
+
+    for ( i = 0; i < 8; i = j + 1 )
     {
-        /* if non-zero or bang flag, add prefix for hex and binary */
-        if ( ( pspec->flags & FBANG ) || uv )
+        for ( j = i; j < 8 && GROUP( a, j ) == 0; j++ )
+            ;
+        if ( j - i > bestlen )
         {
-            prefix[1] = code;
-            pfxWidth  = 2;
+            best    = i;
+            bestlen = j - i;
         }
-
-        /* Bang flag forces lower-case */
-        if ( pspec->flags & FBANG )
-            prefix[1] |= 0x20;
     }
 
-    if ( pspec->flags & FHASH )
+    /* ::ffff:a.b.c.d */
+    if ( best == 0 && bestlen == 5 && GROUP( a, 5 ) == 0xFFFF )
     {
-        length += pfxWidth;
-        pfx_s = prefix;
-        pfx_n = pfxWidth;
+        for ( i = 0; i < 7; i++ )
+            *p++ = "::ffff:"[i];
+        for ( i = 12; i < 16; i++ )
+        {
+            p = put_octet( p, a[i] );
+            *p++ = '.';
+        }
+        return p - 1;
     }
 
-    /* work out how many digits in uv */
-    for ( numWidth = 0; uv > 0; uv /= base )
+    for ( i = 0; i < 8; i++ )
     {
-        char cc = digits[uv % base];
+        unsigned int g = GROUP( a, i );
+        int shift;
 
-        /* convert to lower case? */
-        if ( code == 'x' || code == 'i' || code == 'u' )
-            cc |= 0x20;
-
-        ++numWidth;
-        numBuffer[sizeof(numBuffer) - numWidth] = cc;
+        if ( i >= best && i < best + bestlen )
+        {
+            if ( i == best )
+                *p++ = ':';
+            continue;
+        }
+        if ( i != 0 )
+            *p++ = ':';
+        for ( shift = 12; shift > 0 && !( g >> shift ); shift -= 4 )
+            ;
+        for ( ; shift >= 0; shift -= 4 )
+            *p++ = hex[( g >> shift ) & 0xF];
     }
+    if ( best + bestlen == 8 )
+        *p++ = ':';
 
-#if defined(CONFIG_WITH_GROUPING_SUPPORT)
-    if ( pspec->grouping.len )
+    return p;
+}
+
+/*****************************************************************************/
+/**
+    Process the %N and %M network address conversions.  %N takes an IPv4
+    address as a uint32_t in network byte order, and %#N a pointer to the 16
+    bytes of an IPv6 address.  %M takes a pointer to the 6 bytes of a MAC
+    address.  Each address is built in a buffer and sent as one string.
+
+    @param pspec    Pointer to format specification.
+    @param ap       Reference to optional format arguments list.
+    @param code     Conversion specifier code.
+    @param cons     Pointer to consumer function.
+    @param parg     Pointer to opaque pointer updated by cons.
+
+    @return Number of emitted characters, or EXBADFORMAT if failure
+**/
+static int do_conv_net( T_FormatSpec * pspec,
+                        T_Args *       ap,
+                        char           code,
+                        void *      (* cons)(void *, const char *, size_t),
+                        void * *       parg )
+{
+    static const char hex[] = "0123456789ABCDEF";
+    char buf[40];
+    char *p = buf;
+    const char *s = buf;
+    size_t length, ps1 = 0, ps2 = 0;
+    int i;
+
+    if ( code == 'N' && !( pspec->flags & FHASH ) )
     {
-#if defined(CONFIG_HAVE_ALT_PTR)
-        enum ptr_mode mode  = pspec->grouping.mode;
-#endif
-        const void *  ptr   = pspec->grouping.ptr;
-        size_t        glen  = pspec->grouping.len;
-        char          grp   = 0;
-        size_t        wid   = 0;
-        unsigned int  decade;
-        size_t        d_rem = numWidth;
-        size_t        idx   = sizeof(numBuffer) - numWidth;
-        size_t        s, n;
+        /* the bytes of the address are in memory order */
+        union { uint32_t v; unsigned char b[4]; } ip;
 
-        MOVE_VOID_PTR( ptr, glen - 1 );
+        ip.v = ARG( ap, uint32_t );
+        for ( i = 0; i < 4; i++ )
+        {
+            p = put_octet( p, ip.b[i] );
+            *p++ = '.';
+        }
+        length = (size_t)( p - 1 - buf );
+    }
+    else
+    {
+        const unsigned char *a = ARG( ap, const unsigned char * );
 
-        while ( d_rem )
+        if ( a == NULL )
+            s = "(null)";
+        else if ( code == 'N' )
+            p = put_ipv6( p, a );
+        else
         {
-            if ( glen )
+            for ( i = 0; i < 6; i++ )
             {
-                grp = READ_CHAR( mode, ptr );
+                *p++ = hex[a[i] >> 4];
+                *p++ = hex[a[i] & 0xF];
+                *p++ = ':';
+            }
+            p--;
+        }
+        length = a ? (size_t)( p - buf ) : 6;
+    }
 
-                if ( grp == '-' )
-                    break;
+    calc_space_padding( pspec, length, &ps1, &ps2 );
 
-                if ( grp == '*' )
-                {
-                    int w = (int)va_arg( *ap, int );
-                    if ( w < 0 )
-                        break;
+    return gen_out( cons, parg, ps1, NULL, 0, 0, s, length, ps2 );
+}
+#endif
 
-                    wid = (size_t)w;
-                    DEC_VOID_PTR(ptr);
-                    --glen;
-                }
-                else
-                {
-                    for ( wid = 0, decade = 1;
-                          glen != 0
-                             && ( grp = READ_CHAR( mode, ptr ) ) != '\0'
-                             && ISDIGIT( grp );
-                          DEC_VOID_PTR(ptr), --glen )
-                    {
-                        wid += decade * ( grp - '0' );
-                        decade *= 10;
-                    }
-                }
+#if defined(CONFIG_WITH_CONV_Q)
+/*****************************************************************************/
+/**
+    Quoting styles of the %q conversion, selected by the flags.
+**/
+enum { QUOTE_JSON, QUOTE_C, QUOTE_CSV, QUOTE_NONE };
 
-                if ( !glen )
-                    break;
+/**
+    Test if a character must be escaped in a quoting style.
+**/
+#define QUOTE_NEEDS(c,style)                                                \
+    ( (style) == QUOTE_NONE ? 0                                             \
+    : (style) == QUOTE_CSV ? (c) == '"'                                     \
+    : (c) == '"' || (c) == '\\' || (c) < 0x20                              \
+      || ( (style) == QUOTE_C && (c) >= 0x7F ) )
 
-                grp = READ_CHAR( mode, ptr );
-                DEC_VOID_PTR(ptr);
-                --glen;
-            }
+/*****************************************************************************/
+/**
+    Find the length of the run of characters at the start of a string which
+    need no escaping.
 
-            if ( wid )
-            {
-                if ( d_rem <= wid )
-                    break;
+    @param s        Pointer to string.
+    @param n        Length of string.
+    @param style    Quoting style.
 
-                for ( s = idx, n = d_rem - wid; n > 0; n--, s++ )
-                    numBuffer[s-1] = numBuffer[s];
+    @return Length of the run.
+**/
+static size_t quote_span( const char * s, size_t n, unsigned int style )
+{
+    size_t i = 0;
 
-                idx--;
-                numBuffer[idx + d_rem - wid] = grp;
-                numWidth++;
-                grp_insertions++;
+    if ( style == QUOTE_NONE )
+        return n;
 
-                d_rem -= wid;
-            }
-            else if ( !glen )
-                break;
-        }
+#if defined(NEED_SWAR)
+    for ( ; n - i >= sizeof( uintptr_t ); i += sizeof( uintptr_t ) )
+    {
+        uintptr_t w, hit;
+
+        memcpy( &w, s + i, sizeof( w ) );
+        hit = WORD_HAS( w, '"' );
+        if ( style != QUOTE_CSV )
+            hit |= WORD_HAS( w, '\\' ) | WORD_HAS_LESS( w, 0x20 );
+        if ( style == QUOTE_C )
+            hit |= WORD_HAS( w, 0x7F ) | ( w & WORD_HIGHS );
+        if ( hit )
+            break;
     }
-#endif /* CONFIG_WITH_GROUPING_SUPPORT */
+#endif
 
-    digitWidth = numWidth;
+    while ( i < n && !QUOTE_NEEDS( (unsigned char)s[i], style ) )
+        i++;
 
-    /* apply default precision */
-    if ( pspec->prec < 0 )
-        pspec->prec = 1;
-    else
-        pspec->flags &= ~FZERO; /* Ignore if precision specified */
+    return i;
+}
 
-    numWidth = MAX( numWidth, pspec->prec + grp_insertions );
-    length  += numWidth;
+/*****************************************************************************/
+/**
+    Write the escape sequence for a character.
 
-    calc_space_padding( pspec, length, &ps1, &ps2 );
+    @param c        Character to escape.
+    @param style    Quoting style.
+    @param buf      Buffer of at least 6 characters for the sequence.
 
-    /* Convert space padding into zero padding if we have the ZERO flag */
-    pz = numWidth - digitWidth;
-    if ( pspec->flags & FZERO )
+    @return Length of the sequence.
+**/
+static size_t quote_escape( char c, unsigned int style, char * buf )
+{
+    static const char hex[] = "0123456789abcdef";
+    unsigned char u = (unsigned char)c;
+
+    if ( style == QUOTE_CSV )
     {
-        pz += ps1;
-        ps1 = 0;
+        buf[0] = buf[1] = '"';
+        return 2;
     }
 
-    return gen_out( cons, parg,
-                    ps1,
-                    pfx_s, pfx_n,
-                    pz,
-                    &numBuffer[sizeof(numBuffer) - digitWidth], digitWidth,
-                    ps2 );
+    buf[0] = '\\';
+    switch ( u )
+    {
+    case '"':
+    case '\\': buf[1] = c;   return 2;
+    case '\b': buf[1] = 'b'; return 2;
+    case '\f': buf[1] = 'f'; return 2;
+    case '\n': buf[1] = 'n'; return 2;
+    case '\r': buf[1] = 'r'; return 2;
+    case '\t': buf[1] = 't'; return 2;
+    case '\a': buf[1] = 'a'; break;   /* not in JSON */
+    case '\v': buf[1] = 'v'; break;   /* not in JSON */
+    default:   buf[1] = '\0'; break;
+    }
+    if ( buf[1] && style == QUOTE_C )
+        return 2;
+
+    if ( style == QUOTE_JSON )
+    {
+        buf[1] = 'u';
+        buf[2] = '0';
+        buf[3] = '0';
+        buf[4] = hex[u >> 4];
+        buf[5] = hex[u & 0xF];
+        return 6;
+    }
+
+    /* C: always three octal digits, so a following digit is not taken in */
+    buf[1] = (char)( '0' + ( u >> 6 ) );
+    buf[2] = (char)( '0' + ( ( u >> 3 ) & 7 ) );
+    buf[3] = (char)( '0' + ( u & 7 ) );
+    return 4;
 }
 
 /*****************************************************************************/
 /**
-    Handle a single format conversion for a given type.
+    Process a %q conversion: write a string in double quotes, escaped for
+    JSON, for C with the '#' flag, or as a CSV field with the '!' flag.  The
+    precision limits the number of characters read from the string, and the
+    field width applies to the quoted result.  Runs of characters needing no
+    escape are sent straight from the string to the consumer function.
 
     @param pspec    Pointer to format specification.
     @param ap       Reference to optional format arguments list.
-    @param code     Conversion specifier code.
     @param cons     Pointer to consumer function.
     @param parg     Pointer to opaque pointer updated by cons.
 
     @return Number of emitted characters, or EXBADFORMAT if failure
 **/
-static int do_conv( T_FormatSpec * pspec,
-                    va_list *      ap,
-                    char           code,
-                    void *      (* cons)(void *, const char *, size_t),
-                    void * *       parg )
+static int do_conv_q( T_FormatSpec * pspec,
+                      T_Args *       ap,
+                      void *      (* cons)(void *, const char *, size_t),
+                      void * *       parg )
 {
-    unsigned int base = 0;
-
-    if ( code == 'n' )
-        return do_conv_n( pspec, ap );
-
-    if ( code == '%' )
-        return gen_out( cons, parg, 0, NULL, 0, 0, &code, 1, 0 );
-
-    if ( code == 'c' || code == 'C' )
-        return do_conv_c( pspec, ap, code, cons, parg );
+    unsigned int style = ( pspec->flags & FHASH ) ? QUOTE_C
+                       : ( pspec->flags & FBANG ) ? QUOTE_CSV
+                       :                            QUOTE_JSON;
+    const char *s = ARG( ap, const char * );
+    size_t quote = 1;
+    size_t length, total, i, n;
+    size_t ps1 = 0, ps2 = 0;
+    char esc[6];
 
-    if ( code == 's' )
+    /* NULL is written as is, without quotes */
+    if ( s == NULL )
     {
-#if defined(CONFIG_HAVE_ALT_PTR)
-        if ( pspec->flags & FHASH )
-            return do_conv_s_alt( pspec, ap, code, cons, parg );
-        else
-#endif
-            return do_conv_s( pspec, ap, cons, parg );
+        s = ( style == QUOTE_JSON ) ? "null" : "(null)";
+        style = QUOTE_NONE;
+        quote = 0;
     }
 
-#if defined(CONFIG_WITH_FP_SUPPORT)
-    if ( code == 'a' || code == 'A'
-      || code == 'e' || code == 'E'
-      || code == 'f' || code == 'F'
-      || code == 'g' || code == 'G' )
-        return do_conv_fp( pspec, ap, code, cons, parg );
+    length = STRLEN( s );
+    if ( pspec->prec >= 0 && quote )
+        length = (size_t)MIN( pspec->prec, (int)length );
 
-    if ( code == 'k' )
-        return do_conv_k( pspec, ap, cons, parg );
-#endif
+    /* Only a field width needs the length of the result in advance */
+    total = length + 2 * quote;
+    if ( pspec->width > total )
+        for ( i = 0; ( i += quote_span( s + i, length - i, style ) ) < length; i++ )
+            total += quote_escape( s[i], style, esc ) - 1;
 
-    /* -------------------------------------------------------------------- */
+    calc_space_padding( pspec, total, &ps1, &ps2 );
 
-    /* The '%p' conversion is a meta-conversion, which we convert to a
-     *  pre-defined format.  In this case we convert it to "%!#N.NX"
-     *  where N is double the machine-word size, as each byte converts into
+    if ( ps1 && pad( spaces, ps1, cons, parg ) < 0 )
+        return EXBADFORMAT;
+    if ( quote && emit( "\"", 1, cons, parg ) < 0 )
+        return EXBADFORMAT;
+
+    for ( total = 2 * quote, i = 0; i < length; i++ )
+    {
+        n = quote_span( s + i, length - i, style );
+        if ( n && emit( s + i, n, cons, parg ) < 0 )
+            return EXBADFORMAT;
+        total += n;
+        if ( ( i += n ) == length )
+            break;
+
+        n = quote_escape( s[i], style, esc );
+        if ( emit( esc, n, cons, parg ) < 0 )
+            return EXBADFORMAT;
+        total += n;
+    }
+
+    if ( quote && emit( "\"", 1, cons, parg ) < 0 )
+        return EXBADFORMAT;
+    if ( ps2 && pad( spaces, ps2, cons, parg ) < 0 )
+        return EXBADFORMAT;
+
+    return (int)( ps1 + total + ps2 );
+}
+#endif
+
+#if defined(CONFIG_WITH_CONV_S) && defined(CONFIG_HAVE_ALT_PTR)
+/*****************************************************************************/
+/**
+    Process a %s conversion that uses the alternate pointer type.
+
+    We split out the alternate functionality into a separate function so that
+    platforms that do not have this behaviour are not unduly loaded with
+    additional code, and it helps keep the main code cleaner.
+
+    @param pspec    Pointer to format specification.
+    @param ap       Reference to optional format arguments list.
+    @param code     Conversion specifier code.
+    @param cons     Pointer to consumer function.
+    @param parg     Pointer to opaque pointer updated by cons.
+
+    @return Number of emitted characters, or EXBADFORMAT if failure
+**/
+static int do_conv_s_alt( T_FormatSpec * pspec,
+                          T_Args *       ap,
+                          char           code,
+                          void *      (* cons)(void *, const char *, size_t),
+                          void * *       parg )
+{
+    size_t length = 0;
+    size_t ps1 = 0, ps2 = 0;
+    size_t n = 0;
+    static ROM_DECL(char const null_string[]) = "(null)";
+
+    const void *vp = (const void*)ARG( ap, ROM_PTR_T );
+
+    if ( vp == NULL )
+        vp = null_string;
+
+    length = STRLEN_ALT( (ROM_PTR_T)vp);
+    if ( pspec->prec >= 0 )
+        length = MIN( pspec->prec, length );
+
+    calc_space_padding( pspec, length, &ps1, &ps2 );
+
+    /* Inline the relevant parts of gen_out() here as we need to handle
+     *  alternate memory pointers.
+     */
+    if ( ps1 && pad( spaces, ps1, cons, parg ) < 0 )
+        return EXBADFORMAT;
+    n += ps1;
+
+    while ( length-- )
+    {
+        char c = ROM_CHAR(vp++);
+        if ( emit( &c, 1, cons, parg ) < 0 )
+            return EXBADFORMAT;
+        n++;
+    }
+
+    if ( ps2 && pad( spaces, ps2, cons, parg ) < 0 )
+        return EXBADFORMAT;
+    n += ps2;
+
+    return (int)n;
+}
+#endif
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+/*****************************************************************************/
+/**
+    Start a walk through the grouping specification, from the right.
+
+    @param pg       Pointer to grouping walk state.
+    @param pspec    Pointer to format specification.
+**/
+static void grp_start( T_GroupWalk * pg, T_FormatSpec * pspec )
+{
+#if defined(CONFIG_HAVE_ALT_PTR)
+    pg->mode = pspec->grouping.mode;
+#endif
+    pg->ptr  = pspec->grouping.ptr;
+    pg->glen = pspec->grouping.len;
+    pg->wid  = 0;
+    pg->grp  = 0;
+
+    MOVE_VOID_PTR( pg->ptr, pg->glen - 1 );
+}
+
+/*****************************************************************************/
+/**
+    Step to the next group in the grouping specification.  Once the
+    specification is used up the last group is repeated.
+
+    @param pg       Pointer to grouping walk state.
+    @param ap       Reference to optional format arguments list.
+
+    @return 1 if pg->wid and pg->grp hold the next group (a width of zero
+            inserts nothing), or 0 if grouping has finished.
+**/
+static int grp_next( T_GroupWalk * pg, T_Args * ap )
+{
+#if defined(CONFIG_HAVE_ALT_PTR)
+    enum ptr_mode mode = pg->mode;
+#endif
+    unsigned int  decade;
+
+    if ( pg->glen )
+    {
+        pg->grp = READ_CHAR( mode, pg->ptr );
+
+        if ( pg->grp == '-' )
+            return 0;
+
+        if ( pg->grp == '*' )
+        {
+            int w = (int)ARG( ap, int );
+            if ( w < 0 )
+                return 0;
+
+            pg->wid = (size_t)w;
+            DEC_VOID_PTR(pg->ptr);
+            --pg->glen;
+        }
+        else
+        {
+            for ( pg->wid = 0, decade = 1;
+                  pg->glen != 0
+                     && ( pg->grp = READ_CHAR( mode, pg->ptr ) ) != '\0'
+                     && ISDIGIT( pg->grp );
+                  DEC_VOID_PTR(pg->ptr), --pg->glen )
+            {
+                pg->wid += decade * ( pg->grp - '0' );
+                decade *= 10;
+            }
+        }
+
+        if ( !pg->glen )
+            return 0;
+
+        pg->grp = READ_CHAR( mode, pg->ptr );
+        DEC_VOID_PTR(pg->ptr);
+        --pg->glen;
+    }
+
+    return pg->wid || pg->glen;
+}
+
+#if defined(CONFIG_LOW_STACK)
+/*****************************************************************************/
+/**
+    Find the left-most grouping character to the right of a given digit.
+
+    @param pspec    Pointer to format specification.
+    @param ap       Reference to optional format arguments list.
+    @param below    Number of digits to the right of the digit.
+    @param pc       Pointer to store the grouping character.
+    @param pcount   Pointer to store number of grouping characters.  May be
+                    NULL.
+    @param consume  Non-zero to consume the arguments referenced by the
+                    grouping specification, otherwise @p ap is left unchanged.
+
+    @return Number of digits to the right of the grouping character, or 0 if
+            there is none.
+**/
+static size_t grp_find( T_FormatSpec * pspec,
+                        T_Args *       ap,
+                        size_t         below,
+                        char *         pc,
+                        size_t *       pcount,
+                        int            consume )
+{
+    T_GroupWalk gw;
+    T_Args      apc;
+    size_t      pos = 0;
+    size_t      count = 0;
+
+#if defined(NEED_ARG_TABLE)
+    apc.pos   = ap->pos;
+    apc.next  = ap->next;
+#endif
+#if defined(CONFIG_WITH_POSITIONAL)
+    apc.types    = NULL;
+    apc.numbered = ap->numbered;
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    apc.tags  = NULL;
+    apc.nargs = 0;
+#endif
+#if defined(NEED_ARG_TABLE)
+    /* format_conv() has no va_list to copy */
+    if ( !apc.pos )
+#endif
+        va_copy( apc.ap, ap->ap );
+    grp_start( &gw, pspec );
+
+    while ( pos < below && grp_next( &gw, consume ? ap : &apc ) )
+    {
+        if ( pos + gw.wid >= below )
+            break;
+
+        if ( gw.wid )
+        {
+            pos += gw.wid;
+            *pc  = gw.grp;
+            count++;
+        }
+    }
+
+#if defined(NEED_ARG_TABLE)
+    if ( !apc.pos )
+#endif
+        va_end( apc.ap );
+
+    if ( pcount )
+        *pcount = count;
+
+    return pos;
+}
+#endif
+#endif /* CONFIG_WITH_GROUPING_SUPPORT */
+
+#if defined(NEED_CONV_NUMERIC)
+/*****************************************************************************/
+/**
+    Process the numeric conversions (%b, %d, %i, %I, %o, %u, %U, %x, %X).
+
+    @param pspec    Pointer to format specification.
+    @param ap       Reference to optional format arguments list.
+    @param code     Conversion specifier code.
+    @param cons     Pointer to consumer function.
+    @param parg     Pointer to opaque pointer updated by cons.
+
+    @return Number of emitted characters, or EXBADFORMAT if failure
+**/
+static int do_conv_numeric( T_FormatSpec * pspec,
+                            T_Args *       ap,
+                            char           code,
+                            void *      (* cons)(void *, const char *, size_t),
+                            void * *       parg,
+                            unsigned int base )
+{
+    size_t length = 0;
+    size_t numWidth, digitWidth;
+#if !defined(CONFIG_LOW_STACK)
+    char numBuffer[BUFLEN];
+#endif
+    size_t ps1 = 0, ps2 = 0, pz = 0, pfx_n = 0;
+    const char * pfx_s = NULL;
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+#define T long long
+#else
+#define T long
+#endif
+    unsigned T uv;
+#if defined(CONFIG_LOW_STACK)
+    unsigned T div;
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    size_t bound = 0;
+    char sep = 0;
+#endif
+#endif
+    char prefix[2];
+    size_t pfxWidth = 0;
+    size_t grp_insertions = 0;
+    static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    /* Get the value.
+     * Signed values need special handling for negative values and the
+     *  extra options for sign output which don't apply to the unsigned
+     *  values.
+     */
+    if ( pspec->flags & F_IS_SIGNED )
+    {
+        T v;
+
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+        if ( pspec->qual == DOUBLE_QUAL( 'l' ) )
+            v = (T)ARG( ap, T );
+        else
+#endif
+        if ( pspec->qual == 'l' )
+            v = (T)ARG( ap, long );
+        else if ( pspec->qual == 'j' )
+            v = (T)ARG( ap, intmax_t );
+        else if ( pspec->qual == 'z' )
+            v = (T)ARG( ap, size_t );
+        else if ( pspec->qual == 't' )
+            v = (T)ARG( ap, ptrdiff_t );
+        else
+            v = (T)ARG( ap, int );
+
+        if ( pspec->qual == 'h' )
+            v = (short)v;
+        if ( pspec->qual == DOUBLE_QUAL( 'h' ) )
+            v = (signed char)v;
+
+        /* Get absolute value */
+        uv = (unsigned T)(v < 0 ? -v : v);
+
+        /* Based on original sign and flags work out any prefix */
+        prefix[0] = '\0';
+        if ( v < 0 )
+            prefix[0]     = '-';
+        else if ( pspec->flags & FPLUS )
+            prefix[0]     = '+';
+        else if ( pspec->flags & FSPACE )
+            prefix[0]     = ' ';
+
+        if ( prefix[0] != '\0' )
+        {
+            pfxWidth      = 1;
+            pspec->flags |= FHASH;
+        }
+    }
+    else
+    {
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+        if ( pspec->qual == DOUBLE_QUAL( 'l' ) )
+            uv = (unsigned T)ARG( ap, unsigned T );
+        else
+#endif
+        if ( pspec->qual == 'l' )
+            uv = (unsigned T)ARG( ap, unsigned long );
+        else if ( pspec->qual == 'j' )
+            uv = (unsigned T)ARG( ap, uintmax_t );
+        else if ( pspec->qual == 'z' )
+            uv = (unsigned T)ARG( ap, size_t );
+        else if ( pspec->qual == 't' )
+            uv = (unsigned T)ARG( ap, ptrdiff_t );
+        else
+            uv = (unsigned T)ARG( ap, unsigned int );
+
+        if ( pspec->qual == 'h' )
+            uv = (unsigned short)uv;
+        if ( pspec->qual == DOUBLE_QUAL( 'h' ) )
+            uv = (unsigned char)uv;
+
+        prefix[0] = '0';
+    }
+
+    if ( code == 'o' && uv )
+        pfxWidth = 1;
+
+    if ( code == 'x' || code == 'X' || code == 'b' )
+    {
+        /* if non-zero or bang flag, add prefix for hex and binary */
+        if ( ( pspec->flags & FBANG ) || uv )
+        {
+            prefix[1] = code;
+            pfxWidth  = 2;
+        }
+
+        /* Bang flag forces lower-case */
+        if ( pspec->flags & FBANG )
+            prefix[1] |= 0x20;
+    }
+
+    if ( pspec->flags & FHASH )
+    {
+        length += pfxWidth;
+        pfx_s = prefix;
+        pfx_n = pfxWidth;
+    }
+
+#if defined(CONFIG_LOW_STACK)
+    /* work out how many digits in uv, and the weight of the leading digit */
+    for ( numWidth = 0, div = 1; uv / div >= base; div *= base )
+    {
+        STEP();
+        ++numWidth;
+    }
+    if ( uv > 0 )
+        ++numWidth;
+#else
+    /* work out how many digits in uv */
+    for ( numWidth = 0; uv > 0; uv /= base )
+    {
+        char cc = digits[uv % base];
+
+        /* convert to lower case? */
+        if ( code == 'x' || code == 'i' || code == 'u' )
+            cc |= 0x20;
+
+        ++numWidth;
+        numBuffer[sizeof(numBuffer) - numWidth] = cc;
+    }
+#endif
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    if ( pspec->grouping.len )
+    {
+#if defined(CONFIG_LOW_STACK)
+        /* Only count the grouping characters for now, leaving the argument
+         *  list alone so the specification can be walked again as the
+         *  digits are generated.
+         */
+        bound = grp_find( pspec, ap, numWidth, &sep, &grp_insertions, 0 );
+        numWidth += grp_insertions;
+#else
+        T_GroupWalk   gw;
+        size_t        d_rem = numWidth;
+        size_t        idx   = sizeof(numBuffer) - numWidth;
+        size_t        s, n;
+
+        grp_start( &gw, pspec );
+
+        while ( d_rem && grp_next( &gw, ap ) )
+        {
+            if ( gw.wid )
+            {
+                if ( d_rem <= gw.wid )
+                    break;
+
+                for ( s = idx, n = d_rem - gw.wid; n > 0; n--, s++ )
+                    numBuffer[s-1] = numBuffer[s];
+
+                idx--;
+                numBuffer[idx + d_rem - gw.wid] = gw.grp;
+                numWidth++;
+                grp_insertions++;
+
+                d_rem -= gw.wid;
+            }
+        }
+#endif
+    }
+#endif /* CONFIG_WITH_GROUPING_SUPPORT */
+
+    digitWidth = numWidth;
+
+    /* apply default precision */
+    if ( pspec->prec < 0 )
+        pspec->prec = 1;
+    else
+        pspec->flags &= ~FZERO; /* Ignore if precision specified */
+
+    numWidth = MAX( numWidth, pspec->prec + grp_insertions );
+    length  += numWidth;
+
+    calc_space_padding( pspec, length, &ps1, &ps2 );
+
+    /* Convert space padding into zero padding if we have the ZERO flag */
+    pz = numWidth - digitWidth;
+    if ( pspec->flags & FZERO )
+    {
+        pz += ps1;
+        ps1 = 0;
+    }
+
+#if defined(CONFIG_LOW_STACK)
+    {
+        char   chunk[PAD_STRING_LEN];
+        size_t k = 0;
+        size_t d_rem;
+        int    r = gen_out( cons, parg, ps1, pfx_s, pfx_n, pz, NULL, 0, 0 );
+
+        /* Generate the digits from the left, passing them to the consumer
+         *  a chunk at a time.
+         */
+        for ( d_rem = digitWidth - grp_insertions; r >= 0 && d_rem > 0; d_rem-- )
+        {
+            char cc = digits[uv / div];
+
+            /* convert to lower case? */
+            if ( code == 'x' || code == 'i' || code == 'u' )
+                cc |= 0x20;
+
+            chunk[k++] = cc;
+            uv %= div;
+            div /= base;
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+            if ( bound && d_rem - 1 == bound )
+            {
+                chunk[k++] = sep;
+                bound = grp_find( pspec, ap, bound, &sep, NULL, 0 );
+            }
+#endif
+
+            if ( k >= sizeof(chunk) - 1 || d_rem == 1 )
+            {
+                if ( emit( chunk, k, cons, parg ) < 0 )
+                    r = EXBADFORMAT;
+                k = 0;
+            }
+        }
+
+        if ( r >= 0 )
+        {
+            if ( ps2 && pad( spaces, ps2, cons, parg ) < 0 )
+                r = EXBADFORMAT;
+            else
+                r += (int)( digitWidth + ps2 );
+        }
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+        /* Finally step over any arguments used for grouping */
+        if ( pspec->grouping.len )
+            grp_find( pspec, ap, digitWidth - grp_insertions, &sep, NULL, 1 );
+#endif
+
+        return r;
+    }
+#else
+    return gen_out( cons, parg,
+                    ps1,
+                    pfx_s, pfx_n,
+                    pz,
+                    &numBuffer[sizeof(numBuffer) - digitWidth], digitWidth,
+                    ps2 );
+#endif
+}
+#endif
+
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+/*****************************************************************************/
+/**
+    Handle a custom conversion, passing its pointer argument and the parsed
+    conversion to the handler registered for it.
+
+    @param pspec    Pointer to format specification.
+    @param ap       Reference to optional format arguments list.
+    @param code     Conversion specifier code.
+    @param cons     Pointer to consumer function.
+    @param parg     Pointer to opaque pointer updated by cons.
+
+    @return Number of emitted characters, or EXBADFORMAT if failure
+**/
+static int do_conv_custom( T_FormatSpec * pspec,
+                           T_Args *       ap,
+                           char           code,
+                           void *      (* cons)(void *, const char *, size_t),
+                           void * *       parg )
+{
+    struct format_conv conv;
+    const void *value = ARG( ap, void * );
+
+    get_spec( &conv, pspec, code );
+
+    return CUSTOM_CONV( code )( cons, parg, &conv, value );
+}
+#endif
+
+/*****************************************************************************/
+/**
+    Handle a single format conversion for a given type.
+
+    @param pspec    Pointer to format specification.
+    @param ap       Reference to optional format arguments list.
+    @param code     Conversion specifier code.
+    @param cons     Pointer to consumer function.
+    @param parg     Pointer to opaque pointer updated by cons.
+
+    @return Number of emitted characters, or EXBADFORMAT if failure
+**/
+static int do_conv( T_FormatSpec * pspec,
+                    T_Args *       ap,
+                    char           code,
+                    void *      (* cons)(void *, const char *, size_t),
+                    void * *       parg )
+{
+#if defined(NEED_CONV_NUMERIC)
+    unsigned int base = 0;
+#endif
+
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+    if ( CUSTOM_CONV( code ) )
+        return do_conv_custom( pspec, ap, code, cons, parg );
+#endif
+
+#if defined(CONFIG_WITH_CONV_N)
+    if ( code == 'n' )
+        return do_conv_n( pspec, ap );
+#endif
+
+    if ( code == '%' )
+        return gen_out( cons, parg, 0, NULL, 0, 0, &code, 1, 0 );
+
+#if !defined(CONFIG_WITH_WIDE_CHARS)
+    if ( pspec->qual == 'l' && ( code == 'c' || code == 's' ) )
+        return EXBADFORMAT;
+#endif
+
+#if defined(CONFIG_WITH_CONV_C)
+    if ( code == 'c' || code == 'C' )
+        return do_conv_c( pspec, ap, code, cons, parg );
+#endif
+
+#if defined(CONFIG_WITH_CONV_S)
+    if ( code == 's' )
+    {
+#if defined(CONFIG_HAVE_ALT_PTR)
+        if ( pspec->flags & FHASH )
+            return do_conv_s_alt( pspec, ap, code, cons, parg );
+        else
+#endif
+#if defined(CONFIG_WITH_WIDE_CHARS)
+        if ( pspec->qual == 'l' )
+            return do_conv_ls( pspec, ap, cons, parg );
+        else
+#endif
+#if !defined(CONFIG_WITH_UTF8)
+        if ( pspec->flags & FBANG )
+            return EXBADFORMAT;
+        else
+#endif
+            return do_conv_s( pspec, ap, cons, parg );
+    }
+#endif
+
+#if defined(CONFIG_WITH_CONV_T)
+    if ( code == 'T' )
+        return do_conv_t( pspec, ap, cons, parg );
+#endif
+
+#if defined(CONFIG_WITH_CONV_Q)
+    if ( code == 'q' )
+        return do_conv_q( pspec, ap, cons, parg );
+#endif
+
+#if defined(CONFIG_WITH_CONV_NET)
+    if ( code == 'N' || code == 'M' )
+        return do_conv_net( pspec, ap, code, cons, parg );
+#endif
+
+#if defined(CONFIG_WITH_CONV_EFG)
+    if ( code == 'e' || code == 'E'
+      || code == 'f' || code == 'F'
+      || code == 'g' || code == 'G' )
+        return do_conv_fp( pspec, ap, code, cons, parg );
+#endif
+
+#if defined(CONFIG_WITH_CONV_A)
+    if ( code == 'a' || code == 'A' )
+        return do_conv_fp( pspec, ap, code, cons, parg );
+#endif
+
+#if defined(CONFIG_WITH_CONV_K)
+    if ( code == 'k' )
+        return do_conv_k( pspec, ap, cons, parg );
+#endif
+
+    /* -------------------------------------------------------------------- */
+
+#if defined(CONFIG_WITH_CONV_P)
+    /* The '%p' conversion is a meta-conversion, which we convert to a
+     *  pre-defined format.  In this case we convert it to "%!#N.NX"
+     *  where N is double the machine-word size, as each byte converts into
      *  two characters.
      */
     if ( code == 'p' )
     {
-        code          = 'X';
-        pspec->qual   = ( sizeof( void * ) > sizeof( int ) ) ? DOUBLE_QUAL('l') : 0;
-        pspec->width  = (unsigned int)(sizeof( void * ) * 2);
-        pspec->prec   = (int)(sizeof( void * ) * 2);
+        code          = 'X';
+        base          = 16;
+        pspec->qual   = PTR_QUAL;
+        pspec->width  = (unsigned int)(sizeof( void * ) * 2);
+        pspec->prec   = (int)(sizeof( void * ) * 2);
+    }
+#endif
+
+    /* -------------------------------------------------------------------- */
+
+#if defined(CONFIG_WITH_CONV_D)
+    /* The '%d' and '%i' conversions are both decimal (base 10) and the '#'
+     *  flag is ignored.  We set the F_IS_SIGNED internal flag to guide later
+     *  processing.
+     */
+    if ( code == 'd' || code == 'i'
+#if defined(CONFIG_WITH_CONV_BASE)
+      || code == 'I'
+#endif
+       )
+    {
+        pspec->flags |= F_IS_SIGNED;
+        base = 10;
+        pspec->flags &= ~FHASH;
+
+#if defined(CONFIG_WITH_CONV_BASE)
+        if ( ( code == 'i' || code == 'I' ) && pspec->base )
+           base = pspec->base;
+#endif
+    }
+#endif
+
+#if defined(CONFIG_WITH_CONV_X)
+    if ( code == 'x' || code == 'X' )
+        base = 16;
+#endif
+
+#if defined(CONFIG_WITH_CONV_U)
+#if defined(CONFIG_WITH_CONV_BASE)
+    if ( code == 'u' || code == 'U' )
+       base = pspec->base ? pspec->base : 10;
+#else
+    if ( code == 'u' )
+       base = 10;
+#endif
+#endif
+
+#if defined(CONFIG_WITH_CONV_O)
+    if ( code == 'o' )
+        base = 8;
+#endif
+
+#if defined(CONFIG_WITH_CONV_B)
+    if ( code == 'b' )
+        base = 2;
+#endif
+
+#if defined(NEED_CONV_NUMERIC)
+    if ( base > 1 )
+        return do_conv_numeric( pspec, ap, code, cons, parg, base );
+#endif
+
+    return EXBADFORMAT;
+}
+
+/*****************************************************************************/
+/**
+    Get the int argument for a '*' in a conversion specification.  With
+    positional arguments the '*' is followed by the argument number and '$'.
+
+    @param pa       Pointer to optional format arguments.
+    @param pptr     Pointer to format string pointer, pointing at the '*'.
+    @param pv       Pointer to store the argument value.
+
+    @return 0 if successful, or EXBADFORMAT if failure.
+**/
+static int get_star( T_Args *      pa,
+                     const void * *pptr,
+                     int *         pv )
+{
+    INC_VOID_PTR( *pptr );  /* skip the '*' */
+
+#if defined(CONFIG_WITH_POSITIONAL)
+    if ( pa->numbered )
+    {
+        int n = get_argn( pptr );
+
+        if ( n < 0 )
+            return EXBADFORMAT;
+
+        if ( pa->types )
+        {
+            *pv = 0;
+            return set_type( pa, n, ARG_INT );
+        }
+
+#if defined(CONFIG_WITH_TYPED_ARGS)
+        if ( pa->tags && typed_check( pa, (unsigned int)n, FORMAT_ARG_INT ) < 0 )
+            return EXBADFORMAT;
+#endif
+        *pv = pa->pos[n].i;
+        return 0;
+    }
+#endif
+
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    if ( pa->tags && typed_check( pa, pa->next, FORMAT_ARG_INT ) < 0 )
+        return EXBADFORMAT;
+#endif
+    *pv = ARG( pa, int );
+    return 0;
+}
+
+#if defined(CONFIG_WITH_POSITIONAL)
+/*****************************************************************************/
+/**
+    Test if a format string uses positional arguments, by looking at its first
+    conversion specification.
+
+    @param fmt      Format string.
+
+    @return 1 if the first conversion begins with "n$", otherwise 0.
+**/
+static int is_positional( const char *fmt )
+{
+    for ( ; ( fmt = STRCHR( fmt, '%' ) ) != NULL; fmt += 2 )
+    {
+        if ( fmt[1] != '%' )
+        {
+            for ( fmt++; ISDIGIT( *fmt ); fmt++ )
+                ;
+            return *fmt == '$';
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+    Read a positional argument number "n$".
+
+    @param pptr     Pointer to format string pointer, which is moved past
+                    the '$'.
+
+    @return Index of argument n in the argument table, or EXBADFORMAT if
+            missing or out of range.
+**/
+static int get_argn( const void * *pptr )
+{
+    const char *s = (const char *)*pptr;
+    unsigned int n;
+
+    for ( n = 0; ISDIGIT( *s ) && n <= MAXPOSARG; s++ )
+        n = n * 10 + *s - '0';
+
+    if ( *s != '$' || n < 1 || n > MAXPOSARG )
+        return EXBADFORMAT;
+
+    *pptr = s + 1;
+    return (int)n - 1;
+}
+
+/*****************************************************************************/
+/**
+    Record the type of an argument while scanning the format string.  An
+    argument referred to by more than one conversion must have the same type
+    each time.
+
+    @param pa       Pointer to optional format arguments.
+    @param n        Index of the argument.
+    @param type     Argument type.
+
+    @return 0 if successful, or EXBADFORMAT if failure.
+**/
+static int set_type( T_Args *      pa,
+                     int           n,
+                     unsigned char type )
+{
+    if ( n >= MAXPOSARG )
+        return EXBADFORMAT;
+
+    if ( pa->types[n] != ARG_NONE && pa->types[n] != type )
+        return EXBADFORMAT;
+
+    pa->types[n] = type;
+    return 0;
+}
+#endif
+
+#if defined(NEED_ARG_TYPES)
+/*****************************************************************************/
+/**
+    Work out the type of argument a conversion reads, following the
+    conversion handlers.
+
+    @param pspec    Pointer to format specification.
+    @param code     Conversion specifier code.
+
+    @return Argument type, or ARG_NONE if the conversion reads no argument.
+**/
+static unsigned char arg_type( T_FormatSpec * pspec,
+                               char           code )
+{
+    char qual = pspec->qual;
+
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+    if ( CUSTOM_CONV( code ) )
+        return ARG_PTR;
+#endif
+
+    if ( code == 'n' )
+        return ARG_PTR;
+
+    if ( code == 'c' )
+        return ARG_INT;
+
+#if defined(CONFIG_WITH_WIDE_CHARS)
+    if ( code == 's' && qual == 'l' )
+        return ARG_PTR;
+#endif
+
+    if ( code == 's' )
+#if defined(CONFIG_HAVE_ALT_PTR)
+        return ( pspec->flags & FHASH ) ? ARG_ROM : ARG_STR;
+#else
+        return ARG_STR;
+#endif
+
+    if ( code == 'q' )
+        return ARG_STR;
+
+#if defined(CONFIG_WITH_CONV_NET)
+    if ( code == 'M' || ( code == 'N' && ( pspec->flags & FHASH ) ) )
+        return ARG_PTR;
+    if ( code == 'N' )
+        return sizeof( uint32_t ) <= sizeof( int ) ? ARG_INT : ARG_LONG;
+#endif
+
+    if ( code != '\0' && STRCHR( "aAeEfFgG", code ) )
+        return ARG_DOUBLE;
+
+#if defined(CONFIG_WITH_CONV_T)
+    if ( code == 'T' )
+        return ARG_LLONG;
+#endif
+
+#if defined(CONFIG_WITH_CONV_K)
+    if ( code == 'k' )
+        return ( pspec->xp.w_int + pspec->xp.w_frac + 7 ) / 8 <= sizeof( int )
+               ? ARG_INT : ARG_LONG;
+#endif
+
+    if ( code == 'p' )
+        qual = PTR_QUAL;
+    else if ( code == '\0' || !STRCHR( "bdiIouUxX", code ) )
+        return ARG_NONE;
+
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    if ( qual == DOUBLE_QUAL( 'l' ) )
+        return ARG_LLONG;
+#endif
+    if ( qual == 'l' )
+        return ARG_LONG;
+    if ( qual == 'j' )
+        return ARG_INTMAX;
+    if ( qual == 'z' )
+        return ARG_SIZE;
+    if ( qual == 't' )
+        return ARG_PTRDIFF;
+    return ARG_INT;
+}
+#endif
+
+#if defined(CONFIG_WITH_POSITIONAL) || defined(CONFIG_WITH_TEMPLATE)
+/*****************************************************************************/
+/**
+    Read the next argument from the va_list into an argument table entry.
+
+    @param pa       Pointer to optional format arguments.
+    @param type     ARG_ type of the argument.
+    @param pv       Pointer to the table entry.
+
+    @return 0 if successful, or EXBADFORMAT if the type cannot be read.
+**/
+static int get_arg( T_Args *      pa,
+                    unsigned char type,
+                    T_ArgValue *  pv )
+{
+    switch ( type )
+    {
+    case ARG_INT:       pv->i = va_arg( pa->ap, int );          break;
+    case ARG_LONG:      pv->l = va_arg( pa->ap, long );         break;
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    case ARG_LLONG:     pv->ll = va_arg( pa->ap, long long );   break;
+#endif
+    case ARG_INTMAX:    pv->j = va_arg( pa->ap, intmax_t );     break;
+    case ARG_SIZE:      pv->z = va_arg( pa->ap, size_t );       break;
+    case ARG_PTRDIFF:   pv->t = va_arg( pa->ap, ptrdiff_t );    break;
+#if defined(CONFIG_WITH_FP_SUPPORT)
+    case ARG_DOUBLE:    pv->d = va_arg( pa->ap, double );       break;
+#endif
+    case ARG_PTR:       pv->p = va_arg( pa->ap, void * );       break;
+    case ARG_STR:       pv->s = va_arg( pa->ap, const char * ); break;
+#if defined(CONFIG_HAVE_ALT_PTR)
+    case ARG_ROM:       *(ROM_PTR_T *)(void *)pv
+                            = va_arg( pa->ap, ROM_PTR_T );      break;
+#endif
+    default:            return EXBADFORMAT;
+    }
+
+    return 0;
+}
+#endif
+
+#if defined(CONFIG_WITH_FORMAT_CONV) || defined(CONFIG_WITH_TEMPLATE) \
+ || defined(CONFIG_WITH_CUSTOM_CONV)
+/*****************************************************************************/
+/**
+    Set up a format specification from a conversion that has already been
+    parsed.
+
+    @param pspec    Pointer to format specification to fill in.
+    @param pconv    Pointer to the parsed conversion.
+**/
+static void set_spec( T_FormatSpec *             pspec,
+                      const struct format_conv * pconv )
+{
+    pspec->nChars = 0;
+    pspec->flags  = pconv->flags & ~F_IS_SIGNED;
+    pspec->width  = pconv->width;
+    pspec->prec   = pconv->prec < 0 ? -1 : pconv->prec;
+    pspec->qual   = pconv->qual;
+#if defined(CONFIG_WITH_CONV_BASE)
+    pspec->base   = pconv->base;
+#endif
+#if defined(CONFIG_WITH_CONV_C)
+    pspec->repchar = pconv->repchar;
+#endif
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+#if defined(CONFIG_HAVE_ALT_PTR)
+    pspec->grouping.mode = NORMAL_PTR;
+#endif
+    pspec->grouping.ptr  = pconv->grouping;
+    pspec->grouping.len  = pconv->grouping ? pconv->grouping_len : 0;
+#endif
+#if defined(CONFIG_WITH_CONV_K)
+    pspec->xp.w_int  = pconv->xp_int;
+    pspec->xp.w_frac = pconv->xp_frac;
+#endif
+}
+#endif
+
+#if defined(CONFIG_WITH_TEMPLATE) || defined(CONFIG_WITH_CUSTOM_CONV)
+/*****************************************************************************/
+/**
+    Store a parsed format specification as a conversion, the reverse of
+    set_spec().
+
+    @param pconv    Pointer to the conversion to fill in.
+    @param pspec    Pointer to the format specification.
+    @param code     Conversion specifier code.
+**/
+static void get_spec( struct format_conv * pconv,
+                      T_FormatSpec *       pspec,
+                      char                 code )
+{
+    pconv->flags        = pspec->flags & ~F_IS_SIGNED;
+    pconv->width        = pspec->width;
+    pconv->prec         = pspec->prec;
+#if defined(CONFIG_WITH_CONV_BASE)
+    pconv->base         = pspec->base;
+#else
+    pconv->base         = 0;
+#endif
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    pconv->grouping     = (const char *)pspec->grouping.ptr;
+    pconv->grouping_len = pspec->grouping.len;
+#else
+    pconv->grouping     = NULL;
+    pconv->grouping_len = 0;
+#endif
+#if defined(CONFIG_WITH_CONV_K)
+    pconv->xp_int       = pspec->xp.w_int;
+    pconv->xp_frac      = pspec->xp.w_frac;
+#else
+    pconv->xp_int       = 0;
+    pconv->xp_frac      = 0;
+#endif
+    pconv->qual         = pspec->qual;
+    pconv->code         = code;
+    pconv->repchar      = '\0';
+}
+#endif
+
+#if defined(CONFIG_WITH_TYPED_ARGS)
+/*****************************************************************************/
+/**
+    Check the type of an argument passed to format_args().
+
+    @param pa       Pointer to optional format arguments.
+    @param n        Index of the argument.
+    @param tag      FORMAT_ARG_ type the conversion needs.
+
+    @return 0 if the argument exists and has that type, else EXBADFORMAT.
+**/
+static int typed_check( T_Args *      pa,
+                        unsigned int  n,
+                        unsigned char tag )
+{
+    if ( n >= pa->nargs || pa->tags[n] != tag )
+        return EXBADFORMAT;
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+    Check the arguments of a conversion passed to format_args().  Integer
+    conversions read the value as the type it was passed as: the length
+    qualifier is replaced with the one for that type, except that 'h' and
+    "hh" still narrow an int.
+
+    @param pspec    Pointer to format specification.
+    @param pa       Pointer to optional format arguments.
+    @param code     Conversion specifier code.
+
+    @return 0 if successful, or EXBADFORMAT if failure.
+**/
+static int typed_conv( T_FormatSpec * pspec,
+                       T_Args *       pa,
+                       char           code )
+{
+    unsigned char type = arg_type( pspec, code );
+    unsigned int  n    = pa->next;
+    unsigned char tag;
+
+    if ( type == ARG_NONE )
+        return 0;
+
+    if ( n >= pa->nargs )
+        return EXBADFORMAT;
+    tag = pa->tags[n];
+
+    /* any pointer will do for %p, the network addresses and custom
+     * conversions */
+    if ( code == 'p' || code == 'M' || ( code == 'N' && type == ARG_PTR )
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+      || CUSTOM_CONV( code )
+#endif
+       )
+        return ( tag == FORMAT_ARG_PTR || tag == FORMAT_ARG_STR ) ? 0 : EXBADFORMAT;
+
+    switch ( type )
+    {
+    case ARG_DOUBLE:
+        return typed_check( pa, n, FORMAT_ARG_DOUBLE );
+    case ARG_PTR:
+        return typed_check( pa, n, FORMAT_ARG_PTR );
+    case ARG_STR:
+        return typed_check( pa, n, FORMAT_ARG_STR );
+    case ARG_ROM:
+        return ( tag == FORMAT_ARG_PTR || tag == FORMAT_ARG_STR ) ? 0 : EXBADFORMAT;
+    default:
+        break;
+    }
+
+#if defined(CONFIG_WITH_CONV_T)
+    /* int64_t is long on LP64 targets, which %T reads just as well */
+    if ( code == 'T' && tag == FORMAT_ARG_LONG
+      && sizeof( long ) == sizeof( long long ) )
+        return 0;
+#endif
+
+    /* %c, %k, %T and %N read exactly the type they ask for */
+    if ( code == 'c' || code == 'k' || code == 'T' || code == 'N' )
+        return typed_check( pa, n, type == ARG_LLONG ? FORMAT_ARG_LLONG
+                                 : type == ARG_LONG  ? FORMAT_ARG_LONG
+                                                     : FORMAT_ARG_INT );
+
+    if ( tag == FORMAT_ARG_INT )
+    {
+        if ( pspec->qual != 'h' && pspec->qual != DOUBLE_QUAL( 'h' ) )
+            pspec->qual = '\0';
+    }
+    else if ( tag == FORMAT_ARG_LONG )
+        pspec->qual = 'l';
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    else if ( tag == FORMAT_ARG_LLONG )
+        pspec->qual = DOUBLE_QUAL( 'l' );
+#endif
+    else
+        return EXBADFORMAT;
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    {
+        const void *g = pspec->grouping.ptr;
+        size_t      i;
+
+        for ( i = 0; i < pspec->grouping.len; i++, INC_VOID_PTR( g ) )
+            if ( READ_CHAR( pspec->grouping.mode, g ) == '*'
+              && typed_check( pa, ++n, FORMAT_ARG_INT ) < 0 )
+                return EXBADFORMAT;
+    }
+#endif
+
+    return 0;
+}
+#endif
+
+#if defined(CONFIG_WITH_POSITIONAL)
+/*****************************************************************************/
+/**
+    Record the types of the arguments read by a conversion, while scanning
+    the format string.  Each '*' in a grouping specification reads one of
+    the arguments following the value.
+
+    @param pspec    Pointer to format specification.
+    @param pa       Pointer to optional format arguments.
+    @param code     Conversion specifier code.
+    @param n        Index of the argument to be converted.
+
+    @return 0 if successful, or EXBADFORMAT if failure.
+**/
+static int scan_conv( T_FormatSpec * pspec,
+                      T_Args *       pa,
+                      char           code,
+                      int            n )
+{
+    unsigned char type = arg_type( pspec, code );
+
+    if ( type == ARG_NONE )
+        return 0;
+
+    if ( set_type( pa, n, type ) < 0 )
+        return EXBADFORMAT;
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    if ( STRCHR( "bdiIouUxXp", code ) )
+    {
+        const char *g = (const char *)pspec->grouping.ptr;
+        size_t      i;
+
+        for ( i = 0; i < pspec->grouping.len; i++ )
+            if ( g[i] == '*' && set_type( pa, ++n, ARG_INT ) < 0 )
+                return EXBADFORMAT;
+    }
+#endif
+
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+    Format with positional arguments.  The format string is scanned once to
+    find the type of each argument, the arguments are copied in order into a
+    table, and then the format string is executed reading from the table.
+
+    @param cons     Pointer to caller-provided consumer function.
+    @param arg      Opaque pointer passed through to cons.
+    @param fmt      Printf-compatible format specifier.
+    @param pa       Pointer to optional format arguments.
+
+    @return Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+static int do_positional( void *    (* cons) (void *, const char * , size_t),
+                          void *       arg,
+                          const char * fmt,
+                          T_Args *     pa )
+{
+    T_ArgValue    table[MAXPOSARG];
+    unsigned char types[MAXPOSARG];
+    int           n;
+
+    for ( n = 0; n < MAXPOSARG; n++ )
+        types[n] = ARG_NONE;
+
+    pa->numbered = 1;
+    pa->types    = types;
+    if ( do_format( cons, arg, fmt, pa ) < 0 )
+        return EXBADFORMAT;
+    pa->types = NULL;
+
+    for ( n = 0; n < MAXPOSARG && types[n] != ARG_NONE; n++ )
+        if ( get_arg( pa, types[n], &table[n] ) < 0 )
+            return EXBADFORMAT;
+
+    /* Every argument up to the last one used must be referred to, else its
+     *  type and so the position of those that follow is unknown.
+     */
+    for ( ; n < MAXPOSARG; n++ )
+        if ( types[n] != ARG_NONE )
+            return EXBADFORMAT;
+
+    pa->pos = table;
+    return do_format( cons, arg, fmt, pa );
+}
+#endif
+
+/*****************************************************************************/
+/**
+    Parse a conversion specification, from the flags to the length qualifier,
+    leaving the pointer at the conversion character.  Shared by format() and
+    format_scan().
+
+    @param pspec    Pointer to format specification to fill in.
+    @param pa       Pointer to arguments, for any '*' fields.
+    @param pptr     Pointer to format string pointer.
+    @param mode     Format string pointer type.
+
+    @return 0 if successful, or EXBADFORMAT if failure
+**/
+static int parse_spec( T_FormatSpec * pspec,
+                       T_Args *       pa,
+                       const void * * pptr,
+                       enum ptr_mode  mode )
+{
+    static const char fchar[] = {" +-#0!^"};
+    static const unsigned int fbit[] = {
+        FSPACE, FPLUS, FMINUS, FHASH, FZERO, FBANG, FCARET, 0};
+    const void *ptr = *pptr;
+    char c;
+    char *t;
+
+    /* process conversion flags */
+    for ( pspec->flags = 0;
+          (c = READ_CHAR( mode, ptr )) && (t = STRCHR(fchar, c)) != NULL;
+          INC_VOID_PTR(ptr) )
+    {
+        pspec->flags |= fbit[t - fchar];
+    }
+
+    /* process width */
+    if ( READ_CHAR( mode, ptr ) == '*' )
+    {
+        int w;
+
+        if ( get_star( pa, &ptr, &w ) < 0 )
+            return EXBADFORMAT;
+
+        if ( w < 0 )
+        {
+            w = -w;
+            pspec->flags |= FMINUS;
+        }
+        pspec->width = (unsigned int)w;
+    }
+    else
+    {
+        for ( pspec->width = 0;
+              ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && pspec->width < MAXWIDTH;
+              INC_VOID_PTR(ptr) )
+        {
+            pspec->width = pspec->width * 10 + c - '0';
+        }
+    }
+
+    if ( pspec->width > MAXWIDTH )
+        return EXBADFORMAT;
+
+    /* process precision */
+    if ( READ_CHAR( mode, ptr ) != '.' )
+        pspec->prec = -1; /* precision is missing */
+    else if ( READ_CHAR( mode, INC_VOID_PTR(ptr) ) == '*' )
+    {
+        if ( get_star( pa, &ptr, &pspec->prec ) < 0 )
+            return EXBADFORMAT;
+
+        if ( pspec->prec > MAXPREC )
+            return EXBADFORMAT;
+    }
+    else
+    {
+        for ( pspec->prec = 0;
+              ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && pspec->prec < MAXPREC;
+              INC_VOID_PTR(ptr) )
+        {
+            pspec->prec = pspec->prec * 10 + c - '0';
+        }
+        if ( pspec->prec > MAXPREC )
+            return EXBADFORMAT;
+    }
+
+#if defined(CONFIG_WITH_CONV_BASE)
+    /* process base */
+    if ( READ_CHAR( mode, ptr ) != ':' )
+        pspec->base = 0;
+    else if ( READ_CHAR( mode, INC_VOID_PTR(ptr) ) == '*' )
+    {
+        int v;
+
+        if ( get_star( pa, &ptr, &v ) < 0 )
+            return EXBADFORMAT;
+
+        if ( v < 0 )
+            pspec->base = 0;
+        else if ( v > MAXBASE )
+            return EXBADFORMAT;
+        else
+            pspec->base = (unsigned int)v;
+    }
+    else
+    {
+        for ( pspec->base = 0;
+              ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && pspec->base < MAXBASE;
+              INC_VOID_PTR(ptr) )
+        {
+            pspec->base = pspec->base * 10 + c - '0';
+        }
+        if ( pspec->base > MAXBASE )
+            return EXBADFORMAT; 
+    }
+#endif
+
+#if defined(CONFIG_WITH_CONV_K)
+    /* default fixed-point format is 16p16 */
+    pspec->xp.w_int  = 16;
+    pspec->xp.w_frac = 16;
+#endif
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    /* test for grouping qualifier */
+    pspec->grouping.len = 0;
+    pspec->grouping.ptr = NULL;
+#if defined(CONFIG_HAVE_ALT_PTR)
+    pspec->grouping.mode = NORMAL_PTR;
+#endif
+#endif
+
+    switch( READ_CHAR( mode, ptr ) )
+    {
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    case '[': /* grouping specifier */
+    {
+        size_t gplen = 0;
+
+        /* skip over opening brace */
+        INC_VOID_PTR(ptr);
+
+        /* set the pointer mode */
+#if defined(CONFIG_HAVE_ALT_PTR)
+        pspec->grouping.mode = mode;
+#endif
+        pspec->grouping.ptr  = ptr;
+
+        /* scan to end of grouping string */
+        while ( ( c = READ_CHAR( mode, ptr ) ) && c != ']' )
+        {
+            INC_VOID_PTR(ptr);
+            ++gplen;
+        }
+        if ( c == '\0' )
+            return EXBADFORMAT;
+
+        /* skip over closing brace */
+        INC_VOID_PTR(ptr);
+
+        /* record the grouping spec length */
+        pspec->grouping.len = gplen;
+    }
+	    break;
+#endif
+#if defined(CONFIG_WITH_CONV_K)
+	    case '{': /* fixed-point specifier */
+    {
+        unsigned int p, q;
+
+        /* skip over opening brace */
+        INC_VOID_PTR( ptr );
+
+        /* get integer width */
+        if ( READ_CHAR( mode, ptr ) == '*' )
+        {
+            int v;
+
+            if ( get_star( pa, &ptr, &v ) < 0 )
+                return EXBADFORMAT;
+            p = (unsigned int)MAX( 0, v );
+        }
+        else
+        {
+            for ( p = 0;
+                 ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && p < MAX_XP_INT;
+                 INC_VOID_PTR( ptr ) )
+            {
+                p = p * 10 + c - '0';
+                if ( p > MAX_XP_INT )
+                    return EXBADFORMAT;
+            }
+        }
+
+        /* get fractional width */
+        if ( READ_CHAR( mode, ptr ) != '.' )
+            return EXBADFORMAT; /* fractional width is missing */
+        else if ( READ_CHAR( mode, INC_VOID_PTR(ptr) ) == '*' )
+        {
+            int v;
+
+            if ( get_star( pa, &ptr, &v ) < 0 )
+                return EXBADFORMAT;
+            q = (unsigned int)MAX( 0, v );
+        }
+        else
+        {
+            for ( q = 0;
+                 ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && q < MAX_XP_FRAC;
+                 INC_VOID_PTR( ptr ) )
+            {
+                q = q * 10 + c - '0';
+                if ( q > MAX_XP_FRAC )
+                    return EXBADFORMAT;
+            }
+        }
+
+        if ( p + q >= MAX_XP_WIDTH )
+            return EXBADFORMAT;
+
+        if ( c == '\0' )
+            return EXBADFORMAT;
+
+        /* skip over closing brace */
+        INC_VOID_PTR( ptr );
+
+        pspec->xp.w_int  = p;
+        pspec->xp.w_frac = q;
+    }
+	    break;
+#endif
+    } /* switch(..)
+
+    /* test for length qualifier */
+    c = READ_CHAR( mode, ptr );
+    pspec->qual = ( c && STRCHR( "hljztL", c ) ) ? (INC_VOID_PTR(ptr), c) : '\0';
+
+    /* catch double qualifiers */
+    if ( pspec->qual && (c = READ_CHAR( mode, ptr )) && c == pspec->qual )
+    {
+        pspec->qual = DOUBLE_QUAL( pspec->qual );
+        INC_VOID_PTR(ptr);
     }
 
-    /* -------------------------------------------------------------------- */
+    *pptr = ptr;
+    return 0;
+}
 
-    /* The '%d' and '%i' conversions are both decimal (base 10) and the '#'
-     *  flag is ignored.  We set the F_IS_SIGNED internal flag to guide later
-     *  processing.
-     */
-    if ( code == 'd' || code == 'i' || code == 'I' )
+/*****************************************************************************/
+/**
+    Execute a format string.  Called by format(), and twice by
+    do_positional(): once to scan the format string for argument types
+    (when @a pa->types is set), and once to do the formatting.
+
+    @param cons     Pointer to caller-provided consumer function.
+    @param arg      Opaque pointer passed through to cons.
+    @param fmt      Printf-compatible format specifier.
+    @param pa       Pointer to optional format arguments.
+
+    @return Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+static int do_format( void *    (* cons) (void *, const char * , size_t),
+                      void *       arg,
+                      const char * fmt,
+                      T_Args *     pa )
+{
+    T_FormatSpec fspec;
+#if defined(CONFIG_HAVE_ALT_PTR)
+    enum ptr_mode  mode = NORMAL_PTR;
+#endif
+    char           c;
+    const void   * ptr = (const void *)fmt;
+#if defined(CONFIG_WITH_POSITIONAL)
+    int            argn = 0;
+    int            positional = pa->numbered;
+#endif
+
+    fspec.nChars = 0;
+
+    while ( ( c = READ_CHAR( mode, ptr ) ) )
     {
-        pspec->flags |= F_IS_SIGNED;
-        base = 10;
-        pspec->flags &= ~FHASH;
+        /* scan for % or \0 */
+#if defined(CONFIG_HAVE_ALT_PTR)
+        if ( mode == NORMAL_PTR )
+#endif
+        {
+            size_t n = 0;
+            const char *s = (const char *)ptr;
 
-        if ( ( code == 'i' || code == 'I' ) && pspec->base )
-           base = pspec->base;
-    }
+            /* For normal RAM-based strings we scan over as many input chars
+             *  as we can to minimise calls to emit().
+             */
+            for ( ; *s && *s != '%'; s++ )
+                n++;
 
-    if ( code == 'x' || code == 'X' )
-        base = 16;
+            if ( n > 0 )
+            {
+#if defined(CONFIG_WITH_POSITIONAL)
+                if ( !pa->types )
+#endif
+                if ( emit( (const char *)ptr, n, cons, &arg ) < 0 )
+                    goto exit_badformat;
 
-    if ( code == 'u' || code == 'U' )
-       base = pspec->base ? pspec->base : 10;
+                fspec.nChars += n;
+            }
+            ptr = (const void *)s;
+        }
+#if defined(CONFIG_HAVE_ALT_PTR)
+        else
+        {
+            /* Alternate pointers are treated one character at a time to keep
+             *  the interface to emit() common across all string pointer
+             *  types.
+             */
+            while ( ( c = ROM_CHAR(ptr) ) && c != '%' )
+            {
+                if ( emit( &c, 1, cons, &arg ) < 0 )
+                    goto exit_badformat;
 
-    if ( code == 'o' )
-        base = 8;
+                fspec.nChars++;
+                ptr++;
+            }
+        }
+#endif
 
-    if ( code == 'b' )
-        base = 2;
+        if ( READ_CHAR( mode, ptr ) )
+        {
+            /* found conversion specifier */
+            char convspec;
+            int nn;
 
-    if ( base > 1 )
-        return do_conv_numeric( pspec, ap, code, cons, parg, base );
+            INC_VOID_PTR(ptr);    /* skip the % sign */
+
+#if defined(CONFIG_WITH_POSITIONAL)
+            /* process argument number */
+            if ( positional && READ_CHAR( mode, ptr ) != '%' )
+            {
+                if ( ( argn = get_argn( &ptr ) ) < 0 )
+                    goto exit_badformat;
+                pa->next = (unsigned int)argn;
+            }
+#endif
+
+#if defined(CONFIG_HAVE_ALT_PTR)
+            if ( parse_spec( &fspec, pa, &ptr, mode ) < 0 )
+#else
+            if ( parse_spec( &fspec, pa, &ptr, NORMAL_PTR ) < 0 )
+#endif
+                goto exit_badformat;
+
+            /* Continuation */
+            c = READ_CHAR( mode, ptr );
+            if ( c == '\0' )
+            {
+#if !defined(CONFIG_WITH_CONTINUATION)
+                goto exit_badformat;
+#else
+#if defined(CONFIG_WITH_POSITIONAL)
+                /* the continuation cannot be scanned for argument types */
+                if ( positional )
+                    goto exit_badformat;
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+                if ( pa->tags && typed_check( pa, pa->next, FORMAT_ARG_STR ) < 0 )
+                    goto exit_badformat;
+#endif
+#if defined(CONFIG_HAVE_ALT_PTR)
+                if ( fspec.flags & FHASH )
+                {
+                    mode = ALT_PTR;
+                    ptr = ARG( pa, ROM_PTR_T );
+                }
+                else
+                {
+                    mode = NORMAL_PTR;
+#endif
+                    ptr = ARG( pa, const char * );
+#if defined(CONFIG_HAVE_ALT_PTR)
+                }
+#endif
+                continue;
+#endif
+            }
+
+            convspec = c;
+
+#if defined(CONFIG_WITH_CONV_C)
+            if ( convspec == 'C' )
+            {
+                c = READ_CHAR( mode, INC_VOID_PTR(ptr) );
+                if ( c == '\0' )
+                    goto exit_badformat;
+                fspec.repchar = c;
+            }
+            else
+            {
+                fspec.repchar = '\0';
+            }
+#endif
+
+            /* now process the conversion type */
+#if defined(CONFIG_WITH_TYPED_ARGS)
+            if ( pa->tags && typed_conv( &fspec, pa, convspec ) < 0 )
+                goto exit_badformat;
+#endif
+#if defined(CONFIG_WITH_POSITIONAL)
+            if ( pa->types )
+                nn = scan_conv( &fspec, pa, convspec, argn );
+            else
+#endif
+                nn = do_conv( &fspec, pa, convspec, cons, &arg );
+            if ( nn < 0 )
+                goto exit_badformat;
+            else
+                fspec.nChars += (unsigned int)nn;
+
+            INC_VOID_PTR(ptr);
+        }
+    }
+
+    return (int)fspec.nChars;
 
+exit_badformat:
     return EXBADFORMAT;
 }
 
@@ -999,354 +3301,631 @@ static int do_conv( T_FormatSpec * pspec,
     consumer function cons, which also takes caller-provided opaque pointer
     arg.
 
-    Note: floating point is not supported.
+    @param cons     Pointer to caller-provided consumer function.
+    @param arg      Opaque pointer passed through to cons.
+    @param fmt      Printf-compatible format specifier.
+    @param apx      List of optional format string arguments.
+
+    @return Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+int format( void *    (* cons) (void *, const char * , size_t),
+            void *       arg,
+            const char * fmt,
+            va_list      apx )
+{
+    T_Args args;
+    int    n;
+
+    if ( fmt == NULL )
+        return EXBADFORMAT;
+
+    /* Setup varargs -- must va_end( args.ap ) before exit !! */
+    va_copy( args.ap, apx );
+
+#if defined(NEED_ARG_TABLE)
+    args.pos   = NULL;
+    args.next  = 0;
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    args.tags  = NULL;
+    args.nargs = 0;
+#endif
+#if defined(CONFIG_WITH_POSITIONAL)
+    args.types    = NULL;
+    args.numbered = 0;
+
+    if ( is_positional( fmt ) )
+        n = do_positional( cons, arg, fmt, &args );
+    else
+#endif
+        n = do_format( cons, arg, fmt, &args );
+
+    va_end( args.ap );
+    return n;
+}
+
+#if defined(CONFIG_WITH_SCAN)
+/*****************************************************************************/
+/**
+    Scan text against a format specification.
+
+    @param prod     Pointer to caller-provided producer function, or NULL.
+    @param arg      Opaque pointer passed through to @a prod, or string.
+    @param fmt      Format specification.
+    @param apx      List of pointers to store the values through.
+
+    @return Number of values stored, or EXBADFORMAT if failure
+**/
+int format_scan( const char * (* prod) (void *, size_t *),
+                 void *       arg,
+                 const char * fmt,
+                 va_list      apx )
+{
+    T_Scan sc;
+    T_Args args;
+    int    n;
+
+    if ( fmt == NULL || ( prod == NULL && arg == NULL ) )
+        return EXBADFORMAT;
+
+    sc.prod  = prod;
+    sc.arg   = arg;
+    sc.hold  = SCAN_EOF;
+    sc.count = 0;
+    sc.p     = prod ? NULL : (const char *)arg;
+    sc.end   = prod ? NULL : sc.p + STRLEN( sc.p );
+
+    /* Setup varargs -- must va_end( args.ap ) before exit !! */
+    va_copy( args.ap, apx );
+
+#if defined(NEED_ARG_TABLE)
+    args.pos   = NULL;
+    args.next  = 0;
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    args.tags  = NULL;
+    args.nargs = 0;
+#endif
+#if defined(CONFIG_WITH_POSITIONAL)
+    args.types    = NULL;
+    args.numbered = 0;
+#endif
+
+    n = do_scan( &sc, fmt, &args );
+
+    va_end( args.ap );
+    return n;
+}
+#endif
+
+#if defined(CONFIG_WITH_TEMPLATE)
+/*****************************************************************************/
+/**
+    Compile a format specification into a display template.  Text, and
+    conversions which read no arguments, are rendered once here.  Every
+    other conversion gets a cell as wide as its field width.
+
+    @param t        Pointer to the template.
+    @param fmt      Format specification, which must outlive the template.
+    @param cells    Array for the conversions.
+    @param maxcells Number of elements in @a cells.
+    @param text     Buffer for the rendered text.
+    @param size     Size of @a text, including a terminating null character.
+
+    @return Number of conversions, or EXBADFORMAT if failure
+**/
+int format_template_init( struct format_template * t,
+                          const char *             fmt,
+                          struct format_cell *     cells,
+                          unsigned int             maxcells,
+                          char *                   text,
+                          size_t                   size )
+{
+    static const T_ArgValue none = { 0 };
+    T_FormatSpec fspec;
+    T_Args       ta;
+    T_Cell       cell;
+    void        *pcell = &cell;
+    const void  *ptr = (const void *)fmt;
+    size_t       len = 0;
+    unsigned int n = 0;
+    char         c;
+
+    if ( t == NULL || fmt == NULL || text == NULL || size == 0
+      || ( maxcells && cells == NULL ) )
+        return EXBADFORMAT;
+
+    /* Any '*' reads from this empty table, and is caught below */
+    ta.pos  = &none;
+#if defined(CONFIG_WITH_POSITIONAL)
+    ta.types    = NULL;
+    ta.numbered = 0;
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    ta.tags  = NULL;
+    ta.nargs = 0;
+#endif
+
+    cell.end = text + size - 1;
+
+    while ( ( c = READ_CHAR( NORMAL_PTR, ptr ) ) )
+    {
+        INC_VOID_PTR( ptr );
+        if ( c != '%' )
+        {
+            if ( len == size - 1 )
+                return EXBADFORMAT;
+            text[len++] = c;
+            continue;
+        }
+
+        ta.next = 0;
+        if ( parse_spec( &fspec, &ta, &ptr, NORMAL_PTR ) < 0 || ta.next )
+            return EXBADFORMAT;
+
+        /* no continuations */
+        if ( ( c = READ_CHAR( NORMAL_PTR, ptr ) ) == '\0' )
+            return EXBADFORMAT;
+        INC_VOID_PTR( ptr );
+
+#if defined(CONFIG_WITH_CONV_C)
+        fspec.repchar = '\0';
+        if ( c == 'C' )
+        {
+            if ( ( fspec.repchar = READ_CHAR( NORMAL_PTR, ptr ) ) == '\0' )
+                return EXBADFORMAT;
+            INC_VOID_PTR( ptr );
+        }
+#endif
+
+        if ( arg_type( &fspec, c ) == ARG_NONE )
+        {
+            int r;
+
+            cell.p     = text + len;
+            fspec.nChars = (unsigned int)len;
+            r = do_conv( &fspec, &ta, c, tmpl_put, &pcell );
+            if ( r < 0 || (size_t)r > size - 1 - len )
+                return EXBADFORMAT;
+            len += (size_t)r;
+            continue;
+        }
+
+        /* a cell needs a fixed width, and no '*' grouping arguments */
+        if ( c == 'n' || fspec.width == 0 || n == maxcells
+          || fspec.width > size - 1 - len )
+            return EXBADFORMAT;
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+        {
+            size_t i;
+
+            for ( i = 0; i < fspec.grouping.len; i++ )
+                if ( ( (const char *)fspec.grouping.ptr )[i] == '*' )
+                    return EXBADFORMAT;
+        }
+#endif
+
+        get_spec( &cells[n].conv, &fspec, c );
+        cells[n].offset = len;
+        for ( ; len < cells[n].offset + fspec.width; len++ )
+            text[len] = ' ';
+        n++;
+    }
+
+    text[len] = '\0';
+
+    t->cells  = cells;
+    t->ncells = n;
+    t->text   = text;
+    t->len    = len;
+    t->valid  = 0;
+
+    return (int)n;
+}
 
-    @param cons     Pointer to caller-provided consumer function.
+/*****************************************************************************/
+/**
+    Update a display template with new arguments.  Only the conversions
+    whose arguments have changed are run again, and only the characters
+    which then change are sent, as one span per cell.  The first update
+    after format_template_init(), or after @a t->valid is cleared, sends the
+    whole text.
+
+    @param t        Pointer to the template.
+    @param cons     Pointer to caller-provided update function, which is
+                    passed the offset of each span in the text.
     @param arg      Opaque pointer passed through to cons.
-    @param fmt      Printf-compatible format specifier.
-    @param apx      List of optional format string arguments.
+    @param apx      The argument of each conversion.
 
-    @return Number of characters sent to @a cons, or EXBADFORMAT.
+    @return Number of characters sent to @a cons, or EXBADFORMAT if failure
 **/
-int format( void *    (* cons) (void *, const char * , size_t),
-            void *       arg,
-            const char * fmt,
-            va_list      apx )
+int format_template_update( struct format_template * t,
+                            void *    (* cons) (void *, size_t, const char *, size_t),
+                            void *                   arg,
+                            va_list                  apx )
 {
     T_FormatSpec fspec;
-#if defined(CONFIG_HAVE_ALT_PTR)
-    enum ptr_mode  mode = NORMAL_PTR;
-#endif
-    char           c;
-    const void   * ptr = (const void *)fmt;
-    va_list        ap;
-    
-    /* Setup varargs -- must va_end( ap ) before exit !! */
-    va_copy( ap, apx );
+    T_Args       ta, tv;
+    T_Cell       cell;
+    T_ArgValue   v;
+    void        *pcell = &cell;
+    unsigned int i;
+    int          n = 0;
+
+    if ( t == NULL || cons == NULL )
+        return EXBADFORMAT;
 
-    if ( fmt == NULL )
-        goto exit_badformat;
+    /* Setup varargs -- must va_end( ta.ap ) before exit !! */
+    va_copy( ta.ap, apx );
+    ta.pos  = NULL;
+    ta.next = 0;
 
-    fspec.nChars = 0;
+    /* Each conversion reads its value from its cell */
+    tv.next = 0;
+#if defined(CONFIG_WITH_POSITIONAL)
+    tv.types    = NULL;
+    tv.numbered = 0;
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    tv.tags  = NULL;
+    tv.nargs = 0;
+#endif
 
-    while ( ( c = READ_CHAR( mode, ptr ) ) )
+    for ( i = 0; i < t->ncells; i++ )
     {
-        /* scan for % or \0 */
-#if defined(CONFIG_HAVE_ALT_PTR)
-        if ( mode == NORMAL_PTR )
-#endif
+        struct format_cell *pc = &t->cells[i];
+        unsigned char type;
+
+        set_spec( &fspec, &pc->conv );
+        type = arg_type( &fspec, pc->conv.code );
+        if ( get_arg( &ta, type, &v ) < 0 )
+            goto exit_badformat;
+
+        if ( t->valid && tmpl_same( type, &v, &pc->value ) )
+            continue;
+
+        pc->value  = v;
+        cell.p     = t->text + pc->offset;
+        cell.end   = cell.p + pc->conv.width;
+        cell.first = NULL;
+        tv.pos     = &pc->value;
+        tv.next    = 0;
+        if ( do_conv( &fspec, &tv, pc->conv.code, tmpl_put, &pcell ) < 0 )
+            goto exit_badformat;
+        while ( cell.p < cell.end )
+            tmpl_put( pcell, spaces, MIN( PAD_STRING_LEN, (size_t)( cell.end - cell.p ) ) );
+
+        if ( t->valid && cell.first )
         {
-            size_t n = 0;
-            const char *s = (const char *)ptr;
+            size_t span = (size_t)( cell.last - cell.first );
 
-            /* For normal RAM-based strings we scan over as many input chars
-             *  as we can to minimise calls to emit().
-             */
-            for ( ; *s && *s != '%'; s++ )
-                n++;
+            if ( ( arg = cons( arg, (size_t)( cell.first - t->text ),
+                               cell.first, span ) ) == NULL )
+                goto exit_badformat;
+            n += (int)span;
+        }
+    }
 
-            if ( n > 0 )
-            {
-                if ( emit( (const char *)ptr, n, cons, &arg ) < 0 )
-                    goto exit_badformat;
+    if ( !t->valid )
+    {
+        if ( t->len && cons( arg, 0, t->text, t->len ) == NULL )
+            goto exit_badformat;
+        n = (int)t->len;
+        t->valid = 1;
+    }
 
-                fspec.nChars += n;
-            }
-            ptr = (const void *)s;
-        }
-#if defined(CONFIG_HAVE_ALT_PTR)
-        else
-        {
-            /* Alternate pointers are treated one character at a time to keep
-             *  the interface to emit() common across all string pointer
-             *  types.
-             */
-            while ( ( c = ROM_CHAR(ptr) ) && c != '%' )
-            {
-                if ( emit( &c, 1, cons, &arg ) < 0 )
-                    goto exit_badformat;
+    va_end( ta.ap );
+    return n;
 
-                fspec.nChars++;
-                ptr++;
-            }
-        }
+exit_badformat:
+    va_end( ta.ap );
+    return EXBADFORMAT;
+}
 #endif
 
-        if ( READ_CHAR( mode, ptr ) )
-        {
-            /* found conversion specifier */
-            char convspec;
-            char *t;
-            int nn;
-            static const char fchar[] = {" +-#0!^"};
-            static const unsigned int fbit[] = {
-                FSPACE, FPLUS, FMINUS, FHASH, FZERO, FBANG, FCARET, 0};
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+/*****************************************************************************/
+/**
+    Bind a conversion letter to a handler.  The letter must not be one of
+    the built-in conversions or length qualifiers.  The conversion reads one
+    pointer argument, which is passed to the handler with the parsed
+    conversion.  Register handlers before formatting starts, as the table is
+    not locked.
 
-            INC_VOID_PTR(ptr);    /* skip the % sign */
+    @param code     Conversion letter.
+    @param handler  Handler for the conversion, or NULL to remove it.
 
-            /* process conversion flags */
-            for ( fspec.flags = 0;
-                  (c = READ_CHAR( mode, ptr )) && (t = STRCHR(fchar, c)) != NULL;
-                  INC_VOID_PTR(ptr) )
-            {
-                fspec.flags |= fbit[t - fchar];
-            }
+    @return 0 if successful, or EXBADFORMAT if @a code cannot be used.
+**/
+int format_register( char code,
+                     int (* handler)( void *(*)(void *, const char *, size_t),
+                                      void * *,
+                                      const struct format_conv *,
+                                      const void * ) )
+{
+    unsigned char i = (unsigned char)( code - CUSTOM_FIRST );
 
-            /* process width */
-            if ( READ_CHAR( mode, ptr ) == '*' )
-            {
-                int w = va_arg( ap, int );
-                if ( w < 0 )
-                {
-                    w = -w;
-                    fspec.flags |= FMINUS;
-                }
-                fspec.width = (unsigned int)w;
-                INC_VOID_PTR(ptr);
-            }
-            else
-            {
-                for ( fspec.width = 0;
-                      ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && fspec.width < MAXWIDTH;
-                      INC_VOID_PTR(ptr) )
-                {
-                    fspec.width = fspec.width * 10 + c - '0';
-                }
-            }
+    if ( !( ( code >= 'A' && code <= 'Z' ) || ( code >= 'a' && code <= 'z' ) )
+         || STRCHR( builtin_conv, code ) )
+        return EXBADFORMAT;
 
-            if ( fspec.width > MAXWIDTH )
-                goto exit_badformat;
+    custom_conv[i] = handler;
 
-            /* process precision */
-            if ( READ_CHAR( mode, ptr ) != '.' )
-                fspec.prec = -1; /* precision is missing */
-            else if ( READ_CHAR( mode, INC_VOID_PTR(ptr) ) == '*' )
-            {
-                fspec.prec = va_arg( ap, int );
+    return 0;
+}
 
-                if ( fspec.prec > MAXPREC )
-                    goto exit_badformat;
+/*****************************************************************************/
+/**
+    Send the text of a custom conversion, cut to its precision and padded
+    to its width with spaces, justified by the '-' and '^' flags as for %s.
 
-                INC_VOID_PTR(ptr);
-            }
-            else
-            {
-                for ( fspec.prec = 0;
-                      ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && fspec.prec < MAXPREC;
-                      INC_VOID_PTR(ptr) )
-                {
-                    fspec.prec = fspec.prec * 10 + c - '0';
-                }
-                if ( fspec.prec > MAXPREC )
-                    goto exit_badformat;
-            }
+    @param cons     Pointer to consumer function.
+    @param parg     Pointer to opaque pointer updated by cons.
+    @param conv     The conversion, as passed to the handler.
+    @param s        Pointer to the text.
+    @param n        Length of the text.
 
-            /* process base */
-            if ( READ_CHAR( mode, ptr ) != ':' )
-                fspec.base = 0;
-            else if ( READ_CHAR( mode, INC_VOID_PTR(ptr) ) == '*' )
-            {
-                int v = va_arg( ap, int );
+    @return Number of characters sent, or EXBADFORMAT if failure.
+**/
+int format_field( void *                  (* cons)(void *, const char *, size_t),
+                  void * *                   parg,
+                  const struct format_conv * conv,
+                  const char *               s,
+                  size_t                     n )
+{
+    T_FormatSpec fspec;
+    size_t ps1, ps2;
 
-                if ( v < 0 )
-                    fspec.base = 0;
-                else if ( v > MAXBASE )
-                    goto exit_badformat;
-                else
-                    fspec.base = (unsigned int)v;
+    set_spec( &fspec, conv );
 
-                INC_VOID_PTR(ptr);
-            }
-            else
-            {
-                for ( fspec.base = 0;
-                      ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && fspec.base < MAXBASE;
-                      INC_VOID_PTR(ptr) )
-                {
-                    fspec.base = fspec.base * 10 + c - '0';
-                }
-                if ( fspec.base > MAXBASE )
-                    goto exit_badformat; 
-            }
+    if ( fspec.prec >= 0 && n > (size_t)fspec.prec )
+        n = (size_t)fspec.prec;
 
-#if defined(CONFIG_WITH_FP_SUPPORT)
-            /* default fixed-point format is 16p16 */
-            fspec.xp.w_int  = 16;
-            fspec.xp.w_frac = 16;
-#endif
+    calc_space_padding( &fspec, n, &ps1, &ps2 );
 
-#if defined(CONFIG_WITH_GROUPING_SUPPORT)
-            /* test for grouping qualifier */
-            fspec.grouping.len = 0;
-            fspec.grouping.ptr = NULL;
-#if defined(CONFIG_HAVE_ALT_PTR)
-            fspec.grouping.mode = NORMAL_PTR;
-#endif
+    return gen_out( cons, parg, ps1, NULL, 0, 0, s, n, ps2 );
+}
 #endif
 
-            switch( READ_CHAR( mode, ptr ) )
-            {
-#if defined(CONFIG_WITH_GROUPING_SUPPORT)
-            case '[': /* grouping specifier */
-            {
-                size_t gplen = 0;
+#if defined(CONFIG_WITH_SCREEN)
+/*****************************************************************************/
+/**
+    Set up a screen for positioned output, at row 0 column 0.
+
+    @param sc       Pointer to the screen.
+    @param row      Pointer to caller-provided row function.
+    @param arg      Opaque pointer passed through to row.
+    @param cols     Columns, at which output wraps, or 0 for no wrapping.
+    @param rows     Rows, after which output wraps to row 0, or 0.
+    @param line     Staging buffer of @a cols characters, or NULL.
+**/
+void format_screen_init( struct format_screen * sc,
+                         void *    (* row) (void *, unsigned int, unsigned int,
+                                            const char *, size_t),
+                         void *                 arg,
+                         unsigned int           cols,
+                         unsigned int           rows,
+                         char *                 line )
+{
+    sc->row  = row;
+    sc->arg  = arg;
+    sc->cols = cols;
+    sc->rows = rows;
+    sc->line = cols ? line : NULL;
+    sc->x    = 0;
+    sc->y    = 0;
+    sc->sx   = 0;
+}
 
-                /* skip over opening brace */
-                INC_VOID_PTR(ptr);
+/*****************************************************************************/
+/**
+    Send the characters staged in the current row as one run.
 
-                /* set the pointer mode */
-#if defined(CONFIG_HAVE_ALT_PTR)
-                fspec.grouping.mode = mode;
-#endif
-                fspec.grouping.ptr  = ptr;
+    @param sc       Pointer to the screen.
 
-                /* scan to end of grouping string */
-                while ( ( c = READ_CHAR( mode, ptr ) ) && c != ']' )
-                {
-                    INC_VOID_PTR(ptr);
-                    ++gplen;
-                }
-                if ( c == '\0' )
-                    goto exit_badformat;
+    @return 0 if successful, or EXBADFORMAT if failure
+**/
+int format_screen_flush( struct format_screen * sc )
+{
+    if ( sc->line && sc->sx < sc->x )
+    {
+        if ( ( sc->arg = sc->row( sc->arg, sc->sx, sc->y, sc->line + sc->sx,
+                                  sc->x - sc->sx ) ) == NULL )
+            return EXBADFORMAT;
+    }
+    sc->sx = sc->x;
 
-                /* skip over closing brace */
-                INC_VOID_PTR(ptr);
+    return 0;
+}
 
-                /* record the grouping spec length */
-                fspec.grouping.len = gplen;
-            }
-	    break;
-#endif
-#if defined(CONFIG_WITH_FP_SUPPORT)
-	    case '{': /* fixed-point specifier */
-            {
-                unsigned int p, q;
+/*****************************************************************************/
+/**
+    Move the output position of a screen, sending any staged characters
+    first.
 
-                /* skip over opening brace */
-                INC_VOID_PTR( ptr );
+    @param sc       Pointer to the screen.
+    @param x        Column.
+    @param y        Row.
 
-                /* get integer width */
-                if ( READ_CHAR( mode, ptr ) == '*' )
-                {
-                    int v = va_arg( ap, int );
-                    p = (unsigned int)MAX( 0, v );
+    @return 0 if successful, or EXBADFORMAT if failure
+**/
+int format_screen_move( struct format_screen * sc,
+                        unsigned int           x,
+                        unsigned int           y )
+{
+    if ( format_screen_flush( sc ) < 0 )
+        return EXBADFORMAT;
 
-                    INC_VOID_PTR( ptr );
-                }
-                else
-                {
-                    for ( p = 0;
-                         ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && p < MAX_XP_INT;
-                         INC_VOID_PTR( ptr ) )
-                    {
-                        p = p * 10 + c - '0';
-                        if ( p > MAX_XP_INT )
-                            goto exit_badformat;
-                    }
-                }
+    sc->x  = sc->cols ? MIN( x, sc->cols - 1 ) : x;
+    sc->y  = sc->rows ? MIN( y, sc->rows - 1 ) : y;
+    sc->sx = sc->x;
 
-                /* get fractional width */
-                if ( READ_CHAR( mode, ptr ) != '.' )
-                    goto exit_badformat; /* fractional width is missing */
-                else if ( READ_CHAR( mode, INC_VOID_PTR(ptr) ) == '*' )
-                {
-                    int v = va_arg( ap, int );
-                    q = (unsigned int)MAX( 0, v );
+    return 0;
+}
 
-                    INC_VOID_PTR( ptr );
-                }
-                else
-                {
-                    for ( q = 0;
-                         ( c = READ_CHAR( mode, ptr ) ) && ISDIGIT( c ) && q < MAX_XP_FRAC;
-                         INC_VOID_PTR( ptr ) )
-                    {
-                        q = q * 10 + c - '0';
-                        if ( q > MAX_XP_FRAC )
-                            goto exit_badformat;
-                    }
-                }
+/*****************************************************************************/
+/**
+    Consumer function writing to a screen.  The characters are split into
+    runs, one for each row they cover, and a newline moves to the start of
+    the next row.  With a staging buffer, runs are gathered so that each row
+    is sent once, when output leaves it or the screen is flushed.
 
-                if ( p + q >= MAX_XP_WIDTH )
-                    goto exit_badformat;
+    @param p        Pointer to the screen.
+    @param s        Pointer to characters to write.
+    @param n        Number of characters.
 
-                if ( c == '\0' )
-                    goto exit_badformat;
+    @return @a p, or NULL if failure.
+**/
+void * format_screen_put( void * p, const char * s, size_t n )
+{
+    struct format_screen *sc = (struct format_screen *)p;
 
-                /* skip over closing brace */
-                INC_VOID_PTR( ptr );
+    while ( n )
+    {
+        size_t k;
 
-                fspec.xp.w_int  = p;
-                fspec.xp.w_frac = q;
-            }
-	    break;
-#endif
-            } /* switch(..)
+        if ( *s == '\n' )
+            k = 0;
+        else
+        {
+            size_t max = sc->cols ? MIN( n, sc->cols - sc->x ) : n;
 
-            /* test for length qualifier */
-            c = READ_CHAR( mode, ptr );
-            fspec.qual = ( c && STRCHR( "hljztL", c ) ) ? (INC_VOID_PTR(ptr), c) : '\0';
+            for ( k = 1; k < max && s[k] != '\n'; k++ )
+                ;
 
-            /* catch double qualifiers */
-            if ( fspec.qual && (c = READ_CHAR( mode, ptr )) && c == fspec.qual )
+            if ( sc->line )
+                memcpy( sc->line + sc->x, s, k );
+            else if ( ( sc->arg = sc->row( sc->arg, sc->x, sc->y, s, k ) ) == NULL )
+                return NULL;
+
+            sc->x += (unsigned int)k;
+            s     += k;
+            n     -= k;
+        }
+
+        /* a newline, or the end of the row, moves to the next row */
+        if ( k == 0 || ( sc->cols && sc->x == sc->cols ) )
+        {
+            if ( format_screen_flush( sc ) < 0 )
+                return NULL;
+            if ( k == 0 )
             {
-                fspec.qual = DOUBLE_QUAL( fspec.qual );
-                INC_VOID_PTR(ptr);
+                s++;
+                n--;
             }
+            sc->x  = 0;
+            sc->sx = 0;
+            if ( ++sc->y == sc->rows )
+                sc->y = 0;
+        }
+    }
 
-            /* Continuation */
-            c = READ_CHAR( mode, ptr );
-            if ( c == '\0' )
-            {
-#if defined(CONFIG_HAVE_ALT_PTR)
-                if ( fspec.flags & FHASH )
-                {
-                    mode = ALT_PTR;
-                    ptr = va_arg( ap, ROM_PTR_T );
-                }
-                else
-                {
-                    mode = NORMAL_PTR;
+    return p;
+}
 #endif
-                    ptr = va_arg( ap, const char * );
-#if defined(CONFIG_HAVE_ALT_PTR)
-                }
+
+#if defined(CONFIG_WITH_FORMAT_CONV)
+/*****************************************************************************/
+/**
+    Perform one conversion that has already been parsed, reading its
+    arguments from a table.  This is the entry point for front ends which
+    parse the format string at compile time, such as format.hpp.
+
+    @param cons     Pointer to caller-provided consumer function.
+    @param parg     Pointer to opaque pointer passed through to cons, which
+                    is updated with the value cons returns.
+    @param pconv    Pointer to the parsed conversion.
+    @param args     The value to convert, followed by any grouping '*'
+                    arguments.  Must not be NULL, even if the conversion
+                    reads no arguments.
+    @param count    Number of characters already sent, for %n.
+
+    @return Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+int format_conv( void *    (* cons) (void *, const char * , size_t),
+                 void * *                   parg,
+                 const struct format_conv * pconv,
+                 const union format_arg *   args,
+                 unsigned int               count )
+{
+    T_FormatSpec fspec;
+    T_Args       ta;
+
+    if ( parg == NULL || pconv == NULL || args == NULL
+      || pconv->width > MAXWIDTH || pconv->prec > MAXPREC
+#if defined(CONFIG_WITH_CONV_BASE)
+      || pconv->base > MAXBASE
 #endif
-                continue;
-            }
+#if defined(CONFIG_WITH_CONV_K)
+      || pconv->xp_int > MAX_XP_INT || pconv->xp_frac > MAX_XP_FRAC
+      || pconv->xp_int + pconv->xp_frac >= MAX_XP_WIDTH
+#endif
+       )
+        return EXBADFORMAT;
 
-            convspec = c;
+    set_spec( &fspec, pconv );
+    fspec.nChars = count;
 
-            if ( convspec == 'C' )
-            {
-                c = READ_CHAR( mode, INC_VOID_PTR(ptr) );
-                if ( c == '\0' )
-                    goto exit_badformat;
-                fspec.repchar = c;
-            }
-            else
-            {
-                fspec.repchar = '\0';
-            }
+    ta.pos  = args;
+    ta.next = 0;
+#if defined(CONFIG_WITH_POSITIONAL)
+    ta.types    = NULL;
+    ta.numbered = 0;
+#endif
+#if defined(CONFIG_WITH_TYPED_ARGS)
+    ta.tags  = NULL;
+    ta.nargs = 0;
+#endif
 
-            /* now process the conversion type */
-            nn = do_conv( &fspec, &ap, convspec, cons, &arg );
-            if ( nn < 0 )
-                goto exit_badformat;
-            else
-                fspec.nChars += (unsigned int)nn;
+    return do_conv( &fspec, &ta, pconv->code, cons, parg );
+}
+#endif
 
-            INC_VOID_PTR(ptr);
-        }
-    }
+#if defined(CONFIG_WITH_TYPED_ARGS)
+/*****************************************************************************/
+/**
+    Interpret a format specification with arguments passed in a table, each
+    tagged with its type.  This is the engine behind the FORMAT() macro.
+    Each argument is checked against its conversion, and integer conversions
+    read the value as the type it was passed as.
 
-    va_end( ap );
-    return (int)fspec.nChars;
+    @param cons     Pointer to caller-provided consumer function.
+    @param arg      Opaque pointer passed through to cons.
+    @param fmt      Printf-compatible format specifier.
+    @param args     Table of arguments.
+    @param tags     FORMAT_ARG_ type of each argument.
+    @param nargs    Number of arguments.
 
-exit_badformat:
-    va_end( ap );
-    return EXBADFORMAT;
+    @return Number of characters sent to @a cons, or EXBADFORMAT if the
+            format is bad, or an argument is missing or of the wrong type.
+**/
+int format_args( void *    (* cons) (void *, const char * , size_t),
+                 void *                   arg,
+                 const char *             fmt,
+                 const union format_arg * args,
+                 const unsigned char *    tags,
+                 unsigned int             nargs )
+{
+    static const T_ArgValue    none = { 0 };
+    static const unsigned char notag = 0;
+    T_Args ta;
+
+    if ( fmt == NULL || ( nargs && ( args == NULL || tags == NULL ) ) )
+        return EXBADFORMAT;
+
+    /* ta.ap is never read: every argument comes from the table */
+    ta.pos   = nargs ? args : &none;
+    ta.next  = 0;
+    ta.tags  = nargs ? tags : &notag;
+    ta.nargs = nargs;
+#if defined(CONFIG_WITH_POSITIONAL)
+    ta.types    = NULL;
+    ta.numbered = (unsigned char)is_positional( fmt );
+#endif
+
+    return do_format( cons, arg, fmt, &ta );
 }
+#endif
 
 /*****************************************************************************/
 /*****************************************************************************/
@@ -33,11 +33,25 @@
 #define FORMAT_H
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /* Error code returned when problem with format specification */
 
 #define EXBADFORMAT             (-1)
 
+/**
+    Storage class of the functions declared below.  format_inline.h sets it
+    to "static inline" to build a private copy of the library.
+**/
+#ifndef FORMAT_API
+#define FORMAT_API              extern
+#endif
+
 /**
     Interpret format specification passing formatted text to consumer function.
     
@@ -53,12 +67,482 @@
     
     @returns            Number of characters sent to @a cons, or EXBADFORMAT.
 **/
-extern int format( void * (* /* cons */) (void *, const char *, size_t),
+FORMAT_API int format( void * (* /* cons */) (void *, const char *, size_t),
+             void *          /* arg  */,
+             const char *    /* fmt  */,
+             va_list         /* ap   */
+);
+
+/**
+    Scan text against a format specification, storing each converted value
+    through the pointer arguments @a ap, as scanf() does.  The conversions,
+    flags, grouping, :base and {fixed-point} modifiers are the same as for
+    format(), so the output of format() reads back with the same format
+    string.  Built when CONFIG_WITH_SCAN is defined.
+    
+    The text is read a block at a time from caller-provided producer
+    function @a prod, which is passed opaque pointer @a arg and stores the
+    length of the block it returns, or returns NULL at the end of the text.
+    If @a prod is NULL then @a arg is a null-terminated string.
+    
+    @param prod         Pointer to caller-provided producer function, or NULL.
+    @param arg          Opaque pointer passed through to @a prod.
+    @param fmt          printf-compatible format specifier.
+    @param ap           List of pointers to store the values through.
+    
+    @returns            Number of values stored, or EXBADFORMAT.
+**/
+FORMAT_API int format_scan( const char * (* /* prod */) (void *, size_t *),
              void *          /* arg  */,
              const char *    /* fmt  */,
              va_list         /* ap   */
 );
 
+/**
+    Flags of a parsed conversion, one for each flag character " +-#0!^".
+**/
+#define FORMAT_FSPACE           ( 0x01U )
+#define FORMAT_FPLUS            ( 0x02U )
+#define FORMAT_FMINUS           ( 0x04U )
+#define FORMAT_FHASH            ( 0x08U )
+#define FORMAT_FZERO            ( 0x10U )
+#define FORMAT_FBANG            ( 0x20U )
+#define FORMAT_FCARET           ( 0x40U )
+
+/**
+    Length qualifier of a parsed conversion for a doubled qualifier, such as
+    "hh" or "ll".  The valid qualifiers all have even ASCII values.
+**/
+#define FORMAT_DOUBLE_QUAL(q)   ( (q) | 1 )
+
+/**
+    A conversion specification, parsed from the text between the '%' and
+    the conversion character.  Any '*' has already been replaced with its
+    argument: a negative width is given as FORMAT_FMINUS and the magnitude.
+**/
+struct format_conv {
+    unsigned int    flags;        /**< FORMAT_F... flags                 **/
+    unsigned int    width;        /**< field width, or 0                 **/
+    int             prec;         /**< precision, or -1 if none          **/
+    unsigned int    base;         /**< numeric base, or 0 if none        **/
+    const char *    grouping;     /**< grouping spec inside [], or NULL  **/
+    size_t          grouping_len; /**< length of the grouping spec       **/
+    unsigned int    xp_int;       /**< fixed-point integer width         **/
+    unsigned int    xp_frac;      /**< fixed-point fractional width      **/
+    char            qual;         /**< length qualifier, or '\0'         **/
+    char            code;         /**< conversion character              **/
+    char            repchar;      /**< repeated character for %C         **/
+};
+
+/**
+    An argument of a parsed conversion, as the type that the conversion
+    reads.
+**/
+union format_arg {
+    int             i;
+    long            l;
+    long long       ll;
+    intmax_t        j;
+    size_t          z;
+    ptrdiff_t       t;
+    double          d;
+    void *          p;
+    const char *    s;
+};
+
+/**
+    Perform one conversion that has already been parsed, with no va_list and
+    no parsing at runtime.  Used by the C++ front end format.hpp, and built
+    when CONFIG_WITH_FORMAT_CONV is defined.
+    
+    @param cons         Pointer to caller-provided consumer function.
+    @param parg         Pointer to the opaque pointer passed through to
+                        @a cons, updated with each value @a cons returns.
+    @param conv         The parsed conversion.
+    @param args         The value to convert, then any grouping '*' values.
+    @param count        Number of characters already sent, for %n.
+    
+    @returns            Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+FORMAT_API int format_conv(
+             void * (* /* cons */) (void *, const char *, size_t),
+             void * *                   /* parg  */,
+             const struct format_conv * /* conv  */,
+             const union format_arg *   /* args  */,
+             unsigned int               /* count */
+);
+
+/**
+    Bind an unused conversion letter to a handler, so values of a custom
+    type are written in place by format().  The conversion reads one
+    pointer argument, and the handler is called with the consumer, the
+    parsed conversion and that pointer, returning the number of characters
+    sent or EXBADFORMAT.  The built-in conversions and the length qualifiers
+    cannot be rebound.  Built when CONFIG_WITH_CUSTOM_CONV is defined.
+    
+    @param code         Conversion letter.
+    @param handler      Handler for the conversion, or NULL to remove it.
+    
+    @returns            0 if successful, or EXBADFORMAT.
+**/
+FORMAT_API int format_register( char /* code */,
+             int (* /* handler */)( void * (*)(void *, const char *, size_t),
+                                    void * *,
+                                    const struct format_conv *,
+                                    const void * )
+);
+
+/**
+    Send the text of a custom conversion to the consumer, cut to the
+    precision and padded to the field width as for %s.  For use by the
+    handlers registered with format_register().
+    
+    @param cons         Pointer to caller-provided consumer function.
+    @param parg         Pointer to the opaque pointer passed through to
+                        @a cons, updated with each value @a cons returns.
+    @param conv         The conversion passed to the handler.
+    @param s            Pointer to the text.
+    @param n            Length of the text.
+    
+    @returns            Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+FORMAT_API int format_field(
+             void * (* /* cons */) (void *, const char *, size_t),
+             void * *                   /* parg  */,
+             const struct format_conv * /* conv  */,
+             const char *               /* s     */,
+             size_t                     /* n     */
+);
+
+/**
+    A conversion of a display template, with the argument it last converted.
+**/
+struct format_cell {
+    struct format_conv  conv;     /**< the parsed conversion             **/
+    union format_arg    value;    /**< its argument at the last update   **/
+    size_t              offset;   /**< start of its cell in the text     **/
+};
+
+/**
+    A display template: a format specification compiled once, with the
+    text it last rendered.  Clear valid to send the whole text again at the
+    next update, for example after the display has been cleared.
+**/
+struct format_template {
+    struct format_cell *  cells;  /**< the conversions, in order         **/
+    unsigned int          ncells; /**< number of conversions             **/
+    char *                text;   /**< the rendered text                 **/
+    size_t                len;    /**< length of the text                **/
+    int                   valid;  /**< text has been sent in full        **/
+};
+
+/**
+    Compile a format specification into a display template with a fixed
+    layout.  Each conversion which reads an argument must have a field
+    width, and is given a cell of that many characters in the text, which
+    is truncated to fit.  '*' widths, precisions and grouping, %n and
+    continuations are not allowed.  Built when CONFIG_WITH_TEMPLATE is
+    defined.
+    
+    @param t            Pointer to the template.
+    @param fmt          printf-compatible format specifier, which must stay
+                        valid for the life of the template.
+    @param cells        Array to hold the conversions.
+    @param maxcells     Number of elements in @a cells.
+    @param text         Buffer to hold the rendered text.
+    @param size         Size of @a text, including a null character.
+    
+    @returns            Number of conversions, or EXBADFORMAT.
+**/
+FORMAT_API int format_template_init( struct format_template * /* t        */,
+             const char *             /* fmt      */,
+             struct format_cell *     /* cells    */,
+             unsigned int             /* maxcells */,
+             char *                   /* text     */,
+             size_t                   /* size     */
+);
+
+/**
+    Update a display template with a new argument for each conversion.
+    Only the conversions whose arguments have changed are run again, and
+    only the characters which then change are passed to @a cons, as a span
+    of each changed cell with its offset in the text.  String and pointer
+    arguments are always converted again, as what they point to may have
+    changed.  The first update sends the whole text as one span.
+    
+    @param t            Pointer to the template.
+    @param cons         Pointer to caller-provided update function, passed
+                        the opaque pointer, the offset of the span, the
+                        span and its length.  It returns the opaque pointer
+                        for the next span, or NULL on failure.
+    @param arg          Opaque pointer passed through to @a cons.
+    @param ap           List of arguments, one for each conversion.
+    
+    @returns            Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+FORMAT_API int format_template_update( struct format_template * /* t    */,
+             void * (* /* cons */) (void *, size_t, const char *, size_t),
+             void *                   /* arg  */,
+             va_list                  /* ap   */
+);
+
+/**
+    A screen of character cells, such as a character LCD or a text
+    framebuffer, written a run of characters at a time by a row function:
+    
+        void * row( void * arg, unsigned int x, unsigned int y,
+                    const char * s, size_t n );
+    
+    which writes the @a n characters @a s to row @a y from column @a x, and
+    returns the opaque pointer for the next call, or NULL on failure.
+**/
+struct format_screen {
+    void * (* row) (void *, unsigned int, unsigned int, const char *, size_t);
+    void *          arg;    /**< opaque pointer passed to row            **/
+    unsigned int    cols;   /**< columns, at which output wraps, or 0    **/
+    unsigned int    rows;   /**< rows, after which output wraps, or 0    **/
+    char *          line;   /**< staging buffer of cols characters, or NULL **/
+    unsigned int    x;      /**< column of the next character            **/
+    unsigned int    y;      /**< row of the next character               **/
+    unsigned int    sx;     /**< first staged column                     **/
+};
+
+/**
+    Set up a screen for positioned output, at row 0 column 0.  Built when
+    CONFIG_WITH_SCREEN is defined.
+    
+    @param sc           Pointer to the screen.
+    @param row          Pointer to caller-provided row function.
+    @param arg          Opaque pointer passed through to @a row.
+    @param cols         Number of columns, or 0 for rows of any length.
+    @param rows         Number of rows, after which output wraps to the top
+                        row, or 0 for no limit.
+    @param line         Buffer of @a cols characters, to gather each row
+                        into a single call of @a row, or NULL.
+**/
+FORMAT_API void format_screen_init( struct format_screen * /* sc   */,
+             void * (* /* row */) (void *, unsigned int, unsigned int,
+                                   const char *, size_t),
+             void *                 /* arg  */,
+             unsigned int           /* cols */,
+             unsigned int           /* rows */,
+             char *                 /* line */
+);
+
+/**
+    Consumer function for format() which writes to a screen, passed as
+    @a cons with the screen as @a arg.  Output is split into a run for each
+    row, wrapping at the last column, and a newline moves to the start of
+    the next row.  With a staging buffer each row is sent once, when output
+    moves off it or format_screen_flush() is called.
+    
+    @param sc           Pointer to the screen.
+    @param s            Pointer to characters to write.
+    @param n            Number of characters.
+    
+    @returns            @a sc, or NULL if @a row failed.
+**/
+FORMAT_API void * format_screen_put( void *       /* sc */,
+             const char * /* s  */,
+             size_t       /* n  */
+);
+
+/**
+    Send any characters staged in the current row of a screen.
+    
+    @param sc           Pointer to the screen.
+    
+    @returns            0, or EXBADFORMAT if @a row failed.
+**/
+FORMAT_API int format_screen_flush( struct format_screen * /* sc */ );
+
+/**
+    Move the output position of a screen, after sending any staged
+    characters.
+    
+    @param sc           Pointer to the screen.
+    @param x            Column.
+    @param y            Row.
+    
+    @returns            0, or EXBADFORMAT if @a row failed.
+**/
+FORMAT_API int format_screen_move( struct format_screen * /* sc */,
+             unsigned int           /* x  */,
+             unsigned int           /* y  */
+);
+
+/**
+    Types of the arguments passed to format_args().
+**/
+enum format_arg_type {
+    FORMAT_ARG_INT = 1,         /**< int and narrower integers, in i    **/
+    FORMAT_ARG_LONG,            /**< long and unsigned long, in l       **/
+    FORMAT_ARG_LLONG,           /**< long long and unsigned, in ll      **/
+    FORMAT_ARG_DOUBLE,          /**< float and double, in d             **/
+    FORMAT_ARG_PTR,             /**< other pointers, in p               **/
+    FORMAT_ARG_STR              /**< char pointers, in s                **/
+};
+
+/**
+    Interpret format specification with arguments passed in a table, each
+    tagged with its type, instead of a va_list.  Each argument is checked
+    against the conversion that reads it.  An integer conversion reads the
+    value as the type it was passed as, so a length qualifier is not needed.
+    Built when CONFIG_WITH_TYPED_ARGS is defined, and normally called
+    through the FORMAT() macro below.
+    
+    @param cons         Pointer to caller-provided consumer function.
+    @param arg          Opaque pointer passed through to @a cons.
+    @param fmt          printf-compatible format specifier.
+    @param args         Table of arguments.
+    @param tags         FORMAT_ARG_ type of each argument.
+    @param nargs        Number of arguments.
+    
+    @returns            Number of characters sent to @a cons, or EXBADFORMAT
+                        if the format is bad or an argument is missing or of
+                        the wrong type.
+**/
+FORMAT_API int format_args(
+             void * (* /* cons */) (void *, const char *, size_t),
+             void *                   /* arg   */,
+             const char *             /* fmt   */,
+             const union format_arg * /* args  */,
+             const unsigned char *    /* tags  */,
+             unsigned int             /* nargs */
+);
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__cplusplus)
+/**
+    FORMAT( cons, arg, fmt, ... ) calls format_args() with up to 16
+    arguments, building the table and the type of each argument at the call
+    site with _Generic.  Floats and short integers are stored without the
+    default argument promotions of a variable argument list, and an argument
+    which cannot be formatted, such as a structure or a long double, is a
+    compile-time error.
+    
+        n = FORMAT( cons, arg, "%s: %d of %d", name, i, (long)total );
+**/
+#define FORMAT(cons, arg, ...)                                              \
+    FORMAT_APPLY( format_args, (cons), (arg), __VA_ARGS__ )
+
+/**
+    FORMAT_APPLY( func, a, b, fmt, ... ) calls func( a, b, fmt, args, tags,
+    nargs ) with the table built as for FORMAT(), for functions which take
+    their arguments in the same way as format_args().
+**/
+#define FORMAT_APPLY(func, a, b, ...)                                       \
+    FORMAT_CAT_( FORMAT_CALL_, FORMAT_COUNT_( __VA_ARGS__ ) )               \
+        ( func, a, b, __VA_ARGS__ )
+
+/* Store one argument in the table, and its type */
+static inline union format_arg format_arg_i( int v )
+    { union format_arg a; a.i = v; return a; }
+static inline union format_arg format_arg_l( long v )
+    { union format_arg a; a.l = v; return a; }
+static inline union format_arg format_arg_ll( long long v )
+    { union format_arg a; a.ll = v; return a; }
+static inline union format_arg format_arg_d( double v )
+    { union format_arg a; a.d = v; return a; }
+static inline union format_arg format_arg_p( const volatile void *v )
+    { union format_arg a; a.p = (void *)v; return a; }
+static inline union format_arg format_arg_s( const char *v )
+    { union format_arg a; a.s = v; return a; }
+
+#define FORMAT_VALUE_(x)                                                    \
+    _Generic( (x),                                                          \
+        _Bool: format_arg_i, char: format_arg_i,                            \
+        signed char: format_arg_i, unsigned char: format_arg_i,             \
+        short: format_arg_i, unsigned short: format_arg_i,                  \
+        int: format_arg_i, unsigned int: format_arg_i,                      \
+        long: format_arg_l, unsigned long: format_arg_l,                    \
+        long long: format_arg_ll, unsigned long long: format_arg_ll,        \
+        float: format_arg_d, double: format_arg_d,                          \
+        char *: format_arg_s, const char *: format_arg_s,                   \
+        default: format_arg_p )( x )
+
+#define FORMAT_TYPE_(x)                                                     \
+    _Generic( (x),                                                          \
+        _Bool: FORMAT_ARG_INT, char: FORMAT_ARG_INT,                        \
+        signed char: FORMAT_ARG_INT, unsigned char: FORMAT_ARG_INT,         \
+        short: FORMAT_ARG_INT, unsigned short: FORMAT_ARG_INT,              \
+        int: FORMAT_ARG_INT, unsigned int: FORMAT_ARG_INT,                  \
+        long: FORMAT_ARG_LONG, unsigned long: FORMAT_ARG_LONG,              \
+        long long: FORMAT_ARG_LLONG, unsigned long long: FORMAT_ARG_LLONG,  \
+        float: FORMAT_ARG_DOUBLE, double: FORMAT_ARG_DOUBLE,                \
+        char *: FORMAT_ARG_STR, const char *: FORMAT_ARG_STR,               \
+        default: FORMAT_ARG_PTR )
+
+/* Count the arguments after the format string, up to 16 */
+#define FORMAT_COUNT_(...)                                                  \
+    FORMAT_COUNT_N_( __VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6,  \
+                     5, 4, 3, 2, 1, 0, ~ )
+#define FORMAT_COUNT_N_(f, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11,   \
+                        a12, a13, a14, a15, a16, n, ...) n
+
+#define FORMAT_CAT_(a, b)     FORMAT_CAT2_( a, b )
+#define FORMAT_CAT2_(a, b)    a ## b
+
+/* Apply m to each argument, separated by commas */
+#define FORMAT_MAP_1(m, x)       m(x)
+#define FORMAT_MAP_2(m, x, ...)  m(x), FORMAT_MAP_1( m, __VA_ARGS__ )
+#define FORMAT_MAP_3(m, x, ...)  m(x), FORMAT_MAP_2( m, __VA_ARGS__ )
+#define FORMAT_MAP_4(m, x, ...)  m(x), FORMAT_MAP_3( m, __VA_ARGS__ )
+#define FORMAT_MAP_5(m, x, ...)  m(x), FORMAT_MAP_4( m, __VA_ARGS__ )
+#define FORMAT_MAP_6(m, x, ...)  m(x), FORMAT_MAP_5( m, __VA_ARGS__ )
+#define FORMAT_MAP_7(m, x, ...)  m(x), FORMAT_MAP_6( m, __VA_ARGS__ )
+#define FORMAT_MAP_8(m, x, ...)  m(x), FORMAT_MAP_7( m, __VA_ARGS__ )
+#define FORMAT_MAP_9(m, x, ...)  m(x), FORMAT_MAP_8( m, __VA_ARGS__ )
+#define FORMAT_MAP_10(m, x, ...) m(x), FORMAT_MAP_9( m, __VA_ARGS__ )
+#define FORMAT_MAP_11(m, x, ...) m(x), FORMAT_MAP_10( m, __VA_ARGS__ )
+#define FORMAT_MAP_12(m, x, ...) m(x), FORMAT_MAP_11( m, __VA_ARGS__ )
+#define FORMAT_MAP_13(m, x, ...) m(x), FORMAT_MAP_12( m, __VA_ARGS__ )
+#define FORMAT_MAP_14(m, x, ...) m(x), FORMAT_MAP_13( m, __VA_ARGS__ )
+#define FORMAT_MAP_15(m, x, ...) m(x), FORMAT_MAP_14( m, __VA_ARGS__ )
+#define FORMAT_MAP_16(m, x, ...) m(x), FORMAT_MAP_15( m, __VA_ARGS__ )
+
+#define FORMAT_CALL_0(func, a, b, fmt)                                      \
+    func( a, b, fmt, NULL, NULL, 0 )
+#define FORMAT_CALL_N_(n, func, a, b, fmt, ...)                             \
+    func( a, b, fmt,                                                        \
+        (const union format_arg[]){                                         \
+            FORMAT_MAP_ ## n( FORMAT_VALUE_, __VA_ARGS__ ) },               \
+        (const unsigned char[]){                                            \
+            FORMAT_MAP_ ## n( FORMAT_TYPE_, __VA_ARGS__ ) },                \
+        n )
+#define FORMAT_CALL_1(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 1, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_2(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 2, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_3(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 3, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_4(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 4, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_5(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 5, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_6(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 6, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_7(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 7, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_8(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 8, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_9(g, a, b, f, ...)                                      \
+    FORMAT_CALL_N_( 9, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_10(g, a, b, f, ...)                                     \
+    FORMAT_CALL_N_( 10, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_11(g, a, b, f, ...)                                     \
+    FORMAT_CALL_N_( 11, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_12(g, a, b, f, ...)                                     \
+    FORMAT_CALL_N_( 12, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_13(g, a, b, f, ...)                                     \
+    FORMAT_CALL_N_( 13, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_14(g, a, b, f, ...)                                     \
+    FORMAT_CALL_N_( 14, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_15(g, a, b, f, ...)                                     \
+    FORMAT_CALL_N_( 15, g, a, b, f, __VA_ARGS__ )
+#define FORMAT_CALL_16(g, a, b, f, ...)                                     \
+    FORMAT_CALL_N_( 16, g, a, b, f, __VA_ARGS__ )
+#endif
+
 /*    The Consumer Function
  *
  * The consumer function 'cons' must have the following type:
@@ -75,4 +559,8 @@ extern int format( void * (* /* cons */) (void *, const char *, size_t),
  * In case of an error, the function returns NULL.
  */
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
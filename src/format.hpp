@@ -0,0 +1,723 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2010-2023, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+#ifndef FORMAT_HPP
+#define FORMAT_HPP
+
+/**
+    Type-safe C++17 front end to format.
+
+    The format string is parsed at compile time into a list of text and
+    conversion segments, and every argument is checked against the type the
+    conversion reads.  At runtime the arguments are stored in a table and
+    each conversion is passed straight to format_conv(), with no va_list and
+    no parsing.  format.c, and each file including this one, must be built
+    with CONFIG_WITH_FORMAT_CONV, which is not in the default configuration.
+
+        formatpp::format( cons, arg, FORMAT_STRING( "%-8s|%[,3]d" ), s, n );
+
+    With C++20 the format string may instead be a template argument:
+
+        formatpp::format<"%-8s|%[,3]d">( cons, arg, s, n );
+
+    Errors in the format string, and arguments of the wrong type or number,
+    stop the compilation.  Integer and floating point arguments may be of any
+    type no wider than the one the conversion reads.
+**/
+
+#include <array>
+#include <climits>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "format.h"
+#include "format_config.h"
+
+#if !defined(CONFIG_WITH_FORMAT_CONV)
+#error "format.hpp needs CONFIG_WITH_FORMAT_CONV"
+#endif
+
+namespace formatpp {
+
+/** The consumer function, as for format() **/
+typedef void * (* consumer)( void *, const char *, size_t );
+
+namespace detail {
+
+/*****************************************************************************/
+/* Parsed format strings                                                     */
+/*****************************************************************************/
+
+/** Kinds of segment **/
+enum : unsigned char { SEG_TEXT, SEG_CONV, SEG_CONT };
+
+/** Fields given by a '*', each reading an int argument before the value **/
+enum : unsigned char { STAR_WIDTH   = 0x01, STAR_PREC    = 0x02,
+                       STAR_BASE    = 0x04, STAR_XP_INT  = 0x08,
+                       STAR_XP_FRAC = 0x10 };
+
+/** Types of argument, as read by the conversions.  ARG_WSTR is the wide
+    string read by %ls, and the ARG_N_ types are the pointers written by
+    %n. **/
+enum : unsigned char { ARG_NONE, ARG_INT, ARG_LONG, ARG_LLONG, ARG_INTMAX,
+                       ARG_SIZE, ARG_PTRDIFF, ARG_DOUBLE, ARG_PTR, ARG_STR,
+                       ARG_WSTR, ARG_N_SCHAR, ARG_N_SHORT, ARG_N_INT, ARG_N_LONG,
+                       ARG_N_LLONG, ARG_N_INTMAX, ARG_N_SIZE, ARG_N_PTRDIFF };
+
+/** Limits, as in format.c **/
+constexpr unsigned int MAXWIDTH     = 500;
+constexpr unsigned int MAXPREC      = 500;
+constexpr unsigned int MAXBASE      = 36;
+constexpr unsigned int MAX_XP_INT   = sizeof( int ) * CHAR_BIT;
+constexpr unsigned int MAX_XP_FRAC  = sizeof( int ) * CHAR_BIT;
+constexpr unsigned int MAX_XP_WIDTH = sizeof( long ) * CHAR_BIT;
+
+/**
+    One segment of a parsed format string: a run of text, a conversion, or
+    the continuation which ends the format string.
+**/
+struct segment {
+    unsigned char      kind;   /**< SEG_ kind                            **/
+    unsigned char      stars;  /**< STAR_ fields read from arguments     **/
+    unsigned char      ngroup; /**< grouping '*' arguments after value   **/
+    unsigned char      type;   /**< ARG_ type of the value               **/
+    std::size_t        pos;    /**< offset of the text or grouping spec  **/
+    std::size_t        len;    /**< length of the text or grouping spec  **/
+    std::size_t        argn;   /**< index of the first argument read     **/
+    struct format_conv conv;   /**< the conversion, less any '*' fields  **/
+};
+
+/** Base of the format string types made by FORMAT_STRING **/
+struct string_tag {};
+
+/** Report an error in a format string.  Not constexpr, so calling it during
+    constant evaluation stops the compilation at the call. **/
+inline void format_string_error( const char * ) {}
+
+constexpr bool is_digit( char c ) { return '0' <= c && c <= '9'; }
+
+constexpr bool is_in( const char *set, char c )
+{
+    for ( ; *set; set++ )
+        if ( *set == c )
+            return true;
+    return false;
+}
+
+/**
+    Read a decimal number from the format string.
+**/
+constexpr unsigned int number( const char *s, std::size_t n, std::size_t &i )
+{
+    unsigned int v = 0;
+
+    for ( ; i < n && is_digit( s[i] ); i++ )
+        if ( ( v = v * 10 + (unsigned int)( s[i] - '0' ) ) > 10000 )
+            format_string_error( "number too large" );
+    return v;
+}
+
+/**
+    Work out the type of the value a conversion reads, following the
+    conversion handlers in format.c.
+**/
+constexpr unsigned char value_type( const struct format_conv &c )
+{
+    const char q = c.qual;
+
+    if ( c.code == 'n' )
+        return q == 'h'                      ? ARG_N_SHORT
+             : q == FORMAT_DOUBLE_QUAL( 'h' ) ? ARG_N_SCHAR
+             : q == 'l'                      ? ARG_N_LONG
+             : q == FORMAT_DOUBLE_QUAL( 'l' ) ? ARG_N_LLONG
+             : q == 'j'                      ? ARG_N_INTMAX
+             : q == 'z'                      ? ARG_N_SIZE
+             : q == 't'                      ? ARG_N_PTRDIFF
+             :                                 ARG_N_INT;
+    if ( c.code == 'c' )
+        return ARG_INT;
+    if ( c.code == 'C' || c.code == '%' )
+        return ARG_NONE;
+    if ( c.code == 's' && q == 'l' )
+        return ARG_WSTR;
+    if ( c.code == 's' || c.code == 'q' )
+        return ARG_STR;
+    if ( c.code == 'p' || c.code == 'M'
+         || ( c.code == 'N' && ( c.flags & FORMAT_FHASH ) ) )
+        return ARG_PTR;
+    if ( c.code == 'N' )
+        return sizeof( uint32_t ) <= sizeof( int ) ? ARG_INT : ARG_LONG;
+    if ( is_in( "aAeEfFgG", c.code ) )
+        return ARG_DOUBLE;
+    if ( c.code == 'T' )
+        return ARG_LLONG;
+    if ( c.code == 'k' )
+        return ( c.xp_int + c.xp_frac + 7 ) / 8 <= sizeof( int )
+               ? ARG_INT : ARG_LONG;
+
+    return q == FORMAT_DOUBLE_QUAL( 'l' ) ? ARG_LLONG
+         : q == 'l'                      ? ARG_LONG
+         : q == 'j'                      ? ARG_INTMAX
+         : q == 'z'                      ? ARG_SIZE
+         : q == 't'                      ? ARG_PTRDIFF
+         :                                 ARG_INT;
+}
+
+/**
+    Parse the segment of format string @a s starting at @a i, following the
+    grammar of format() in format.c.
+
+    @param s        Format string.
+    @param n        Length of the format string.
+    @param i        Offset of the segment, moved past it.
+    @param argn     Index of the next argument, moved past those read.
+
+    @return The segment.
+**/
+constexpr segment parse_segment( const char *s, std::size_t n,
+                                 std::size_t &i, std::size_t &argn )
+{
+    segment g { SEG_TEXT, 0, 0, ARG_NONE, i, 0, argn, {} };
+    struct format_conv &c = g.conv;
+
+    if ( s[i] != '%' )
+    {
+        while ( i < n && s[i] != '%' )
+            i++;
+        g.len = i - g.pos;
+        return g;
+    }
+
+    if ( ++i < n && s[i] == '%' )
+    {
+        g.pos = i++;
+        g.len = 1;
+        return g;
+    }
+
+    /* argument numbers */
+    for ( std::size_t j = i; j < n && is_digit( s[j] ); j++ )
+        if ( s[j + 1] == '$' )
+            format_string_error( "positional arguments are not supported" );
+
+    /* flags */
+    for ( ; i < n && is_in( " +-#0!^", s[i] ); i++ )
+    {
+        const char *fc = " +-#0!^";
+        unsigned int k = 0;
+
+        while ( fc[k] != s[i] )
+            k++;
+        c.flags |= 1U << k;
+    }
+
+    /* width */
+    if ( i < n && s[i] == '*' )
+    {
+        g.stars |= STAR_WIDTH;
+        i++;
+    }
+    else if ( ( c.width = number( s, n, i ) ) > MAXWIDTH )
+        format_string_error( "width too large" );
+
+    /* precision */
+    c.prec = -1;
+    if ( i < n && s[i] == '.' )
+    {
+        if ( ++i < n && s[i] == '*' )
+        {
+            g.stars |= STAR_PREC;
+            i++;
+        }
+        else if ( ( c.prec = (int)number( s, n, i ) ) > (int)MAXPREC )
+            format_string_error( "precision too large" );
+    }
+
+    /* base */
+    if ( i < n && s[i] == ':' )
+    {
+        if ( ++i < n && s[i] == '*' )
+        {
+            g.stars |= STAR_BASE;
+            i++;
+        }
+        else if ( ( c.base = number( s, n, i ) ) > MAXBASE || c.base == 1 )
+            format_string_error( "invalid base" );
+    }
+
+    /* grouping or fixed-point modifier */
+    c.xp_int  = 16;
+    c.xp_frac = 16;
+    if ( i < n && s[i] == '[' )
+    {
+        g.pos = ++i;
+        while ( i < n && s[i] != ']' )
+            if ( s[i++] == '*' )
+                g.ngroup++;
+        if ( i == n )
+            format_string_error( "missing ] in grouping modifier" );
+        g.len = i++ - g.pos;
+        c.grouping_len = g.len;
+    }
+    else if ( i < n && s[i] == '{' )
+    {
+        if ( ++i < n && s[i] == '*' )
+        {
+            g.stars |= STAR_XP_INT;
+            i++;
+        }
+        else if ( ( c.xp_int = number( s, n, i ) ) > MAX_XP_INT )
+            format_string_error( "fixed-point integer width too large" );
+
+        if ( i == n || s[i] != '.' )
+            format_string_error( "missing . in fixed-point modifier" );
+
+        if ( ++i < n && s[i] == '*' )
+        {
+            g.stars |= STAR_XP_FRAC;
+            i++;
+        }
+        else if ( ( c.xp_frac = number( s, n, i ) ) > MAX_XP_FRAC )
+            format_string_error( "fixed-point fraction width too large" );
+
+        if ( c.xp_int + c.xp_frac >= MAX_XP_WIDTH )
+            format_string_error( "fixed-point modifier too wide" );
+        if ( i == n || s[i] != '}' )
+            format_string_error( "missing } in fixed-point modifier" );
+        i++;
+    }
+
+    /* length qualifier */
+    if ( i < n && is_in( "hljztL", s[i] ) )
+    {
+        c.qual = s[i++];
+        if ( i < n && s[i] == c.qual )
+        {
+            c.qual = FORMAT_DOUBLE_QUAL( c.qual );
+            i++;
+        }
+    }
+
+    for ( unsigned int b = g.stars; b; b >>= 1 )
+        argn += b & 1;
+
+    /* continuation */
+    if ( i == n )
+    {
+        g.kind = SEG_CONT;
+        g.type = ARG_STR;
+        argn++;
+        return g;
+    }
+
+    c.code = s[i++];
+    if ( !is_in( "%cCsqnpdiIuUxXobeEfFgGaAkTNM", c.code ) )
+        format_string_error( "unknown conversion" );
+    if ( c.code == 'C' )
+    {
+        if ( i == n )
+            format_string_error( "missing character for %C" );
+        c.repchar = s[i++];
+    }
+
+    /* grouping only applies to the integer conversions */
+    if ( !is_in( "bdiIouUxXp", c.code ) )
+        g.ngroup = 0;
+
+    g.kind = SEG_CONV;
+    g.type = value_type( c );
+    argn  += ( g.type != ARG_NONE ) + g.ngroup;
+    return g;
+}
+
+/**
+    Count the segments and arguments of a format string.
+**/
+struct counts {
+    std::size_t segments;
+    std::size_t args;
+    bool        cont;
+};
+
+constexpr counts count( const char *s, std::size_t n )
+{
+    counts t { 0, 0, false };
+
+    for ( std::size_t i = 0; i < n; t.segments++ )
+        t.cont = parse_segment( s, n, i, t.args ).kind == SEG_CONT;
+    return t;
+}
+
+/**
+    A format string parsed at compile time.
+
+    @param Str      Format string type, made by FORMAT_STRING.
+**/
+template <class Str>
+struct parsed {
+    static constexpr counts n = count( Str::str(), Str::len() );
+
+    static constexpr std::array<segment, n.segments> segments_of()
+    {
+        std::array<segment, n.segments> a {};
+        std::size_t i = 0, argn = 0;
+
+        for ( std::size_t k = 0; k < n.segments; k++ )
+            a[k] = parse_segment( Str::str(), Str::len(), i, argn );
+        return a;
+    }
+
+    static constexpr std::array<unsigned char, n.args + 1> types_of()
+    {
+        std::array<unsigned char, n.args + 1> t {};
+
+        for ( const segment &g : segments )
+        {
+            std::size_t a = g.argn;
+
+            for ( unsigned int b = g.stars; b; b >>= 1 )
+                if ( b & 1 )
+                    t[a++] = ARG_INT;
+            if ( g.type != ARG_NONE )
+                t[a++] = g.type;
+            for ( unsigned int k = 0; k < g.ngroup; k++ )
+                t[a++] = ARG_INT;
+        }
+        return t;
+    }
+
+    static constexpr std::array<segment, n.segments>       segments = segments_of();
+    static constexpr std::array<unsigned char, n.args + 1> types    = types_of();
+
+    /** The type of argument @a i, or ARG_NONE after a continuation **/
+    static constexpr unsigned char type( std::size_t i )
+    {
+        return i < n.args ? types[i] : (unsigned char)ARG_NONE;
+    }
+};
+
+/*****************************************************************************/
+/* Arguments                                                                 */
+/*****************************************************************************/
+
+/** An integer or enum no wider than @a T **/
+template <class A, class T>
+constexpr bool fits = ( std::is_integral<A>::value || std::is_enum<A>::value )
+                      && sizeof( A ) <= sizeof( T );
+
+/** A pointer to an object, rather than to a function **/
+template <class A>
+constexpr bool object_ptr = std::is_pointer<A>::value
+    && !std::is_function<typename std::remove_pointer<A>::type>::value;
+
+/** A pointer to a modifiable integer the size of @a T **/
+template <class A, class T>
+constexpr bool counter = std::is_pointer<A>::value
+    && std::is_integral<typename std::remove_pointer<A>::type>::value
+    && !std::is_const<typename std::remove_pointer<A>::type>::value
+    && sizeof( typename std::remove_pointer<A>::type ) == sizeof( T );
+
+/**
+    Store argument @a a in the argument table as type @a T reads it, and
+    check at compile time that it has a suitable type.
+**/
+template <unsigned char T, class A>
+union format_arg make_arg( A a )
+{
+    union format_arg v {};
+
+    if constexpr ( T == ARG_INT )
+    {
+        static_assert( fits<A, int>, "format: argument must be an int" );
+        v.i = static_cast<int>( a );
+    }
+    else if constexpr ( T == ARG_LONG )
+    {
+        static_assert( fits<A, long>, "format: argument must be a long" );
+        v.l = static_cast<long>( a );
+    }
+    else if constexpr ( T == ARG_LLONG )
+    {
+        static_assert( fits<A, long long>, "format: argument must be a long long" );
+        v.ll = static_cast<long long>( a );
+    }
+    else if constexpr ( T == ARG_INTMAX )
+    {
+        static_assert( fits<A, intmax_t>, "format: argument must be an intmax_t" );
+        v.j = static_cast<intmax_t>( a );
+    }
+    else if constexpr ( T == ARG_SIZE )
+    {
+        static_assert( fits<A, size_t>, "format: argument must be a size_t" );
+        v.z = static_cast<size_t>( a );
+    }
+    else if constexpr ( T == ARG_PTRDIFF )
+    {
+        static_assert( fits<A, ptrdiff_t>, "format: argument must be a ptrdiff_t" );
+        v.t = static_cast<ptrdiff_t>( a );
+    }
+    else if constexpr ( T == ARG_DOUBLE )
+    {
+        static_assert( std::is_floating_point<A>::value && sizeof( A ) <= sizeof( double ),
+                       "format: argument must be a float or double" );
+        v.d = static_cast<double>( a );
+    }
+    else if constexpr ( T == ARG_PTR )
+    {
+        static_assert( object_ptr<A> || std::is_null_pointer<A>::value,
+                       "format: argument must be a pointer to an object" );
+        if constexpr ( object_ptr<A> || std::is_null_pointer<A>::value )
+            v.p = const_cast<void *>( static_cast<const volatile void *>( a ) );
+    }
+    else if constexpr ( T == ARG_STR )
+    {
+        static_assert( std::is_same<typename std::remove_cv<
+                           typename std::remove_pointer<A>::type>::type, char>::value
+                       || std::is_null_pointer<A>::value,
+                       "format: argument must be a string" );
+        v.s = a;
+    }
+    else if constexpr ( T == ARG_WSTR )
+    {
+        static_assert( std::is_same<typename std::remove_cv<
+                           typename std::remove_pointer<A>::type>::type, wchar_t>::value
+                       || std::is_null_pointer<A>::value,
+                       "format: %ls argument must be a wide string" );
+        v.p = const_cast<void *>( static_cast<const void *>( a ) );
+    }
+    else if constexpr ( T >= ARG_N_SCHAR )
+    {
+        static_assert( counter<A, typename std::conditional<T == ARG_N_SCHAR, signed char,
+                         typename std::conditional<T == ARG_N_SHORT, short,
+                         typename std::conditional<T == ARG_N_INT, int,
+                         typename std::conditional<T == ARG_N_LONG, long,
+                         typename std::conditional<T == ARG_N_LLONG, long long,
+                         typename std::conditional<T == ARG_N_INTMAX, intmax_t,
+                         typename std::conditional<T == ARG_N_SIZE, size_t,
+                         ptrdiff_t>::type>::type>::type>::type>::type>::type>::type>,
+                       "format: %n argument must point to an integer of the qualified size" );
+        v.p = a;
+    }
+    return v;
+}
+
+/**
+    Call format() with a C variable argument list, for the continuation.
+**/
+inline int format_va( consumer cons, void *arg, const char *fmt, ... )
+{
+    va_list ap;
+    int     n;
+
+    va_start( ap, fmt );
+    n = ::format( cons, arg, fmt, ap );
+    va_end( ap );
+    return n;
+}
+
+/**
+    Run the continuation: pass the continuation string, which is argument
+    @a K - 1, and the arguments after it to format() at runtime.
+**/
+template <std::size_t K, class A0, class... As>
+int continuation( consumer cons, void *arg, const char *fmt, A0 a0, As... as )
+{
+    if constexpr ( K > 1 )
+        return continuation<K - 1>( cons, arg, fmt, as... );
+    else
+    {
+        static_assert( ( std::is_trivially_copyable<As>::value && ... ),
+                       "format: continuation arguments must be trivially copyable" );
+        return format_va( cons, arg, fmt, a0, as... );
+    }
+}
+
+/**
+    Execute a parsed format string.
+
+    @return Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+template <class Str, class... Args, std::size_t... I>
+int run( consumer cons, void *arg, std::index_sequence<I...>, Args... args )
+{
+    typedef parsed<Str> P;
+    const union format_arg table[sizeof...(Args) + 1] = {
+        make_arg<P::type( I )>( args )..., {} };
+    unsigned int count = 0;
+
+    for ( const segment &g : P::segments )
+    {
+        int n = 0;
+
+        if ( g.kind == SEG_TEXT )
+        {
+            if ( ( arg = cons( arg, Str::str() + g.pos, g.len ) ) == NULL )
+                return EXBADFORMAT;
+            n = (int)g.len;
+        }
+        else if ( g.kind == SEG_CONT )
+        {
+            if constexpr ( P::n.cont )
+                n = continuation<P::n.args>( cons, arg,
+                        ( g.conv.flags & FORMAT_FHASH ) ? "%#" : "%", args... );
+        }
+        else
+        {
+            struct format_conv c = g.conv;
+            const union format_arg *a = table + g.argn;
+
+            if ( g.stars & STAR_WIDTH )
+            {
+                int w = (a++)->i;
+
+                if ( w < 0 )
+                {
+                    w = -w;
+                    c.flags |= FORMAT_FMINUS;
+                }
+                c.width = (unsigned int)w;
+            }
+            if ( g.stars & STAR_PREC )
+                c.prec = (a++)->i;
+            if ( g.stars & STAR_BASE )
+            {
+                int v = (a++)->i;
+
+                c.base = v < 0 ? 0 : (unsigned int)v;
+            }
+            if ( g.stars & STAR_XP_INT )
+            {
+                int v = (a++)->i;
+
+                c.xp_int = v < 0 ? 0 : (unsigned int)v;
+            }
+            if ( g.stars & STAR_XP_FRAC )
+            {
+                int v = (a++)->i;
+
+                c.xp_frac = v < 0 ? 0 : (unsigned int)v;
+            }
+            if ( g.len )
+                c.grouping = Str::str() + g.pos;
+
+            n = format_conv( cons, &arg, &c, a, count );
+        }
+
+        if ( n < 0 )
+            return EXBADFORMAT;
+        count += (unsigned int)n;
+    }
+
+    return (int)count;
+}
+
+} /* namespace detail */
+
+/*****************************************************************************/
+/**
+    Interpret a format string, parsed at compile time, passing formatted text
+    to consumer function @a cons.
+
+    @param cons     Pointer to caller-provided consumer function.
+    @param arg      Opaque pointer passed through to @a cons.
+    @param fmt      Format string, made by FORMAT_STRING.
+    @param args     Arguments, checked against the format string.
+
+    @return Number of characters sent to @a cons, or EXBADFORMAT.
+**/
+template <class Str, class... Args,
+          class = typename std::enable_if<
+                      std::is_base_of<detail::string_tag, Str>::value>::type>
+int format( consumer cons, void *arg, Str, Args... args )
+{
+    typedef detail::parsed<Str> P;
+
+    static_assert( sizeof...(Args) >= P::n.args,
+                   "format: too few arguments for the format string" );
+    static_assert( sizeof...(Args) <= P::n.args || P::n.cont,
+                   "format: too many arguments for the format string" );
+
+    return detail::run<Str>( cons, arg, std::index_sequence_for<Args...>(),
+                             args... );
+}
+
+#if __cplusplus >= 202002L
+namespace detail {
+
+/** A string literal as a template argument **/
+template <std::size_t N>
+struct fixed_string {
+    char s[N];
+
+    constexpr fixed_string( const char ( &a )[N] )
+    {
+        for ( std::size_t i = 0; i < N; i++ )
+            s[i] = a[i];
+    }
+};
+
+template <fixed_string F>
+struct fixed_format : string_tag {
+    static constexpr const char *str() { return F.s; }
+    static constexpr std::size_t len() { return sizeof( F.s ) - 1; }
+};
+
+} /* namespace detail */
+
+/*****************************************************************************/
+/**
+    As format() above, with the format string as a template argument.
+**/
+template <detail::fixed_string F, class... Args>
+int format( consumer cons, void *arg, Args... args )
+{
+    return format( cons, arg, detail::fixed_format<F>(), args... );
+}
+#endif
+
+} /* namespace formatpp */
+
+/**
+    Make a format string type from string literal @a s, to pass to
+    formatpp::format().
+**/
+#define FORMAT_STRING(s)                                                    \
+    ( [] {                                                                  \
+        struct fmt : ::formatpp::detail::string_tag {                       \
+            static constexpr const char *str() { return s; }                \
+            static constexpr std::size_t len() { return sizeof( s ) - 1; }  \
+        };                                                                  \
+        return fmt();                                                       \
+      }() )
+
+#endif
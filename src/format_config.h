@@ -59,22 +59,153 @@
   #define ROM_DECL(x)           x
 #endif
 
+/*****************************************************************************/
+/** The optional features below are enabled or disabled by editing this file.
+    To select them on the compiler command line instead (for example to build
+    and test every combination) define CONFIG_EXPLICIT, then define each
+    wanted CONFIG_WITH_... option.
+**/
+
 /*****************************************************************************/
 /** Provide support for floating point output.  Many smaller embedded systems
     simply do not need this functionality so make it possible to remove it at
     build time.  If used at runtime the call to format will return EXBADFORMAT.
 **/
+#if !defined(CONFIG_EXPLICIT)
 #define CONFIG_WITH_FP_SUPPORT
+#endif
+
+/****************************************************************************/
+/** Use a bounded-time radix conversion for floating point output.  The
+    default conversion loops once per unit of binary exponent (over a thousand
+    times for very large or very small values).  This option replaces it with
+    a fixed sequence of table lookups and multiplies, so the time taken does
+    not depend on the value being converted, at the cost of about 1kB of
+    tables.  Suitable for hard real-time systems.
+**/
+/* #define CONFIG_WITH_FP_BOUNDED_TIME */
 
 /****************************************************************************/
 /** Provide support for long long arguments but only if needed, otherwise we
     can pull in unwanted libraries on most platforms.
 **/
+#if !defined(CONFIG_EXPLICIT)
 #define CONFIG_WITH_LONG_LONG_SUPPORT
+#endif
 
 /****************************************************************************/
 /** Provide support for the grouping feature if needed.
 **/
+#if !defined(CONFIG_EXPLICIT)
 #define CONFIG_WITH_GROUPING_SUPPORT
+#endif
+
+/****************************************************************************/
+/** Reduce the worst-case stack usage of format(), for systems with small task
+    stacks.  Numeric conversions stream their digits out through a small
+    buffer instead of building the whole number (up to 130 characters with
+    grouping) on the stack, and the conversion handlers are kept out of line
+    so their frames are not added to that of format().  This costs some
+    speed: each digit needs a division and grouping specifications are
+    re-read for each group.
+**/
+/* #define CONFIG_LOW_STACK */
+
+/****************************************************************************/
+/** Select the individual conversions and features to build in.  Removing the
+    ones an application does not use shrinks the code and takes their tests
+    out of the conversion dispatcher and the format parser.  An unsupported
+    conversion or feature used at runtime returns EXBADFORMAT.
+**/
+#if !defined(CONFIG_EXPLICIT)
+#define CONFIG_WITH_CONV_C          /* %c and %C                            */
+#define CONFIG_WITH_CONV_S          /* %s                                   */
+#define CONFIG_WITH_CONV_N          /* %n                                   */
+#define CONFIG_WITH_CONV_P          /* %p                                   */
+#define CONFIG_WITH_CONV_D          /* %d and %i                            */
+#define CONFIG_WITH_CONV_U          /* %u                                   */
+#define CONFIG_WITH_CONV_X          /* %x and %X                            */
+#define CONFIG_WITH_CONV_O          /* %o                                   */
+#define CONFIG_WITH_CONV_B          /* %b                                   */
+#define CONFIG_WITH_CONV_BASE       /* %I, %U and the :base modifier        */
+#define CONFIG_WITH_CONV_EFG        /* %e, %E, %f, %F, %g and %G            */
+#define CONFIG_WITH_CONV_A          /* %a and %A                            */
+#define CONFIG_WITH_CONV_K          /* %k and the {fixed-point} modifier    */
+#define CONFIG_WITH_ENGINEERING     /* ! flag with %e and %f                */
+#define CONFIG_WITH_UTF8            /* ! flag with %s, counting code points */
+#define CONFIG_WITH_CONTINUATION    /* continuation of the format string    */
+#define CONFIG_WITH_ROM_STRINGS     /* # flag with %s and continuation      */
+#endif
+
+/****************************************************************************/
+/** Optional conversions and features, which are left out unless defined
+    here or on the compiler command line.  Each adds code, and some add
+    data, which an application calling only format() does not need.
+**/
+/* #define CONFIG_WITH_POSITIONAL */  /* %n$ and *m$ positional arguments     */
+/* #define CONFIG_WITH_FORMAT_CONV */ /* format_conv(), used by format.hpp    */
+/* #define CONFIG_WITH_TYPED_ARGS */  /* format_args() and the FORMAT() macro */
+/* #define CONFIG_WITH_CONV_T */      /* %T ISO-8601 timestamps               */
+/* #define CONFIG_WITH_CONV_Q */      /* %q JSON, C and CSV quoted strings    */
+/* #define CONFIG_WITH_CONV_NET */    /* %N IP and %M MAC addresses           */
+/* #define CONFIG_WITH_WIDE_CHARS */  /* %lc and %ls, written as UTF-8        */
+/* #define CONFIG_WITH_SCAN */        /* format_scan() scanner                */
+/* #define CONFIG_WITH_TEMPLATE */    /* format_template_init() templates     */
+/* #define CONFIG_WITH_SCREEN */      /* format_screen_put() for displays     */
+/* #define CONFIG_WITH_CUSTOM_CONV */ /* format_register() custom conversions */
+
+/****************************************************************************/
+/** The %T conversion caches the date of the last timestamp it converted, in
+    thread-local storage.  C11 compilers, and gcc in a hosted build, are
+    recognised.  For others define this as the storage class for
+    thread-local data, or as nothing on a single-threaded system.
+**/
+/* #define CONFIG_THREAD_LOCAL */
+
+/****************************************************************************/
+/** Send microformat's output in blocks through the caller-provided functions
+    format_write() and format_fill(), instead of one character at a time
+    through format_putchar().  Runs of literal text, converted digits and
+    padding each become a single call.
+**/
+/* #define CONFIG_WITH_BLOCK_OUTPUT */
+
+/****************************************************************************/
+/** tinyformat sends padding, and %c repeated by a precision, in blocks built
+    in a run of this many characters on the stack (8 if not defined).  A
+    longer run takes more stack and fewer consumer calls.
+**/
+/* #define CONFIG_TINY_PAD_RUN      8 */
+
+/*****************************************************************************/
+/* Resolve dependencies between the options.                                 */
+/*****************************************************************************/
+
+#if !defined(CONFIG_WITH_FP_SUPPORT)
+  #undef CONFIG_WITH_CONV_EFG
+  #undef CONFIG_WITH_CONV_A
+  #undef CONFIG_WITH_CONV_K
+#endif
+
+#if !defined(CONFIG_WITH_CONV_EFG) && !defined(CONFIG_WITH_CONV_A) \
+ && !defined(CONFIG_WITH_CONV_K)
+  #undef CONFIG_WITH_FP_SUPPORT
+#endif
+
+#if !defined(CONFIG_WITH_CONV_EFG)
+  #undef CONFIG_WITH_ENGINEERING
+#endif
+
+#if !defined(CONFIG_WITH_CONV_S)
+  #undef CONFIG_WITH_UTF8
+#endif
+
+#if !defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+  #undef CONFIG_WITH_CONV_T
+#endif
+
+#if !defined(CONFIG_WITH_ROM_STRINGS)
+  #undef CONFIG_HAVE_ALT_PTR
+#endif
 
 #endif /* FORMAT_CONFIG_H */
@@ -96,32 +96,184 @@
 */
 #define COMP_EXP_LIMIT          ( 24 )
 
+/** The e, f and g conversion code is shared by the k conversion, and the
+    handling of infinities and NaNs is shared by e, f, g and a. **/
+#if defined(CONFIG_WITH_CONV_EFG) || defined(CONFIG_WITH_CONV_K)
+  #define NEED_CONV_EFG
+#endif
+#if defined(CONFIG_WITH_CONV_EFG) || defined(CONFIG_WITH_CONV_A)
+  #define NEED_CONV_FP
+#endif
+
+/** Bounded-time radix conversion **/
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+/* Decimal scaling factors are split as 10^p = 10^(16*q) * 10^r, with
+   0 <= r < 16.  The coarse table covers every p needed to bring a 64-bit
+   double (or a 32-bit one) into the range of the decimal mantissa.
+*/
+#define POW10_COARSE_STEP       ( 16 )
+#define POW10_COARSE_MIN        ( -19 )
+
+/* floor( x * log10(2) ) for |x| < 1200, using 78913 / 2^18 ~= log10(2) */
+#define LOG10_2_MUL             ( 78913L )
+#define LOG10_2_SHIFT           ( 18 )
+#endif
+
 /*****************************************************************************/
-/* Private function prototypes.  Declare as static.                          */
+/* Data types                                                                */
 /*****************************************************************************/
 
-static void extract_parts( double, unsigned int *, DEC_MANT_REG_TYPE *, int * );
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+/**
+    A power of ten held as a normalised binary value m x 2^e, where the top
+    bit of m is always set.
+**/
+typedef struct {
+    uint64_t        m;      /**< normalised mantissa                **/
+    int             e;      /**< binary exponent                    **/
+} T_Pow10;
+#endif
 
-static char hexchar( int );
+/*****************************************************************************/
+/* Private Data.  Declare as static.                                         */
+/*****************************************************************************/
+
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+/**
+    Powers of ten 10^(16*q) for q = POW10_COARSE_MIN ... 21, rounded to the
+    nearest 64-bit mantissa.
+**/
+static const T_Pow10 pow10_coarse[] = {
+    { 0x8C71DCD9BA0B4926ULL, -1073 }, /* 1e-304 */
+    { 0x9BECCE62836AC577ULL, -1020 }, /* 1e-288 */
+    { 0xAD1C8EAB5EE43B67ULL,  -967 }, /* 1e-272 */
+    { 0xC0314325637A193AULL,  -914 }, /* 1e-256 */
+    { 0xD5605FCDCF32E1D7ULL,  -861 }, /* 1e-240 */
+    { 0xECE53CEC4A314EBEULL,  -808 }, /* 1e-224 */
+    { 0x8380DEA93DA4BC60ULL,  -754 }, /* 1e-208 */
+    { 0x91FF83775423CC06ULL,  -701 }, /* 1e-192 */
+    { 0xA21727DB38CB0030ULL,  -648 }, /* 1e-176 */
+    { 0xB3F4E093DB73A093ULL,  -595 }, /* 1e-160 */
+    { 0xC7CABA6E7C5382C9ULL,  -542 }, /* 1e-144 */
+    { 0xDDD0467C64BCE4A1ULL,  -489 }, /* 1e-128 */
+    { 0xF64335BCF065D37DULL,  -436 }, /* 1e-112 */
+    { 0x88B402F7FD75539BULL,  -382 }, /* 1e-96 */
+    { 0x97C560BA6B0919A6ULL,  -329 }, /* 1e-80 */
+    { 0xA87FEA27A539E9A5ULL,  -276 }, /* 1e-64 */
+    { 0xBB127C53B17EC159ULL,  -223 }, /* 1e-48 */
+    { 0xCFB11EAD453994BAULL,  -170 }, /* 1e-32 */
+    { 0xE69594BEC44DE15BULL,  -117 }, /* 1e-16 */
+    { 0x8000000000000000ULL,   -63 }, /* 1e0 */
+    { 0x8E1BC9BF04000000ULL,   -10 }, /* 1e16 */
+    { 0x9DC5ADA82B70B59EULL,    43 }, /* 1e32 */
+    { 0xAF298D050E4395D7ULL,    96 }, /* 1e48 */
+    { 0xC2781F49FFCFA6D5ULL,   149 }, /* 1e64 */
+    { 0xD7E77A8F87DAF7FCULL,   202 }, /* 1e80 */
+    { 0xEFB3AB16C59B14A3ULL,   255 }, /* 1e96 */
+    { 0x850FADC09923329EULL,   309 }, /* 1e112 */
+    { 0x93BA47C980E98CE0ULL,   362 }, /* 1e128 */
+    { 0xA402B9C5A8D3A6E7ULL,   415 }, /* 1e144 */
+    { 0xB616A12B7FE617AAULL,   468 }, /* 1e160 */
+    { 0xCA28A291859BBF93ULL,   521 }, /* 1e176 */
+    { 0xE070F78D3927556BULL,   574 }, /* 1e192 */
+    { 0xF92E0C3537826146ULL,   627 }, /* 1e208 */
+    { 0x8A5296FFE33CC930ULL,   681 }, /* 1e224 */
+    { 0x9991A6F3D6BF1766ULL,   734 }, /* 1e240 */
+    { 0xAA7EEBFB9DF9DE8EULL,   787 }, /* 1e256 */
+    { 0xBD49D14AA79DBC82ULL,   840 }, /* 1e272 */
+    { 0xD226FC195C6A2F8CULL,   893 }, /* 1e288 */
+    { 0xE950DF20247C83FDULL,   946 }, /* 1e304 */
+    { 0x81842F29F2CCE376ULL,  1000 }, /* 1e320 */
+    { 0x8FCAC257558EE4E6ULL,  1053 }, /* 1e336 */
+};
+
+/**
+    Powers of ten 10^r for r = 0 ... 15.  These are all exact.
+**/
+static const T_Pow10 pow10_fine[] = {
+    { 0x8000000000000000ULL,   -63 }, /* 1e0 */
+    { 0xA000000000000000ULL,   -60 }, /* 1e1 */
+    { 0xC800000000000000ULL,   -57 }, /* 1e2 */
+    { 0xFA00000000000000ULL,   -54 }, /* 1e3 */
+    { 0x9C40000000000000ULL,   -50 }, /* 1e4 */
+    { 0xC350000000000000ULL,   -47 }, /* 1e5 */
+    { 0xF424000000000000ULL,   -44 }, /* 1e6 */
+    { 0x9896800000000000ULL,   -40 }, /* 1e7 */
+    { 0xBEBC200000000000ULL,   -37 }, /* 1e8 */
+    { 0xEE6B280000000000ULL,   -34 }, /* 1e9 */
+    { 0x9502F90000000000ULL,   -30 }, /* 1e10 */
+    { 0xBA43B74000000000ULL,   -27 }, /* 1e11 */
+    { 0xE8D4A51000000000ULL,   -24 }, /* 1e12 */
+    { 0x9184E72A00000000ULL,   -20 }, /* 1e13 */
+    { 0xB5E620F480000000ULL,   -17 }, /* 1e14 */
+    { 0xE35FA931A0000000ULL,   -14 }, /* 1e15 */
+};
+#endif
+
+#if defined(NEED_CONV_EFG)
+/**
+    Powers of ten 10^0 ... 10^(DEC_SIG_FIG-1), so rounding looks up its
+    addend instead of dividing down to it.
+**/
+static const DEC_MANT_REG_TYPE dec_pow10[DEC_SIG_FIG] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+#if DEC_SIG_FIG > 9
+    1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL
+#endif
+};
+#endif
+
+/*****************************************************************************/
+/* Private function prototypes.  Declare as static.                          */
+/*****************************************************************************/
 
 static void radix_convert( double, unsigned int *, DEC_MANT_REG_TYPE *, int * );
 
-static int mant_to_char( char *, DEC_MANT_REG_TYPE, int, int );
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+static uint64_t mul_norm( uint64_t, uint64_t, int * );
+
+static void radix_convert_bounded( DEC_MANT_REG_TYPE, int,
+                                   DEC_MANT_REG_TYPE *, int * );
+#endif
 
-static int do_conv_fp( T_FormatSpec *, va_list *, char,
+#if defined(NEED_CONV_FP)
+static int do_conv_fp( T_FormatSpec *, T_Args *, char,
                        void * (*)(void *, const char *, size_t), void * * );
 
-static int do_conv_infnan( T_FormatSpec *, char,
-                           void *          (*)(void *, const char *, size_t),
-                           void * *,
-                           unsigned int, DEC_MANT_REG_TYPE, int );
+static NOINLINE int do_conv_infnan( T_FormatSpec *, char,
+                                    void *  (*)(void *, const char *, size_t),
+                                    void * *,
+                                    unsigned int, DEC_MANT_REG_TYPE, int );
+#endif
+
+#if defined(NEED_CONV_EFG)
+static int mant_to_char( char *, DEC_MANT_REG_TYPE );
 
 static void round_mantissa( DEC_MANT_REG_TYPE *, int *, int, int, int );
 
+static NOINLINE int do_conv_efg( T_FormatSpec *, char,
+                                 void * (*)(void *, const char *, size_t),
+                                 void * *,
+                                 unsigned int, DEC_MANT_REG_TYPE, int );
+#endif
+
+#if defined(CONFIG_WITH_CONV_A)
+static void extract_parts( double, unsigned int *, DEC_MANT_REG_TYPE *, int * );
+
+static char hexchar( int );
+
+static NOINLINE int do_conv_a( T_FormatSpec *, char,
+                               void * (*)(void *, const char *, size_t),
+                               void * *,
+                               unsigned int, DEC_MANT_REG_TYPE, int );
+#endif
+
 /*****************************************************************************/
 /* Private functions.  Declare as static.                                    */
 /*****************************************************************************/
 
+#if defined(CONFIG_WITH_CONV_A)
 /*****************************************************************************/
 /**
    Extract the three parts from the FP value.
@@ -149,6 +301,7 @@ static void extract_parts( double              v,
     if ( pexponent ) *pexponent = (int)BIN_UNPACK_EXPO( u.bits );
     if ( psign )     *psign     = (unsigned int)BIN_UNPACK_SIGN( u.bits );
 }
+#endif
 
 /*****************************************************************************/
 /**
@@ -233,6 +386,24 @@ static void radix_convert( double              v,
         dec.mantissa = 0;
         dec.sign     = bin.sign;
     }
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+    else
+    {
+        dec.sign     = bin.sign;
+
+        /* Restore the assumed leading "1." of normal numbers, and give
+         *  denormals the smallest normal exponent.
+         */
+        if ( bin.exponent == 0 )
+            bin.exponent = 1;
+        else
+            bin.mantissa |= BIN_MANT_SINGLE_BIT << BIN_MANT_WIDTH;
+
+        radix_convert_bounded( bin.mantissa,
+                               bin.exponent - BIN_EXP_BIAS - BIN_MANT_WIDTH,
+                               &dec.mantissa, &dec.exponent );
+    }
+#else
     else
     {
         DEC_MANT_REG_TYPE inc;
@@ -248,6 +419,7 @@ static void radix_convert( double              v,
             
             while ( 0 == ( bin.mantissa & ( BIN_MANT_SINGLE_BIT << ( BIN_MANT_WIDTH - 1 ) ) ) )
             {
+                STEP();
                 bin.mantissa <<= 1;
                 bin.exponent--;
             }
@@ -263,6 +435,7 @@ static void radix_convert( double              v,
         bin.mantissa <<= BIN_MANT_LEFT_ALIGN;
         while ( bin.mantissa )
         {
+            STEP();
             if ( bin.mantissa & BIN_MANT_REG_TOP_BIT )
                 dec.mantissa += inc;
 
@@ -278,6 +451,7 @@ static void radix_convert( double              v,
         bin.exponent -= BIN_EXP_BIAS;  /* Subtract exponent bias */
         for ( ; bin.exponent > 0; bin.exponent-- )
         {
+            STEP();
             dec.mantissa *= 2;
             if ( dec.mantissa >= ( DEC_1P0 * 10 ) )
             {
@@ -287,6 +461,7 @@ static void radix_convert( double              v,
         }
         for ( ; bin.exponent < 0; bin.exponent++ )
         {
+            STEP();
             if ( dec.mantissa < ( ( DEC_1P0 * 2 ) ) )
             {
                 dec.mantissa *= 10;
@@ -295,47 +470,196 @@ static void radix_convert( double              v,
             dec.mantissa = ( dec.mantissa + 1 ) / 2;
         }
     }
+#endif
 
     if ( d_sign     ) *d_sign     = dec.sign;
     if ( d_mantissa ) *d_mantissa = dec.mantissa;
     if ( d_exponent ) *d_exponent = dec.exponent;
 }
 
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+/*****************************************************************************/
+/**
+    Multiply two normalised 64-bit mantissas, returning the normalised and
+    rounded top 64 bits of the 128-bit product.
+
+    Only 32x32-bit multiplies are used so that the code is the same on every
+    target, and the execution time does not depend on the operands.
+
+    @param a        First multiplicand, top bit set
+    @param b        Second multiplicand, top bit set
+    @param pe       Binary exponent, adjusted for the bits dropped from the
+                     product
+
+    @return normalised product.
+**/
+static uint64_t mul_norm( uint64_t a, uint64_t b, int *pe )
+{
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t p0   = a_lo * b_lo;
+    uint64_t p1   = a_lo * b_hi;
+    uint64_t p2   = a_hi * b_lo;
+    uint64_t p3   = a_hi * b_hi;
+    uint64_t mid  = ( p0 >> 32 ) + (uint32_t)p1 + (uint32_t)p2;
+    uint64_t hi   = p3 + ( p1 >> 32 ) + ( p2 >> 32 ) + ( mid >> 32 );
+    uint64_t lo   = ( mid << 32 ) | (uint32_t)p0;
+    unsigned int n;
+
+    /* The product of two normalised values has its top bit in one of the
+     *  two uppermost bit positions, so at most a single shift is needed.
+     */
+    n   = (unsigned int)!( hi >> 63 );
+    hi  = ( hi << n ) | ( ( lo >> 63 ) & n );
+    lo <<= n;
+    *pe += 64 - (int)n;
+
+    /* Round to nearest on the discarded half */
+    if ( ( lo >> 63 ) && ~hi )
+        hi++;
+
+    return hi;
+}
+
+/*****************************************************************************/
+/**
+    Convert a binary significand and exponent to radix-10 in a fixed number of
+    steps.
+
+    The loops in radix_convert() execute once per unit of binary exponent,
+    which for denormals and very large numbers is over a thousand iterations.
+    Here the value is instead scaled by a single power of ten, taken from two
+    small tables, such that the result is a DEC_SIG_FIG digit integer:
+
+         M x 2^e x 10^p = D,    where p = DEC_SIG_FIG - 1 - floor(log10(v))
+
+    The estimate of floor(log10(v)) from the binary exponent can be low by
+    one, which is corrected with a single divide by ten.  Execution time is
+    independent of the value being converted.
+
+    @param m            Binary significand (including any leading "1.")
+    @param e            Binary exponent, such that value = m x 2^e
+    @param d_mantissa   Output mantissa
+    @param d_exponent   Output exponent
+**/
+static void radix_convert_bounded( DEC_MANT_REG_TYPE   m,
+                                   int                 e,
+                                   DEC_MANT_REG_TYPE  *d_mantissa,
+                                   int                *d_exponent )
+{
+    uint64_t v = (uint64_t)m;
+    uint64_t c;
+    int s, x, d, p, q, r;
+    int ce;
+
+    /* Normalise the significand so the top bit is set.  This is a binary
+     *  search so it always takes six steps.
+     */
+    for ( s = 32; s > 0; s >>= 1 )
+    {
+        STEP();
+        if ( ( v >> ( 64 - s ) ) == 0 )
+        {
+            v <<= s;
+            e  -= s;
+        }
+    }
+
+    /* Estimate the decimal exponent of the leading digit */
+    x = e + 63;
+    if ( x >= 0 )
+        d = (int)( ( x * LOG10_2_MUL ) >> LOG10_2_SHIFT );
+    else
+        d = -(int)( ( -x * LOG10_2_MUL + ( 1L << LOG10_2_SHIFT ) - 1 )
+                                                        >> LOG10_2_SHIFT );
+
+    /* Look up 10^p and apply it */
+    p  = DEC_SIG_FIG - 1 - d;
+    q  = ( p - POW10_COARSE_STEP * POW10_COARSE_MIN ) / POW10_COARSE_STEP;
+    r  = ( p - POW10_COARSE_STEP * POW10_COARSE_MIN ) % POW10_COARSE_STEP;
+
+    ce = pow10_coarse[q].e + pow10_fine[r].e;
+    c  = mul_norm( pow10_coarse[q].m, pow10_fine[r].m, &ce );
+    e += ce;
+    v  = mul_norm( v, c, &e );
+
+    /* Correct for the exponent estimate being one too low.  This is done
+     *  before rounding, while v still has its binary fraction, to avoid
+     *  rounding twice.
+     */
+    if ( ( v >> -e ) >= (uint64_t)DEC_1P0 * 10 )
+    {
+        v /= 10;
+        d++;
+    }
+
+    /* Drop the binary fraction, rounding to nearest */
+    v = ( ( v >> ( -e - 1 ) ) + 1 ) >> 1;
+
+    /* Catch carry out of the rounding */
+    if ( v >= (uint64_t)DEC_1P0 * 10 )
+    {
+        v /= 10;
+        d++;
+    }
+
+    *d_mantissa = (DEC_MANT_REG_TYPE)v;
+    *d_exponent = d;
+}
+#endif
+
+#if defined(NEED_CONV_EFG)
 /******************************************************************************/
 /**
-    Convert part of mantissa into an array of decimal digit characters.
+    Convert the whole mantissa into an array of decimal digit characters.
 
-    When removing unwanted digits we might be required to round.  If rounding
-    is required then we only round with the last digit to be removed.
+    All DEC_SIG_FIG digits are written at once, most significant first, so
+    the callers take their digits from the array instead of dividing the
+    mantissa down again for each section.  A 64-bit mantissa is split once
+    into two halves of eight digits, each of which is then converted with
+    32-bit arithmetic: on 32-bit processors without a 64-bit divide this is
+    one library call per value instead of one per digit.
 
-    @param buf                  Output buffer
-    @param m                    Input mantissa
-    @param digits_total         Total number of input digits
-    @param digits_to_convert    Number of digits required in output
+    @param buf          Output buffer of DEC_SIG_FIG characters
+    @param m            Input mantissa
 
-    @return number of digits put into @a buf.
+    @return number of significant figures, not counting trailing zeros.
 **/
-static int mant_to_char( char * buf,
-                         DEC_MANT_REG_TYPE m,
-                         int digits_total,
-                         int digits_to_convert )
+static int mant_to_char( char * buf, DEC_MANT_REG_TYPE m )
 {
-    int i;
+    unsigned long v;
+    int i = DEC_SIG_FIG;
 
-    for ( i = digits_total - digits_to_convert; i > 0; i-- )
-        m /= 10;
+#if DEC_SIG_FIG > 9
+    unsigned long hi = (unsigned long)( m / 100000000UL );
 
-    for ( i = digits_to_convert; i > 0; i-- )
+    v = (unsigned long)( m - (DEC_MANT_REG_TYPE)hi * 100000000UL );
+    for ( ; i > DEC_SIG_FIG - 8; i-- )
     {
-        unsigned int d = (unsigned int)(m % 10);
+        STEP();
+        buf[i-1] = (char)( v % 10 ) + '0';
+        v /= 10;
+    }
+    v = hi;
+#else
+    v = (unsigned long)m;
+#endif
 
-        buf[i-1] = '0' + d;
-        m /= 10;
+    for ( ; i > 0; i-- )
+    {
+        STEP();
+        buf[i-1] = (char)( v % 10 ) + '0';
+        v /= 10;
     }
 
-    return digits_to_convert;
+    for ( i = DEC_SIG_FIG; i > 0 && buf[i-1] == '0'; i-- )
+        STEP();
+
+    return i;
 }
+#endif
 
+#if defined(NEED_CONV_FP)
 /*****************************************************************************/
 /**
     Process the floating point infinity and NaN values.
@@ -399,7 +723,9 @@ static int do_conv_infnan( T_FormatSpec *     pspec,
 
     return gen_out( cons, parg, ps1, pfx_s, pfx_n, 0, e_s, e_n, ps2 );
 }
+#endif
 
+#if defined(NEED_CONV_EFG)
 /*****************************************************************************/
 /**
     Round the mantissa according to the conversion type and precision
@@ -419,7 +745,7 @@ static void round_mantissa( DEC_MANT_REG_TYPE *mantissa, int *exponent,
       mantissa are after the decimal point.
     */
 
-   DEC_MANT_REG_TYPE addend = DEC_1P0 * 5;
+   DEC_MANT_REG_TYPE addend = 0;
    int shift = 0;
    int e = *exponent;
 
@@ -452,9 +778,9 @@ static void round_mantissa( DEC_MANT_REG_TYPE *mantissa, int *exponent,
 
    DEBUG_LOG( "round_mantissa(): shift = %d\n", shift );
 
-
-   while ( shift-- )
-      addend /= 10;
+   /* Half a unit in the last digit kept; beyond the mantissa it is zero */
+   if ( shift < DEC_SIG_FIG )
+      addend = 5 * dec_pow10[DEC_SIG_FIG - 1 - shift];
 
    *mantissa += addend;
 
@@ -466,7 +792,9 @@ static void round_mantissa( DEC_MANT_REG_TYPE *mantissa, int *exponent,
       DEBUG_LOG( "round_mantissa(): integer overflow (new exponent: %d)\n", *exponent );
    }
 }
+#endif
 
+#if defined(NEED_CONV_EFG)
 /*****************************************************************************/
 /**
     Process the floating point %e, %E, %f and %F conversions and the pseudo
@@ -589,6 +917,12 @@ static int do_conv_efg( T_FormatSpec *     pspec,
             code = (code == 'g') ? 'f' : 'F';
     }
 
+#if !defined(CONFIG_WITH_ENGINEERING)
+    /* Engineering and SI multiplier formats are not built in */
+    if ( pspec->flags & FBANG )
+        return EXBADFORMAT;
+#endif
+
     if ( code == 'f' || code == 'F' )
         is_f = 1;   
 
@@ -610,17 +944,15 @@ static int do_conv_efg( T_FormatSpec *     pspec,
     /* Perform any rounding on the mantissa prior to formatting */
     round_mantissa( &mantissa, &exponent, pspec->prec, is_f, (int)(pspec->flags & FBANG) );
 
-    /* Trim trailing zeros from mantissa and compute no. of sig.figures */
-    if ( mantissa )
-        for ( sigfig = DEC_SIG_FIG; sigfig > 0; sigfig--, mantissa /= 10 )
-            if ( mantissa % 10 )
-                break;
+    /* Convert the digits and compute no. of sig.figures */
+    sigfig = mant_to_char( e_s, mantissa );
 
     DEBUG_LOG( "sigfig: %d\n", sigfig );
 
     /* Work out how many digits on each side of the DP */
     if ( is_f )
     {
+#if defined(CONFIG_WITH_ENGINEERING)
         if ( pspec->flags & FBANG )
         {
             static char sitab[] = { 'y', 'z', 'a', 'f', 'p', 'n', 'u', 'm',
@@ -630,12 +962,14 @@ static int do_conv_efg( T_FormatSpec *     pspec,
 
             while ( idx > 0 && idx < ((int)NELEMS(sitab) - 1) )
             {
+                STEP();
                 if ( exponent >= 3 ) { idx++; exponent -= 3; continue; }
                 if ( exponent <  0 ) { idx--; exponent += 3; continue; }
                 break;
             }
             si = sitab[idx];
         }
+#endif
 
         n_left = exponent > -1 ? 1 + exponent : 0;
     }
@@ -643,6 +977,7 @@ static int do_conv_efg( T_FormatSpec *     pspec,
     {
         n_left = 1;
 
+#if defined(CONFIG_WITH_ENGINEERING)
         /* Engineering format forces exponent to multiple of 3 */
         if ( pspec->flags & FBANG )
         {
@@ -653,6 +988,7 @@ static int do_conv_efg( T_FormatSpec *     pspec,
            n_left   += m;
            exponent -= m;
         }
+#endif
     }
 
     n_right = MIN( MAX( sigfig - n_left, 0 ), pspec->prec );
@@ -660,13 +996,9 @@ static int do_conv_efg( T_FormatSpec *     pspec,
     /* The g-as-f conversion strips out additional digits */
     if ( is_f && really_g )
     {
-        DEC_MANT_REG_TYPE  m = mantissa;
-
-        /* strip extraneous digits */
-        for ( i = sigfig; i > n_left + n_right; i--, m /= 10 );
-
         /* strip trailing zeros */
-        for ( ; n_right > 0 && m % 10 == 0; m /= 10, n_right-- );
+        for ( ; n_right > 0 && e_s[n_left + n_right - 1] == '0'; n_right-- )
+            STEP();
     }
 
     DEBUG_LOG( "n_left: %d ", n_left );
@@ -706,7 +1038,7 @@ static int do_conv_efg( T_FormatSpec *     pspec,
          *  exponent field is minimum of 2.
          */
         for ( i = ABS(exponent), n_exp = 0; i > 0; n_exp++, i /= 10 )
-            ;
+            STEP();
 
         n_exp = MAX( n_exp, 2 );
 
@@ -765,10 +1097,7 @@ static int do_conv_efg( T_FormatSpec *     pspec,
     /* Generate the output sections */
 
     /* LEFT, including leading space and prefix */
-    e_n = n_left ? (size_t)mant_to_char( e_s, mantissa, sigfig, (int)(n_left - pz2) )
-                 : 0;
-
-    sigfig -= e_n;
+    e_n = n_left ? (size_t)(n_left - pz2) : 0;
 
     n = gen_out( cons, parg, ps1, pfx_s, pfx_n, pz1, e_s, e_n, 0 );
     if ( n == EXBADFORMAT )
@@ -782,10 +1111,8 @@ static int do_conv_efg( T_FormatSpec *     pspec,
     count += n;
 
     /* RIGHT */
-    e_n = n_right ? (size_t)mant_to_char( e_s, mantissa, sigfig, n_right )
-                  : 0;
-
-    n = gen_out( cons, parg, 0, ".", (size_t)(want_dp ? 1 : 0), pz3, e_s, e_n, 0 );
+    n = gen_out( cons, parg, 0, ".", (size_t)(want_dp ? 1 : 0), pz3,
+                 e_s + e_n, (size_t)n_right, 0 );
     if ( n == EXBADFORMAT )
         return n;
     count += n;
@@ -824,7 +1151,9 @@ static int do_conv_efg( T_FormatSpec *     pspec,
 
     return count;
 }
+#endif
 
+#if defined(CONFIG_WITH_CONV_A)
 /*****************************************************************************/
 /**
     Convert bottom four bits into hexadecimal character
@@ -842,7 +1171,9 @@ static char hexchar( int i )
     i &= 0xF;
     return hex[i];
 }
+#endif
 
+#if defined(CONFIG_WITH_CONV_A)
 /*****************************************************************************/
 /**
     Process the floating point %a, %A.
@@ -938,7 +1269,7 @@ static int do_conv_a( T_FormatSpec *     pspec,
         DEC_MANT_REG_TYPE m = mantissa << BIN_MANT_LEFT_ALIGN;
 
         for ( n_right = 0; m != 0; n_right++, m <<= 4 )
-            ;
+            STEP();
     }
     else
         n_right = pspec->prec;
@@ -956,7 +1287,7 @@ static int do_conv_a( T_FormatSpec *     pspec,
      */
     exponent -= BIN_EXP_BIAS;  /* Subtract exponent bias */
     for ( i = ABS(exponent), n_exp = 0; i > 0; n_exp++, i /= 10 )
-        ;
+        STEP();
 
     n_exp = MAX( n_exp, 1 );
 
@@ -1078,7 +1409,9 @@ static int do_conv_a( T_FormatSpec *     pspec,
 
     return count;
 }
+#endif
 
+#if defined(NEED_CONV_FP)
 /*****************************************************************************/
 /**
     Process the floating point conversions (%e, %E, %f, %F, %g, %G).
@@ -1109,7 +1442,7 @@ static int do_conv_a( T_FormatSpec *     pspec,
     @return Number of emitted characters, or EXBADFORMAT if failure
 **/
 static int do_conv_fp( T_FormatSpec * pspec,
-                       va_list *      ap,
+                       T_Args *       ap,
                        char           code,
                        void *      (* cons)(void *, const char *, size_t),
                        void * *       parg )
@@ -1123,7 +1456,7 @@ static int do_conv_fp( T_FormatSpec * pspec,
     if ( pspec->qual == 'L' )
         return EXBADFORMAT;
 
-    dv = va_arg( *ap, double );
+    dv = ARG( ap, double );
     radix_convert( dv, &sign, &mantissa, &exponent );
 
     /* Infs and NaNs are treated in the same style */
@@ -1132,18 +1465,24 @@ static int do_conv_fp( T_FormatSpec * pspec,
     {
         return do_conv_infnan( pspec, code, cons, parg, sign, mantissa, exponent );
     }
-    else if ( code == 'a' || code == 'A' )
+
+#if defined(CONFIG_WITH_CONV_A)
+    if ( code == 'a' || code == 'A' )
     {
         extract_parts( dv, &sign, &mantissa, &exponent );
         return do_conv_a( pspec, code, cons, parg, sign, mantissa, exponent );
     }
-    else
-    {
-        radix_convert( dv, &sign, &mantissa, &exponent );
-        return do_conv_efg( pspec, code, cons, parg, sign, mantissa, exponent );
-    }    
+#endif
+
+#if defined(CONFIG_WITH_CONV_EFG)
+    return do_conv_efg( pspec, code, cons, parg, sign, mantissa, exponent );
+#else
+    return EXBADFORMAT;
+#endif
 }
+#endif
 
+#if defined(CONFIG_WITH_CONV_K)
 /****************************************************************************/
 /**
     Process fixed-point conversion (%k).
@@ -1157,13 +1496,14 @@ static int do_conv_fp( T_FormatSpec * pspec,
     @return Number of emitted characters, or EXBADFORMAT if failure
 **/
 static int do_conv_k( T_FormatSpec * pspec,
-                      va_list *      ap,
+                      T_Args *       ap,
                       void *      (* cons)(void *, const char *, size_t),
                       void * *       parg )
 {
     unsigned int total_bits = pspec->xp.w_int + pspec->xp.w_frac;
     size_t total_bytes = ( total_bits + 7 ) / 8;
     long v;
+    unsigned long uv;
     unsigned int sign;
     DEC_MANT_REG_TYPE mantissa;
     int exponent;
@@ -1177,15 +1517,25 @@ static int do_conv_k( T_FormatSpec * pspec,
         return EXBADFORMAT;
     
     if ( total_bytes <= sizeof( int ) )
-        v = (long)va_arg( *ap, int );
+        v = (long)ARG( ap, int );
     else
-        v = (long)va_arg( *ap, long );
+        v = (long)ARG( ap, long );
 
     DEBUG_LOG( "k: val = 0x%8.8lX ", v );
     DEBUG_LOG( "w_int = %u ", pspec->xp.w_int );
     DEBUG_LOG( "w_frac = %u ", pspec->xp.w_frac );
 
-    if ( v == 0 ) /* handle zero as special case */
+    /* Extract sign bit */
+    sign = ( v >> ( total_bits - 1 ) ) & 0x01;
+
+    /* If the sign bit is set (number is negative) then apply 2's complement
+     * sign inversion, then mask out any bits not in the fixed-point type.
+     * The magnitude of the most negative value needs all of its bits.
+     */
+    uv = sign ? 0UL - (unsigned long)v : (unsigned long)v;
+    uv &= ( 2UL << ( total_bits - 1 ) ) - 1;
+
+    if ( uv == 0 ) /* handle zero as special case */
     {
         sign     = 0;
         mantissa = 0;
@@ -1195,23 +1545,14 @@ static int do_conv_k( T_FormatSpec * pspec,
     {
         int i;
 
-        /* Extract sign bit */
-        sign = ( v >> ( total_bits - 1 ) ) & 0x01;
-
-        /* If the sign bit is set (number is negative) then apply 2's complement
-         * sign inversion.  We can use the built-in type sign inversion as long
-         * as we then mask out any bits not in the fixed-point type.
-         */
-        if ( sign )
-            v = -v;
-
-        /* Mask out any dross from the input value and save for later */
-        v &= ( 1 << ( total_bits - 1) ) - 1;
-        mantissa = (DEC_MANT_REG_TYPE)v;
+        mantissa = (DEC_MANT_REG_TYPE)uv;
 
         /* Work out where highest bit is */
-        for ( i = -1; v != 0; i++ )
-            v >>= 1;
+        for ( i = -1; uv != 0; i++ )
+        {
+            STEP();
+            uv >>= 1;
+        }
 
         /* i gives index of highest '1' bit, which then gives us the exponent */
         DEBUG_LOG( "i = %d ", i );
@@ -1222,7 +1563,10 @@ static int do_conv_k( T_FormatSpec * pspec,
          * what we want - in floating point the '1' is implied.
          */
         while ( (mantissa & ~BIN_MANT_MASK) == 0 )
+        {
+            STEP();
             mantissa <<= 1;
+        }
 
         DEBUG_LOG("mantissa: %llu\n", mantissa);
 
@@ -1237,6 +1581,7 @@ static int do_conv_k( T_FormatSpec * pspec,
     
     return do_conv_efg( pspec, 'f', cons, parg, sign, mantissa, exponent );
 }
+#endif
 
 /*****************************************************************************/
 /*****************************************************************************/
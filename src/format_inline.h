@@ -0,0 +1,100 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/**
+    Header-only build of format.
+
+    Including this file compiles a private copy of the library into the
+    including source file, with every function static.  Define FORMAT_SINK
+    as the name of a consumer function before including it, and the copy
+    calls that consumer directly instead of through the @a cons pointer, so
+    the compiler can inline it.  For a consumer which copies into a buffer
+    the output then becomes straight-line stores, with no indirect calls.
+
+    For example:
+
+        static void * bufwrite( void * p, const char * s, size_t n )
+        {
+            return (char *)memcpy( p, s, n ) + n;
+        }
+
+        #define FORMAT_SINK   bufwrite
+        #include "format_inline.h"
+
+        FORMAT_DEFINE( bprintf, bufwrite )
+
+    The copy is configured by format_config.h in the same way as the
+    library.  There can be only one copy in each source file, so only one
+    consumer can be FORMAT_SINK; any other consumer passed in, including
+    the copy's own for templates, is still called through its pointer.
+    Without FORMAT_SINK every consumer is called through its pointer, and
+    FORMAT_DEFINE can be used for any number of consumers.
+
+    The copy's data is private as well: its %T date cache and its table of
+    custom conversions are separate from the library's and from those of
+    copies in other source files, so format_register() affects only the
+    copy in the file which calls it.
+**/
+
+#ifndef FORMAT_INLINE_H
+#define FORMAT_INLINE_H
+
+#if defined(FORMAT_H) && !defined(FORMAT_INLINE)
+#error "format_inline.h must be included before format.h"
+#endif
+
+#define FORMAT_INLINE
+#define FORMAT_API              static inline
+
+#include "format.c"
+
+/**
+    Define a printf-style function @a name which sends its output to the
+    consumer @a sink_fn, passing it the opaque pointer given as the first
+    argument.  If @a sink_fn is FORMAT_SINK it is called directly.
+
+        int name( void * arg, const char * fmt, ... );
+
+    The function returns the number of characters sent, or EXBADFORMAT.
+**/
+#define FORMAT_DEFINE( name, sink_fn )                                      \
+    static int name( void * arg, const char * fmt, ... )                    \
+    {                                                                       \
+        va_list ap;                                                         \
+        int n;                                                              \
+                                                                            \
+        va_start( ap, fmt );                                                \
+        n = format( sink_fn, arg, fmt, ap );                                \
+        va_end( ap );                                                       \
+        return n;                                                           \
+    }
+
+#endif /* FORMAT_INLINE_H */
@@ -0,0 +1,935 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2010-2023, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/** Scanning support **/
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#if defined(CONFIG_HAVE_LIBC)
+  #include <stdlib.h>
+#endif
+
+/*****************************************************************************/
+/* Macros, constants                                                         */
+/*****************************************************************************/
+
+/** End of input, as returned by scan_peek() **/
+#define SCAN_EOF            ( -1 )
+
+/** Longest floating point number kept for strtod(), beyond the exponent **/
+#define SCAN_FP_BUFLEN      ( 64 )
+
+#define SCAN_ISSPACE(c)     ( (c) == ' ' || ( (c) >= '\t' && (c) <= '\r' ) )
+
+/**
+    Floating point numbers are converted by the C library's strtod(), which
+    rounds correctly.
+**/
+#if defined(CONFIG_WITH_FP_SUPPORT) && defined(CONFIG_HAVE_LIBC)
+  #define NEED_SCAN_FP
+#endif
+
+/**
+    Decimal numbers are read eight digits at a time (SWAR) from a 64-bit word
+    where the first character is the lowest byte.  SCAN_8DIGITS() is true if
+    all eight bytes of w are decimal digits.
+**/
+#if defined(CONFIG_HAVE_LIBC) && defined(UINT64_MAX) \
+ && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  #define NEED_SCAN_SWAR
+  #define SCAN_8DIGITS(w)   ( ( ( (w) & 0xF0F0F0F0F0F0F0F0U )                 \
+                              | ( ( ( (w) + 0x0606060606060606U )            \
+                                    & 0xF0F0F0F0F0F0F0F0U ) >> 4 ) )         \
+                              == 0x3333333333333333U )
+#endif
+
+/*****************************************************************************/
+/* Private types.                                                            */
+/*****************************************************************************/
+
+/**
+    Input state.  The input is read a block at a time from the producer
+    function, or is a single string.  One character can be held back from
+    the previous block, so that two characters can always be looked at.
+**/
+typedef struct {
+    const char * (* prod)(void *, size_t *); /**< producer, or NULL at end **/
+    void *          arg;    /**< opaque pointer passed to prod      **/
+    const char *    p;      /**< next character of current block   **/
+    const char *    end;    /**< end of current block               **/
+    int             hold;   /**< character held back, or SCAN_EOF   **/
+    size_t          count;  /**< characters read so far, for %n     **/
+} T_Scan;
+
+/*****************************************************************************/
+/* Private function prototypes.  Declare as static.                          */
+/*****************************************************************************/
+
+static void scan_fill( T_Scan * );
+static int scan_peek( T_Scan * );
+static int scan_peek2( T_Scan * );
+static void scan_next( T_Scan * );
+static void scan_space( T_Scan * );
+static unsigned int scan_digit( int );
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+static int scan_is_sep( T_FormatSpec *, int );
+#endif
+#if defined(NEED_SCAN_SWAR)
+static uint32_t scan_swar8( uint64_t );
+#endif
+static int scan_uint( T_Scan *, T_FormatSpec *, unsigned int, size_t *,
+                      uintmax_t * );
+static void scan_store( T_Args *, char, uintmax_t );
+static int scan_conv_int( T_Scan *, T_FormatSpec *, T_Args *, char, int );
+static int scan_conv_cs( T_Scan *, T_FormatSpec *, T_Args *, char, int );
+#if defined(NEED_SCAN_FP)
+static size_t scan_put_exp( char *, long );
+static int scan_conv_fp( T_Scan *, T_FormatSpec *, T_Args *, char, int );
+#endif
+static int scan_one( T_Scan *, T_FormatSpec *, T_Args *, char, int );
+static int do_scan( T_Scan *, const char *, T_Args * );
+
+/*****************************************************************************/
+/* Private functions.  Declare as static.                                    */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/**
+    Ask the producer for more input once the current block is used up.
+    Empty blocks are skipped, and a NULL block ends the input.
+
+    @param sc       Pointer to input state.
+**/
+static void scan_fill( T_Scan * sc )
+{
+    while ( sc->p == sc->end && sc->prod )
+    {
+        size_t n = 0;
+        const char *b = sc->prod( sc->arg, &n );
+
+        if ( b == NULL )
+            sc->prod = NULL;
+        else
+        {
+            sc->p   = b;
+            sc->end = b + n;
+        }
+    }
+}
+
+/*****************************************************************************/
+/**
+    Look at the next input character without reading it.
+
+    @param sc       Pointer to input state.
+
+    @return The character, or SCAN_EOF at the end of the input.
+**/
+static int scan_peek( T_Scan * sc )
+{
+    if ( sc->hold != SCAN_EOF )
+        return sc->hold;
+
+    if ( sc->p == sc->end )
+        scan_fill( sc );
+    return sc->p < sc->end ? (unsigned char)*sc->p : SCAN_EOF;
+}
+
+/*****************************************************************************/
+/**
+    Look at the input character after the next one.  If the next character
+    ends a block it is held back while the following block is fetched.
+
+    @param sc       Pointer to input state.
+
+    @return The character, or SCAN_EOF at the end of the input.
+**/
+static int scan_peek2( T_Scan * sc )
+{
+    if ( sc->hold == SCAN_EOF )
+    {
+        scan_fill( sc );
+        if ( sc->end - sc->p >= 2 )
+            return (unsigned char)sc->p[1];
+        if ( sc->p == sc->end )
+            return SCAN_EOF;
+        sc->hold = (unsigned char)*sc->p++;
+    }
+
+    scan_fill( sc );
+    return sc->p < sc->end ? (unsigned char)*sc->p : SCAN_EOF;
+}
+
+/*****************************************************************************/
+/**
+    Read the next input character, which must have been looked at.
+
+    @param sc       Pointer to input state.
+**/
+static void scan_next( T_Scan * sc )
+{
+    if ( sc->hold != SCAN_EOF )
+        sc->hold = SCAN_EOF;
+    else
+        sc->p++;
+    sc->count++;
+}
+
+/*****************************************************************************/
+/**
+    Skip any white space in the input.
+
+    @param sc       Pointer to input state.
+**/
+static void scan_space( T_Scan * sc )
+{
+    int c;
+
+    while ( ( c = scan_peek( sc ) ) != SCAN_EOF && SCAN_ISSPACE( c ) )
+    {
+        if ( sc->hold != SCAN_EOF )
+            scan_next( sc );
+        else
+        {
+            /* skip the rest of the white space in the current block */
+            const char *p = sc->p;
+
+            while ( p < sc->end && SCAN_ISSPACE( *p ) )
+                p++;
+            sc->count += (size_t)( p - sc->p );
+            sc->p      = p;
+        }
+    }
+}
+
+/*****************************************************************************/
+/**
+    Get the value of a digit in any base up to 36.
+
+    @param c        Character.
+
+    @return The value of the digit, or 36 or more if it is not a digit.
+**/
+static unsigned int scan_digit( int c )
+{
+    unsigned int d = (unsigned int)( c - '0' );
+
+    if ( d < 10 )
+        return d;
+    d = (unsigned int)( ( c | 0x20 ) - 'a' );
+    return d < 26 ? d + 10 : MAXBASE;
+}
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+/*****************************************************************************/
+/**
+    Check if a character is one of the separators of a grouping
+    specification: a character followed by a group width or '*'.
+
+    @param pspec    Pointer to format specification.
+    @param c        Character.
+
+    @return Non-zero if c is a separator.
+**/
+static int scan_is_sep( T_FormatSpec * pspec, int c )
+{
+    const char *g = (const char *)pspec->grouping.ptr;
+    size_t i;
+
+    for ( i = 0; i + 1 < pspec->grouping.len; i++ )
+        if ( (unsigned char)g[i] == c && ( ISDIGIT( g[i + 1] ) || g[i + 1] == '*' ) )
+            return 1;
+
+    return 0;
+}
+#endif
+
+#if defined(NEED_SCAN_SWAR)
+/*****************************************************************************/
+/**
+    Convert eight decimal digits, the first in the lowest byte, to their
+    value: pairs of digits, then groups of four, then all eight, each step
+    with a single multiply.
+
+    @param w        The eight digits.
+
+    @return Value of the digits.
+**/
+static uint32_t scan_swar8( uint64_t w )
+{
+    w -= 0x3030303030303030U;
+    w  = w * 10 + ( w >> 8 );
+    w  = ( ( w & 0x000000FF000000FFU ) * ( 100 + ( 1000000ULL << 32 ) )
+         + ( ( w >> 16 ) & 0x000000FF000000FFU ) * ( 1 + ( 10000ULL << 32 ) ) )
+         >> 32;
+    return (uint32_t)w;
+}
+#endif
+
+/*****************************************************************************/
+/**
+    Read the digits of an unsigned number, skipping any grouping separators
+    between them.  Runs of eight decimal digits within a block are converted
+    a word at a time.
+
+    @param sc       Pointer to input state.
+    @param pspec    Pointer to format specification.
+    @param base     Numeric base, from 2 to 36.
+    @param pleft    Pointer to number of characters left in the field.
+    @param pv       Pointer to value read.
+
+    @return Number of digits read.
+**/
+static int scan_uint( T_Scan *       sc,
+                      T_FormatSpec * pspec,
+                      unsigned int   base,
+                      size_t *       pleft,
+                      uintmax_t *    pv )
+{
+    uintmax_t v = 0;
+    int nd = 0;
+    unsigned int d;
+    int c;
+
+    while ( *pleft )
+    {
+        /* Digits in the current block are read straight from it */
+        if ( sc->hold == SCAN_EOF && sc->p < sc->end )
+        {
+            const char *p = sc->p;
+            const char *e = (size_t)( sc->end - p ) > *pleft ? p + *pleft
+                                                             : sc->end;
+            size_t n;
+
+#if defined(NEED_SCAN_SWAR)
+            for ( ; base == 10 && e - p >= 8; p += 8 )
+            {
+                uint64_t w;
+
+                memcpy( &w, p, sizeof( w ) );
+                if ( !SCAN_8DIGITS( w ) )
+                    break;
+                v = v * 100000000U + scan_swar8( w );
+            }
+#endif
+            for ( ; p < e && ( d = scan_digit( (unsigned char)*p ) ) < base; p++ )
+                v = v * base + d;
+
+            n = (size_t)( p - sc->p );
+            nd        += (int)n;
+            sc->count += n;
+            *pleft    -= n;
+            sc->p      = p;
+            if ( p == e )
+                continue;
+        }
+
+        if ( ( c = scan_peek( sc ) ) == SCAN_EOF )
+            break;
+
+        if ( ( d = scan_digit( c ) ) < base )
+        {
+            v = v * base + d;
+            nd++;
+        }
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+        /* a separator must come between two digits */
+        else if ( !nd || !scan_is_sep( pspec, c )
+               || scan_digit( scan_peek2( sc ) ) >= base )
+            break;
+#else
+        else
+            break;
+#endif
+        scan_next( sc );
+        (*pleft)--;
+    }
+
+    *pv = v;
+    return nd;
+}
+
+/*****************************************************************************/
+/**
+    Store an integer through the next argument, a pointer to the type given
+    by the length qualifier.
+
+    @param pa       Pointer to arguments.
+    @param qual     Length qualifier.
+    @param v        Value, as an unsigned number.
+**/
+static void scan_store( T_Args * pa, char qual, uintmax_t v )
+{
+    switch ( qual )
+    {
+    case DOUBLE_QUAL( 'h' ):
+        *ARG( pa, signed char * ) = (signed char)v;
+        break;
+    case 'h':
+        *ARG( pa, short * ) = (short)v;
+        break;
+    case 'l':
+        *ARG( pa, long * ) = (long)v;
+        break;
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    case DOUBLE_QUAL( 'l' ):
+        *ARG( pa, long long * ) = (long long)v;
+        break;
+#endif
+    case 'j':
+        *ARG( pa, intmax_t * ) = (intmax_t)v;
+        break;
+    case 'z':
+        *ARG( pa, size_t * ) = (size_t)v;
+        break;
+    case 't':
+        *ARG( pa, ptrdiff_t * ) = (ptrdiff_t)v;
+        break;
+    default:
+        *ARG( pa, int * ) = (int)v;
+        break;
+    }
+}
+
+/*****************************************************************************/
+/**
+    Scan an integer conversion: b, d, i, I, o, p, u, U, x or X.  Leading
+    white space is skipped, then an optional sign, then an optional "0x" or
+    "0b" prefix for hexadecimal and binary.
+
+    @param sc       Pointer to input state.
+    @param pspec    Pointer to format specification.
+    @param pa       Pointer to arguments.
+    @param code     Conversion specifier code.
+    @param store    Non-zero to store the value, zero if suppressed.
+
+    @return 1 if matched, 0 if not, or EXBADFORMAT if failure
+**/
+static int scan_conv_int( T_Scan *       sc,
+                          T_FormatSpec * pspec,
+                          T_Args *       pa,
+                          char           code,
+                          int            store )
+{
+    size_t left = pspec->width ? pspec->width : (size_t)-1;
+    unsigned int base = 10;
+    uintmax_t v;
+    int neg = 0;
+    int c;
+
+    if ( code == 'x' || code == 'X' || code == 'p' )
+        base = 16;
+    else if ( code == 'o' )
+        base = 8;
+    else if ( code == 'b' )
+        base = 2;
+#if defined(CONFIG_WITH_CONV_BASE)
+    if ( ( code == 'i' || code == 'I' || code == 'U' ) && pspec->base )
+        base = pspec->base;
+    if ( base < 2 )
+        return EXBADFORMAT;
+#endif
+
+    scan_space( sc );
+
+    c = scan_peek( sc );
+    if ( c == '-' || c == '+' )
+    {
+        neg = ( c == '-' );
+        scan_next( sc );
+        left--;
+    }
+
+    if ( ( base == 16 || base == 2 ) && left >= 2 && scan_peek( sc ) == '0'
+      && ( scan_peek2( sc ) | 0x20 ) == ( base == 16 ? 'x' : 'b' ) )
+    {
+        scan_next( sc );
+        scan_next( sc );
+        left -= 2;
+    }
+
+    if ( !scan_uint( sc, pspec, base, &left, &v ) )
+        return 0;
+
+    if ( !store )
+        return 1;
+
+    if ( neg )
+        v = 0 - v;
+    if ( code == 'p' )
+        *ARG( pa, void * * ) = (void *)(uintptr_t)v;
+    else
+        scan_store( pa, pspec->qual, v );
+
+    return 1;
+}
+
+/*****************************************************************************/
+/**
+    Scan a %c or %s conversion.  %c reads exactly the field width of
+    characters (one by default), white space included.  %s skips white space
+    then reads characters up to the next white space or the field width,
+    and stores them with a terminating null character.  A precision gives
+    the size of the array, so at most one less character is stored.
+
+    @param sc       Pointer to input state.
+    @param pspec    Pointer to format specification.
+    @param pa       Pointer to arguments.
+    @param code     Conversion specifier code.
+    @param store    Non-zero to store the value, zero if suppressed.
+
+    @return 1 if matched, 0 if not, or EXBADFORMAT if failure
+**/
+static int scan_conv_cs( T_Scan *       sc,
+                         T_FormatSpec * pspec,
+                         T_Args *       pa,
+                         char           code,
+                         int            store )
+{
+    size_t left = pspec->width ? pspec->width
+                               : ( code == 'c' ? 1 : (size_t)-1 );
+    size_t n = 0;
+    char *s = store ? ARG( pa, char * ) : NULL;
+    int c;
+
+    if ( pspec->qual )
+        return EXBADFORMAT;
+
+    if ( code == 's' )
+    {
+        scan_space( sc );
+        if ( pspec->prec == 0 )
+            return EXBADFORMAT;
+        if ( pspec->prec > 0 )
+            left = MIN( left, (size_t)pspec->prec - 1 );
+    }
+
+    for ( ; n < left && ( c = scan_peek( sc ) ) != SCAN_EOF; n++ )
+    {
+        if ( code == 's' && SCAN_ISSPACE( c ) )
+            break;
+        if ( s )
+            s[n] = (char)c;
+        scan_next( sc );
+    }
+
+    if ( n == 0 || ( code == 'c' && n < left ) )
+        return 0;
+
+    if ( s && code == 's' )
+        s[n] = '\0';
+
+    return 1;
+}
+
+#if defined(NEED_SCAN_FP)
+/*****************************************************************************/
+/**
+    Write a decimal exponent.
+
+    @param p        Pointer to output buffer.
+    @param e        Exponent.
+
+    @return Number of characters written.
+**/
+static size_t scan_put_exp( char * p, long e )
+{
+    char t[12];
+    size_t i = 0, n = 0;
+    unsigned long u = e < 0 ? 0UL - (unsigned long)e : (unsigned long)e;
+
+    if ( e < 0 )
+        p[n++] = '-';
+    do
+        t[i++] = (char)( '0' + u % 10 );
+    while ( ( u /= 10 ) != 0 );
+    while ( i )
+        p[n++] = t[--i];
+
+    return n;
+}
+
+/*****************************************************************************/
+/**
+    Scan a floating point conversion: a, A, e, E, f, F, g, G, or k.  The
+    number is gathered into a buffer and converted by strtod(), so it is
+    rounded correctly; the a and A conversions read hexadecimal floating
+    point.  Digits which do not fit in the buffer add to the exponent, or
+    are dropped after the decimal point.  With the '!' flag a following
+    space and SI multiplier, as written by %!f, scale the value.  A %k value
+    is stored in the fixed-point format given by its modifier.
+
+    @param sc       Pointer to input state.
+    @param pspec    Pointer to format specification.
+    @param pa       Pointer to arguments.
+    @param code     Conversion specifier code.
+    @param store    Non-zero to store the value, zero if suppressed.
+
+    @return 1 if matched, 0 if not, or EXBADFORMAT if failure
+**/
+static int scan_conv_fp( T_Scan *       sc,
+                         T_FormatSpec * pspec,
+                         T_Args *       pa,
+                         char           code,
+                         int            store )
+{
+    static const char sitab[] = "yzafpnum kMGTPEZY";
+    char buf[SCAN_FP_BUFLEN + 16];
+    size_t left = pspec->width ? pspec->width : (size_t)-1;
+    size_t n = 0;
+    long adj = 0, ex = 0;
+    int digits = 0, point = 0, hex = 0, has_ex = 0;
+    double v;
+    char *end;
+    int c;
+
+    if ( pspec->qual == 'L' )
+        return EXBADFORMAT;
+
+    scan_space( sc );
+
+    c = scan_peek( sc );
+    if ( c == '-' || c == '+' )
+    {
+        buf[n++] = (char)c;
+        scan_next( sc );
+        left--;
+    }
+
+    if ( left >= 2 && scan_peek( sc ) == '0' && ( scan_peek2( sc ) | 0x20 ) == 'x' )
+    {
+        buf[n++] = '0';
+        buf[n++] = 'x';
+        scan_next( sc );
+        scan_next( sc );
+        left -= 2;
+        hex = 1;
+        digits = 1;
+    }
+
+    /* inf, infinity and nan are left to strtod() */
+    while ( left && n < SCAN_FP_BUFLEN && !hex && !digits
+         && ( c = scan_peek( sc ) ) != SCAN_EOF
+         && ( c | 0x20 ) >= 'a' && ( c | 0x20 ) <= 'z' )
+    {
+        buf[n++] = (char)c;
+        scan_next( sc );
+        left--;
+    }
+
+    /* mantissa */
+    while ( left && ( c = scan_peek( sc ) ) != SCAN_EOF )
+    {
+        if ( c == '.' && !point )
+            point = 1;
+        else if ( scan_digit( c ) < ( hex ? 16U : 10U ) )
+        {
+            digits = 1;
+            if ( n >= SCAN_FP_BUFLEN )
+            {
+                /* clamped, as the exponent is */
+                if ( !point && adj < 100000L )
+                    adj++;
+                scan_next( sc );
+                left--;
+                continue;
+            }
+        }
+        else
+            break;
+        buf[n++] = (char)c;
+        scan_next( sc );
+        left--;
+    }
+
+    if ( !digits && n == 0 )
+        return 0;
+
+    /* exponent */
+    c = scan_peek( sc );
+    if ( left && digits && ( c | 0x20 ) == ( hex ? 'p' : 'e' ) )
+    {
+        int neg = 0;
+        unsigned int d;
+
+        scan_next( sc );
+        left--;
+        c = scan_peek( sc );
+        if ( left && ( c == '-' || c == '+' ) )
+        {
+            neg = ( c == '-' );
+            scan_next( sc );
+            left--;
+        }
+        while ( left && ( d = scan_digit( scan_peek( sc ) ) ) < 10 )
+        {
+            if ( ex < 100000L )
+                ex = ex * 10 + (long)d;
+            has_ex = 1;
+            scan_next( sc );
+            left--;
+        }
+        if ( !has_ex )
+            return 0;
+        if ( neg )
+            ex = -ex;
+    }
+
+#if defined(CONFIG_WITH_ENGINEERING)
+    /* SI multiplier */
+    if ( ( pspec->flags & FBANG ) && left >= 2 && digits
+      && scan_peek( sc ) == ' ' )
+    {
+        const char *t;
+
+        c = scan_peek2( sc );
+        if ( c != SCAN_EOF && c != ' ' && ( t = STRCHR( sitab, c ) ) != NULL )
+        {
+            ex += 3 * ( ( t - sitab ) - 8 );
+            scan_next( sc );
+            scan_next( sc );
+        }
+    }
+#else
+    (void)sitab;
+#endif
+
+    if ( digits && ( has_ex || adj || ex ) )
+    {
+        buf[n++] = hex ? 'p' : 'e';
+        n += scan_put_exp( buf + n, ex + ( hex ? 4 * adj : adj ) );
+    }
+    buf[n] = '\0';
+
+    v = strtod( buf, &end );
+    if ( end != buf + n )
+        return 0;
+
+    if ( !store )
+        return 1;
+
+#if defined(CONFIG_WITH_CONV_K)
+    if ( code == 'k' )
+    {
+        unsigned int i;
+        long k;
+
+        for ( i = 0; i < pspec->xp.w_frac; i++ )
+            v *= 2.0;
+        k = (long)( v < 0.0 ? v - 0.5 : v + 0.5 );
+
+        if ( ( pspec->xp.w_int + pspec->xp.w_frac + 7 ) / 8 <= sizeof( int ) )
+            *ARG( pa, int * ) = (int)k;
+        else
+            *ARG( pa, long * ) = k;
+        return 1;
+    }
+#else
+    (void)code;
+#endif
+
+    if ( pspec->qual == 'l' )
+        *ARG( pa, double * ) = v;
+    else
+        *ARG( pa, float * ) = (float)v;
+
+    return 1;
+}
+#endif
+
+/*****************************************************************************/
+/**
+    Scan one conversion, as selected by its conversion specifier code.  The
+    conversions not built in to format() are not scanned either.
+
+    @param sc       Pointer to input state.
+    @param pspec    Pointer to format specification.
+    @param pa       Pointer to arguments.
+    @param code     Conversion specifier code.
+    @param store    Non-zero to store the value, zero if suppressed.
+
+    @return 1 if matched, 0 if not, or EXBADFORMAT if failure
+**/
+static int scan_one( T_Scan *       sc,
+                      T_FormatSpec * pspec,
+                      T_Args *       pa,
+                      char           code,
+                      int            store )
+{
+    if ( code == '%' )
+    {
+        scan_space( sc );
+        if ( scan_peek( sc ) != '%' )
+            return 0;
+        scan_next( sc );
+        return 1;
+    }
+
+#if defined(CONFIG_WITH_CONV_N)
+    if ( code == 'n' )
+    {
+        if ( store )
+            scan_store( pa, pspec->qual, (uintmax_t)sc->count );
+        return 1;
+    }
+#endif
+
+#if defined(CONFIG_WITH_CONV_C)
+    if ( code == 'c' )
+        return scan_conv_cs( sc, pspec, pa, code, store );
+#endif
+#if defined(CONFIG_WITH_CONV_S)
+    if ( code == 's' )
+        return scan_conv_cs( sc, pspec, pa, code, store );
+#endif
+
+    if ( 0
+#if defined(CONFIG_WITH_CONV_D)
+      || code == 'd' || code == 'i'
+#endif
+#if defined(CONFIG_WITH_CONV_U)
+      || code == 'u'
+#endif
+#if defined(CONFIG_WITH_CONV_X)
+      || code == 'x' || code == 'X'
+#endif
+#if defined(CONFIG_WITH_CONV_O)
+      || code == 'o'
+#endif
+#if defined(CONFIG_WITH_CONV_B)
+      || code == 'b'
+#endif
+#if defined(CONFIG_WITH_CONV_P)
+      || code == 'p'
+#endif
+#if defined(CONFIG_WITH_CONV_BASE)
+      || code == 'I' || code == 'U'
+#endif
+       )
+        return scan_conv_int( sc, pspec, pa, code, store );
+
+#if defined(NEED_SCAN_FP)
+    if ( 0
+#if defined(CONFIG_WITH_CONV_EFG)
+      || code == 'e' || code == 'E' || code == 'f' || code == 'F'
+      || code == 'g' || code == 'G'
+#endif
+#if defined(CONFIG_WITH_CONV_A)
+      || code == 'a' || code == 'A'
+#endif
+#if defined(CONFIG_WITH_CONV_K)
+      || code == 'k'
+#endif
+       )
+        return scan_conv_fp( sc, pspec, pa, code, store );
+#endif
+
+    return EXBADFORMAT;
+}
+
+/*****************************************************************************/
+/**
+    Scan the input against a format specification, sharing its parser with
+    format().  White space in the format matches any amount of white space
+    in the input, including none, and other characters match themselves.
+    A '*' straight after the '%' suppresses the assignment.  Scanning stops
+    at the end of the format, or at the first conversion or character which
+    does not match.
+
+    @param sc       Pointer to input state.
+    @param fmt      Format specification.
+    @param pa       Pointer to arguments.
+
+    @return Number of values assigned, or EXBADFORMAT if failure
+**/
+static int do_scan( T_Scan *     sc,
+                    const char * fmt,
+                    T_Args *     pa )
+{
+    T_FormatSpec fspec;
+    const void  *ptr = (const void *)fmt;
+    int          assigned = 0;
+    char         c;
+
+    while ( ( c = READ_CHAR( NORMAL_PTR, ptr ) ) )
+    {
+        int store, r;
+
+        INC_VOID_PTR( ptr );
+
+        if ( c != '%' )
+        {
+            if ( SCAN_ISSPACE( c ) )
+                scan_space( sc );
+            else if ( scan_peek( sc ) == (unsigned char)c )
+                scan_next( sc );
+            else
+                break;
+            continue;
+        }
+
+        store = ( READ_CHAR( NORMAL_PTR, ptr ) != '*' );
+        if ( !store )
+            INC_VOID_PTR( ptr );
+
+        if ( parse_spec( &fspec, pa, &ptr, NORMAL_PTR ) < 0 )
+            return EXBADFORMAT;
+
+        /* Continuation */
+        c = READ_CHAR( NORMAL_PTR, ptr );
+        if ( c == '\0' )
+        {
+#if defined(CONFIG_WITH_CONTINUATION)
+            ptr = ARG( pa, const char * );
+            continue;
+#else
+            return EXBADFORMAT;
+#endif
+        }
+        INC_VOID_PTR( ptr );
+
+        r = scan_one( sc, &fspec, pa, c, store );
+        if ( r < 0 )
+            return EXBADFORMAT;
+        if ( r == 0 )
+            break;
+        if ( store && c != 'n' && c != '%' )
+            assigned++;
+    }
+
+    return assigned;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
@@ -0,0 +1,131 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2010-2023, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/** Display template support **/
+
+/*****************************************************************************/
+/* Private types.                                                            */
+/*****************************************************************************/
+
+/**
+    A cell of the rendered text being overwritten by a conversion, and the
+    part of it which has changed.
+**/
+typedef struct {
+    char *          p;      /**< next character of the cell         **/
+    char *          end;    /**< end of the cell                    **/
+    char *          first;  /**< first changed character, or NULL   **/
+    char *          last;   /**< end of the changed characters      **/
+} T_Cell;
+
+/*****************************************************************************/
+/* Private function prototypes.  Declare as static.                          */
+/*****************************************************************************/
+
+static void * tmpl_put( void *, const char *, size_t );
+static int tmpl_same( unsigned char, const T_ArgValue *, const T_ArgValue * );
+
+/*****************************************************************************/
+/* Private functions.  Declare as static.                                    */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/**
+    Format consumer function to overwrite a cell of the rendered text,
+    noting which characters change.  Characters beyond the end of the cell
+    are dropped.
+
+    @param p        Pointer to the cell.
+    @param s        Pointer to characters to write.
+    @param n        Number of characters.
+
+    @return @a p
+**/
+static void * tmpl_put( void * p, const char * s, size_t n )
+{
+    T_Cell *pc = (T_Cell *)p;
+    char *d, *e;
+
+    if ( n > (size_t)( pc->end - pc->p ) )
+        n = (size_t)( pc->end - pc->p );
+
+    for ( d = pc->p, e = d + n; d < e; d++, s++ )
+    {
+        if ( *d != *s )
+        {
+            if ( !pc->first )
+                pc->first = d;
+            pc->last = d + 1;
+            *d = *s;
+        }
+    }
+    pc->p += n;
+
+    return p;
+}
+
+/*****************************************************************************/
+/**
+    Compare an argument with its value at the last update.  Pointers and
+    strings are never the same, as what they point to may have changed.
+
+    @param type     ARG_ type of the argument.
+    @param a        Pointer to the argument.
+    @param b        Pointer to the last value.
+
+    @return Non-zero if the argument is unchanged.
+**/
+static int tmpl_same( unsigned char      type,
+                      const T_ArgValue * a,
+                      const T_ArgValue * b )
+{
+    switch ( type )
+    {
+    case ARG_INT:       return a->i == b->i;
+    case ARG_LONG:      return a->l == b->l;
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    case ARG_LLONG:     return a->ll == b->ll;
+#endif
+    case ARG_INTMAX:    return a->j == b->j;
+    case ARG_SIZE:      return a->z == b->z;
+    case ARG_PTRDIFF:   return a->t == b->t;
+#if defined(CONFIG_WITH_FP_SUPPORT)
+    /* -0.0 == 0.0 but is written differently */
+    case ARG_DOUBLE:    return a->d == b->d && ( a->d != 0.0
+                                                 || ( 1.0 / a->d ) == ( 1.0 / b->d ) );
+#endif
+    default:            return 0;
+    }
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
@@ -176,12 +176,17 @@ static size_t xx_strlen( const char *s )
 **/
 static int emit( const char *s, char c, size_t n )
 {
+#if defined(CONFIG_WITH_BLOCK_OUTPUT)
+    if ( n && ( s ? format_write( s, n ) : format_fill( c, n ) ) == -1 )
+        return EXBADFORMAT;
+#else
     while ( n-- )
     {
         if ( s ) c = *s++;
         if ( format_putchar( c ) == -1 )
             return EXBADFORMAT;
     }
+#endif
     return 1;
 }
 
@@ -314,6 +319,7 @@ static int do_conv_numeric( T_FormatSpec * pspec,
     size_t length = 0;
     size_t numWidth, digitWidth;
     char numBuffer[BUFLEN];
+    char *pnum = numBuffer;
     size_t ps1 = 0, ps2 = 0, pz = 0, pfx_n = 0;
     char pfx_c = '\0';
     uint16_t uv;
@@ -350,18 +356,47 @@ static int do_conv_numeric( T_FormatSpec * pspec,
         uv = (uint16_t)va_arg( *ap, unsigned int );
     }
 
-    for( numWidth = 0; uv != 0; )
+    /* The small targets this is aimed at have no hardware divider, so the
+     *  digits are found without dividing.  Decimal digits are counted out
+     *  by subtracting powers of ten, most significant first; binary and
+     *  hexadecimal digits are shifted and masked out.
+     */
+    numWidth = 0;
+    if ( base == 10 )
     {
-        char cc = digits[uv % base];
-        
-        uv /= base;
+        static const uint16_t pow10[] = { 10000, 1000, 100, 10, 1 };
+        size_t i;
+
+        for ( i = 0; i < sizeof(pow10) / sizeof(pow10[0]); i++ )
+        {
+            char cc = '0';
+
+            while ( uv >= pow10[i] )
+            {
+                uv -= pow10[i];
+                cc++;
+            }
+
+            /* suppress leading zeros */
+            if ( cc != '0' || numWidth )
+                numBuffer[numWidth++] = cc;
+        }
+    }
+    else
+    {
+        unsigned int shift = ( base == 16 ) ? 4 : 1;
 
-        /* convert to lower case? */
-        if ( code == 'x' )
-            cc |= 0x20;
+        for ( pnum = &numBuffer[sizeof(numBuffer)]; uv != 0; uv >>= shift )
+        {
+            char cc = digits[uv & ( base - 1 )];
+
+            /* convert to lower case? */
+            if ( code == 'x' )
+                cc |= 0x20;
 
-        ++numWidth;
-        numBuffer[sizeof(numBuffer) - numWidth] = cc;
+            ++numWidth;
+            *--pnum = cc;
+        }
     }
 
     digitWidth = numWidth;
@@ -388,7 +423,7 @@ static int do_conv_numeric( T_FormatSpec * pspec,
     return gen_out( ps1,
                     pfx_c, pfx_n,
                     pz,
-                    &numBuffer[sizeof(numBuffer) - digitWidth], digitWidth,
+                    pnum, digitWidth,
                     ps2 );
 }
 
@@ -539,9 +574,21 @@ int microformat( const char * fmt,
         }
         else
         {
+#if defined(CONFIG_WITH_BLOCK_OUTPUT)
+            /* pass the whole run of literal text up to the next % */
+            const char *s = fmt;
+
+            while ( *fmt && *fmt != '%' )
+                fmt++;
+
+            if ( emit( s, 0, (size_t)(fmt - s) ) < 0 )
+                goto exit_badformat;
+            nChars += (unsigned int)(fmt - s);
+#else
             if ( format_putchar( *fmt++ ) == -1 )
                 goto exit_badformat;
             nChars++;
+#endif
         }
     }
 
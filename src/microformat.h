@@ -33,6 +33,7 @@
 #define MICROFORMAT_H
 
 #include <stdarg.h>
+#include <stddef.h>
 
 /* Error code returned when problem with format specification */
 
@@ -66,4 +67,18 @@ extern int microformat( const char *    /* fmt  */,
 
 extern int format_putchar( int /* c */ );
 
+/**
+    When built with CONFIG_WITH_BLOCK_OUTPUT Micro Format instead outputs
+    through these two external functions, which must be provided by the
+    implementation.  Neither is called with a count of zero.
+
+    format_write() writes @a n characters from the string @a s.
+    format_fill() writes @a n copies of the character @a c.
+
+    @returns     The number of characters written, or -1 on error.
+**/
+
+extern int format_write( const char * /* s */, size_t /* n */ );
+extern int format_fill( char /* c */, size_t /* n */ );
+
 #endif
@@ -74,6 +74,17 @@
 #define BUFLEN          ( 16 )   /* Must be long enough for 16-bit pointers
                                   * in binary */
 
+/**
+    Padding is built in a run of this many characters on the stack and sent
+    to the consumer in blocks.  Define CONFIG_TINY_PAD_RUN to trade stack
+    for fewer consumer calls.
+**/
+#if defined(CONFIG_TINY_PAD_RUN)
+  #define PAD_RUN       ( CONFIG_TINY_PAD_RUN )
+#else
+  #define PAD_RUN       ( 8 )
+#endif
+
 /**
     Return the maximum/minimum of two scalar values.
 **/
@@ -202,7 +213,7 @@ static int emit( const char *s, size_t n,
 
 /*****************************************************************************/
 /**
-    Emit @p n padding characters @p c.
+    Emit @p n padding characters @p c, in blocks of up to PAD_RUN.
 
     @param c        Padding character.
     @param n        Number of padding characters to emit.
@@ -214,9 +225,16 @@ static int emit( const char *s, size_t n,
 static int pad( char c, size_t n,
                 void * (* cons)(void *, const char *, size_t), void * * parg )
 {
-    for ( size_t i = 0; i < n; i++ )
+    char run[PAD_RUN];
+    size_t i, k = MIN( n, PAD_RUN );
+
+    for ( i = 0; i < k; i++ )
+        run[i] = c;
+
+    for ( i = n; i > 0; i -= k )
     {
-        if ( ( *parg = ( *cons )( *parg, &c, 1 ) ) == NULL )
+        k = MIN( i, PAD_RUN );
+        if ( ( *parg = ( *cons )( *parg, run, k ) ) == NULL )
             return EXBADFORMAT;
     }
     return (int)n;
@@ -382,6 +400,7 @@ static int do_conv_numeric( T_FormatSpec * pspec,
     size_t length = 0;
     size_t numWidth, digitWidth;
     char numBuffer[BUFLEN];
+    char *pnum = numBuffer;
     size_t ps1 = 0, ps2 = 0, pz = 0, pfx_n = 0;
     const char * pfx_s = NULL;
     uint16_t uv;
@@ -424,19 +443,47 @@ static int do_conv_numeric( T_FormatSpec * pspec,
         uv = (uint16_t)va_arg( *ap, unsigned int );
     }
 
-    for( numWidth = 0; uv != 0; )
+    /* The small targets this is aimed at have no hardware divider, so the
+     *  digits are found without dividing.  Decimal digits are counted out
+     *  by subtracting powers of ten, most significant first; binary and
+     *  hexadecimal digits are shifted and masked out.
+     */
+    numWidth = 0;
+    if ( base == 10 )
     {
-        uint16_t div_uv  = uv / base;
-        uint16_t div_rem = uv % base;
-        char cc = digits[div_rem];
+        static const uint16_t pow10[] = { 10000, 1000, 100, 10, 1 };
+        size_t i;
 
-        /* convert to lower case? */
-        if ( code == 'x' )
-            cc |= 0x20;
+        for ( i = 0; i < sizeof(pow10) / sizeof(pow10[0]); i++ )
+        {
+            char cc = '0';
 
-        ++numWidth;
-        numBuffer[sizeof(numBuffer) - numWidth] = cc;
-        uv = div_uv;
+            while ( uv >= pow10[i] )
+            {
+                uv -= pow10[i];
+                cc++;
+            }
+
+            /* suppress leading zeros */
+            if ( cc != '0' || numWidth )
+                numBuffer[numWidth++] = cc;
+        }
+    }
+    else
+    {
+        unsigned int shift = ( base == 16 ) ? 4 : 1;
+
+        for ( pnum = &numBuffer[sizeof(numBuffer)]; uv != 0; uv >>= shift )
+        {
+            char cc = digits[uv & ( base - 1 )];
+
+            /* convert to lower case? */
+            if ( code == 'x' )
+                cc |= 0x20;
+
+            ++numWidth;
+            *--pnum = cc;
+        }
     }
 
     digitWidth = numWidth;
@@ -464,7 +511,7 @@ static int do_conv_numeric( T_FormatSpec * pspec,
                     ps1,
                     pfx_s, pfx_n,
                     pz,
-                    &numBuffer[sizeof(numBuffer) - digitWidth], digitWidth,
+                    pnum, digitWidth,
                     ps2 );
 }
 
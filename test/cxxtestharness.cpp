@@ -0,0 +1,233 @@
+/* ***************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2010-2023, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+#include "format.hpp"
+
+/**
+    Set the size of the test buffers
+**/
+#define BUF_SZ      ( 1024 )
+
+static char buf[BUF_SZ];
+static unsigned int f = 0;
+
+/*****************************************************************************/
+/**
+    Format consumer function to write characters to a user-supplied buffer.
+
+    @param memptr   Pointer to output buffer
+    @param pbuf     Pointer to buffer of characters to consume from
+    @param n        Number of characters from @p buf to consume
+
+    @returns NULL if failed, else address of next output cell.
+**/
+static void * bufwrite( void * memptr, const char * pbuf, size_t n )
+{
+    return ( (char *)memcpy( memptr, pbuf, n ) + n );
+}
+
+/*****************************************************************************/
+/**
+    Check the result of a format call and print out accordingly.
+
+    @param line             Line number of the test
+    @param r                Returned value
+    @param exs              Expected result string
+    @param rtn              Expected return value
+**/
+static void check( int line, int r, const char *exs, int rtn )
+{
+    if ( 0 <= r )
+        buf[r] = '\0';
+    printf( "[Test  @ %3d] ", line );
+    if ( r != rtn )
+        {printf("########### FAIL: produced \"%s\", returned %d, expected %d.", buf, r, rtn );f+=1;}
+    else if ( rtn >= 0 && strcmp( exs, buf ) )
+        {printf("########### FAIL: produced \"%s\", expected \"%s\".", buf, exs);f+=1;}
+    else
+        printf("PASS");
+    printf("\n");
+}
+
+/**
+    Wrapper macros to standardise checking of test results, as in
+    testharness.c.  The format string is parsed at compile time.
+
+    @param exs              Expected result string
+    @param rtn              Expected return value
+    @param fmt              Test format string
+    @param ...              Argument list
+**/
+#define TEST(exs, rtn, ...)                                                 \
+            check( __LINE__, formatpp::format( bufwrite, buf, __VA_ARGS__ ), \
+                   (exs), (rtn) )
+
+#define FAIL(...)                                                           \
+            check( __LINE__, formatpp::format( bufwrite, buf, __VA_ARGS__ ), \
+                   "", EXBADFORMAT )
+
+/**
+    Check if two integers are the same and print out accordingly.
+**/
+#define CHECK(a,b)      do { printf("[Check @ %3d] ", __LINE__ );           \
+                            if ((a)==(b))                                   \
+                                printf( "PASS");                            \
+                            else {printf("**** FAIL: got %d, expected %d",(a),(b));f+=1;}\
+                            printf("\n");                                   \
+                        }while(0);
+
+#define F(s)        FORMAT_STRING(s)
+
+/*****************************************************************************/
+/**
+    Execute tests on text and the integer conversions.
+**/
+static void test_integers( void )
+{
+    printf( "Testing text and integers\n" );
+
+    TEST( "", 0, F("") );
+    TEST( "hello world", 11, F("hello world") );
+    TEST( "%", 1, F("%%") );
+    TEST( "% %", 3, F("%% %5%") );
+
+    TEST( "42", 2, F("%d"), 42 );
+    TEST( "  -42|", 6, F("%5d|"), -42 );
+    TEST( "-42  |", 6, F("%-5d|"), -42 );
+    TEST( "+0042", 5, F("%+.4d"), 42 );
+    TEST( "ff FF 0xff", 10, F("%x %X %#x"), 255, 255U, 255 );
+    TEST( "777 101", 7, F("%o %b"), 0777, 5 );
+    TEST( "z 1z", 4, F("%:36u %:*u"), 35, 36, 71 );
+    TEST( "4294967295", 10, F("%u"), 0xFFFFFFFFU );
+    TEST( "-1 -1", 5, F("%hhd %hd"), (signed char)-1, (short)-1 );
+    TEST( "-1234567890123", 14, F("%lld"), -1234567890123LL );
+    TEST( "123 456 789 -5", 14, F("%ld %zu %jd %td"), 123L, (size_t)456,
+          (intmax_t)789, (ptrdiff_t)-5 );
+
+    /* narrower integers are widened to the qualified type */
+    TEST( "-7 65", 5, F("%ld %lld"), -7, 'A' );
+
+    TEST( "   12", 5, F("%*d"), 5, 12 );
+    TEST( "12   |", 6, F("%*d|"), -5, 12 );
+    TEST( "00012", 5, F("%.*d"), 5, 12 );
+    TEST( "12", 2, F("%.*d"), -1, 12 );
+
+    TEST( "1,234,567", 9, F("%[,3]d"), 1234567 );
+    TEST( "12,34,567", 9, F("%[,2,3]d"), 1234567 );
+    TEST( "12_345_67", 9, F("%[_*_*]d"), 1234567, 2, 3 );
+    TEST( "1234,567 x", 10, F("%[-,3]d %s"), 1234567, "x" );
+
+    FAIL( F("%:*u"), 37, 1 );
+    FAIL( F("%*d"), 501, 1 );
+}
+
+/*****************************************************************************/
+/**
+    Execute tests on the other conversions.
+**/
+static void test_others( void )
+{
+    int n = 0;
+    short sn = 0;
+    const char *ps = "world";
+    const unsigned char v6[16] = { 0 };
+    const unsigned char mac[6] = { 0, 0, 0, 0, 0, 42 };
+
+    printf( "Testing other conversions\n" );
+
+    TEST( "A", 1, F("%c"), 'A' );
+    TEST( "----", 4, F("%.4C-") );
+    TEST( "hello world", 11, F("hello %s"), ps );
+    TEST( "wor  |", 6, F("%-5.3s|"), "world" );
+    TEST( "\"a\\tb\"  |", 9, F("%-8q|"), "a\tb" );
+    TEST( "\xc3\xa9t\xc3\xa9 \xe2\x82\xac", 9, F("%ls %lc"), L"\u00e9t\u00e9", L'\u20ac' );
+    TEST( "abc", 3, F("abc%n"), &n );
+    CHECK( n, 3 );
+    TEST( "abcdef", 6, F("abc%hndef"), &sn );
+    CHECK( sn, 3 );
+
+    TEST( "1.500000", 8, F("%f"), 1.5 );
+    TEST( "1.50", 4, F("%.2f"), 1.5f );
+    TEST( "1.2e+03", 7, F("%.1e"), 1234.0 );
+    TEST( "1.234 k", 7, F("%!.3f"), 1234.0 );
+    TEST( "0x1p+0", 6, F("%a"), 1.0 );
+    TEST( "1.500000", 8, F("%{4.4}k"), 0x18 );
+    TEST( "1.500000", 8, F("%{*.*}k"), 4, 4, 0x18 );
+    TEST( "2023-11-14T22:13:20.123Z", 24, F("%.3T"), 1700000000123456789LL );
+    TEST( "0.0.0.0 ::", 10, F("%N %#N"), (uint32_t)0, v6 );
+    TEST( "00:00:00:00:00:2A", 17, F("%M"), mac );
+
+    TEST( "hello old world", 15, F("hello %"), "old %", "world" );
+    TEST( "One: 1,Two: 2", 13, F("One: %d,%"), 1, "Two: %d", 2 );
+}
+
+#if __cplusplus >= 202002L
+/*****************************************************************************/
+/**
+    Execute tests with the format string as a template argument.
+**/
+static void test_template( void )
+{
+    printf( "Testing template format strings\n" );
+
+    check( __LINE__, formatpp::format<"%s=%[,3]u">( bufwrite, buf, "n", 1000U ),
+           "n=1,000", 7 );
+}
+#endif
+
+/*****************************************************************************/
+/* Public functions.  Defined in header file.                                */
+/*****************************************************************************/
+
+int main( void )
+{
+    test_integers();
+    test_others();
+#if __cplusplus >= 202002L
+    test_template();
+#endif
+
+    printf( "-----------------------\n"
+            "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
+    return f ? 1 : 0;
+}
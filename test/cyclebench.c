@@ -0,0 +1,312 @@
+/* ***************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2010-2023, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+#if defined(__AVR__)
+  #include <avr/io.h>
+  #include <avr/interrupt.h>
+  #include <avr/sleep.h>
+  #if !defined(F_CPU)
+    #define F_CPU       16000000UL
+  #endif
+#else
+  #include <time.h>
+#endif
+
+#if defined(BENCH_MICRO)
+  #include "microformat.h"
+  #define VARIANT       "microformat"
+#else
+  #include "format.h"
+  #define VARIANT       "tinyformat"
+#endif
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+/**
+    Cycle-count benchmark for tinyformat and microformat.
+
+    Each entry in the corpus is timed around a single call, including the
+    variadic wrapper and the (empty) output function.  The cost of formatting
+    an empty string is measured first and subtracted, and the remainder is
+    divided by the number of conversions in the format string.
+
+    On AVR the time is read from Timer1 running at the CPU clock, so the
+    results are exact cycle counts whether run on hardware or under simavr.
+    On other hosts each entry is repeated and timed with clock(), giving
+    nanoseconds instead of cycles.
+**/
+
+#define UNUSED          0
+
+#if !defined(__AVR__)
+  #define REPEAT        ( 100000UL )
+  #define UNIT          "ns"
+#else
+  #define REPEAT        ( 1UL )
+  #define UNIT          "cycles"
+#endif
+
+/*****************************************************************************/
+/* Private functions.  Declare as static.                                    */
+/*****************************************************************************/
+
+#if defined(__AVR__)
+
+static volatile uint16_t g_overflows;
+
+ISR(TIMER1_OVF_vect)
+{
+    g_overflows++;
+}
+
+static void timer_start( void )
+{
+    g_overflows = 0;
+    TCCR1A = 0;
+    TCNT1  = 0;
+    TIMSK1 = _BV(TOIE1);
+    TCCR1B = _BV(CS10);     /* count CPU clocks, no prescaler */
+}
+
+static uint32_t timer_stop( void )
+{
+    uint32_t t;
+
+    TCCR1B = 0;
+    cli();
+    if ( TIFR1 & _BV(TOV1) )    /* overflow not yet serviced */
+    {
+        g_overflows++;
+        TIFR1 = _BV(TOV1);
+    }
+    t = ( (uint32_t)g_overflows << 16 ) + TCNT1;
+    sei();
+
+    return t;
+}
+
+static int uart_putchar( char c, FILE *fp )
+{
+    (void)fp;
+    loop_until_bit_is_set( UCSR0A, UDRE0 );
+    UDR0 = c;
+    return 0;
+}
+
+static FILE uart_stream = FDEV_SETUP_STREAM( uart_putchar, NULL, _FDEV_SETUP_WRITE );
+
+static void system_init( void )
+{
+    UBRR0  = F_CPU / 16 / 9600 - 1;
+    UCSR0B = _BV(TXEN0);
+    stdout = &uart_stream;
+    sei();
+}
+
+static void system_exit( void )
+{
+    /* simavr stops when the CPU sleeps with interrupts disabled */
+    cli();
+    sleep_enable();
+    sleep_cpu();
+}
+
+#else
+
+static clock_t g_start;
+
+static void timer_start( void )
+{
+    g_start = clock();
+}
+
+static uint32_t timer_stop( void )
+{
+    return (uint32_t)( ( clock() - g_start ) * ( 1000000000.0 / CLOCKS_PER_SEC ) );
+}
+
+static void system_init( void )
+{
+    /* empty */
+}
+
+static void system_exit( void )
+{
+    /* empty */
+}
+
+#endif
+
+/*****************************************************************************/
+/**
+    Output functions, which discard their output so that only the cost of
+    formatting is measured.
+**/
+#if defined(BENCH_MICRO)
+
+int format_putchar( int c )
+{
+    return c;
+}
+
+int format_write( const char *s, size_t n )
+{
+    (void)s;
+    return (int)n;
+}
+
+int format_fill( char c, size_t n )
+{
+    (void)c;
+    return (int)n;
+}
+
+#else
+
+static void * discard( void * arg, const char * s, size_t n )
+{
+    (void)s;
+    (void)n;
+    return arg;
+}
+
+#endif
+
+/*****************************************************************************/
+/**
+    Format the arguments once, discarding the output.
+
+    @param fmt      Format string
+
+    @returns Number of characters formatted, or EXBADFORMAT.
+**/
+static int bench_format( const char *fmt, ... )
+{
+    va_list arg;
+    int done;
+
+    va_start( arg, fmt );
+#if defined(BENCH_MICRO)
+    done = microformat( fmt, arg );
+#else
+    done = format( discard, (void *)1, fmt, arg );
+#endif
+    va_end( arg );
+
+    return done;
+}
+
+static uint32_t g_base;
+
+/**
+    Time a format string and report the cost per conversion.
+
+    @param nconv            Number of conversions in the format string
+    @param fmt              Format string
+    @param ...              Argument list, at least one
+**/
+#define BENCH(nconv, fmt, ...)  do {                                        \
+            unsigned long r;                                                \
+            uint32_t t;                                                     \
+            timer_start();                                                  \
+            for ( r = 0; r < REPEAT; r++ )                                  \
+                bench_format( (fmt), __VA_ARGS__ );                         \
+            t = timer_stop() / REPEAT;                                      \
+            t = ( t > g_base ) ? t - g_base : 0;                            \
+            printf( "%-20s %-24s %8lu %8lu\n", #fmt, #__VA_ARGS__,          \
+                    (unsigned long)t,                                       \
+                    (unsigned long)( (nconv) ? t / (nconv) : t ) );         \
+            } while( 0 )
+
+/*****************************************************************************/
+/**
+    Run the benchmark corpus.
+**/
+static void run_bench( void )
+{
+    unsigned long i;
+
+    timer_start();
+    for ( i = 0; i < REPEAT; i++ )
+        bench_format( "", UNUSED );
+    g_base = timer_stop() / REPEAT;
+
+    printf( "%s, %s per call less %lu for an empty format string\n",
+            VARIANT, UNIT, (unsigned long)g_base );
+    printf( "%-20s %-24s %8s %8s\n", "format", "arguments",
+            "total", "per conv" );
+
+    BENCH( 0, "Hello, world", UNUSED );
+    BENCH( 1, "%c", 'x' );
+    BENCH( 1, "%s", "hello" );
+    BENCH( 1, "%10s", "hello" );
+    BENCH( 1, "%d", 0 );
+    BENCH( 1, "%d", 7 );
+    BENCH( 1, "%d", -12345 );
+    BENCH( 1, "%u", 65535U );
+    BENCH( 1, "%6u", 1234U );
+    BENCH( 1, "%06u", 1234U );
+    BENCH( 1, "%12d", 7 );
+    BENCH( 1, "%-16s|", "hi" );
+    BENCH( 1, "%.24c", '-' );
+    BENCH( 1, "%x", 0xBEEFU );
+    BENCH( 1, "%X", 0xBEEFU );
+    BENCH( 1, "%b", 0xA5A5U );
+    BENCH( 1, "%p", (void *)0x1234 );
+    BENCH( 3, "%d:%02u:%02u", 12, 34U, 56U );
+    BENCH( 4, "T=%d V=%u I=%x %s", -40, 3300U, 0x7FU, "ok" );
+}
+
+/*****************************************************************************/
+/* Public functions.                                                         */
+/*****************************************************************************/
+
+int main( void )
+{
+    system_init();
+    run_bench();
+    system_exit();
+    return 0;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
@@ -0,0 +1,202 @@
+/* ****************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+#include "fprintf.h"
+
+/**
+    Threads writing to one stream, and the lines each of them writes.
+**/
+#define THREADS     ( 4 )
+#define LINES       ( 2000 )
+
+static FILE *fp;
+static unsigned int f = 0;
+
+/**
+    Check if two integers are the same and print out accordingly.
+**/
+#define CHECK(a,b)      do { printf("[Check @ %3d] ", __LINE__ );           \
+                            if ((a)==(b))                                   \
+                                printf( "PASS");                            \
+                            else {printf("**** FAIL: got %d, expected %d",(int)(a),(int)(b));f+=1;}\
+                            printf("\n");                                   \
+                        }while(0);
+
+/**
+    Check what has been written to the stream since the last rewind.
+**/
+#define CHECK_FILE(exs) do { char got[256]; size_t n;                       \
+                            printf("[Test  @ %3d] ", __LINE__ );            \
+                            n = (size_t)ftell( fp );                        \
+                            rewind( fp );                                   \
+                            n = fread( got, 1, n < sizeof got ? n : sizeof got - 1, fp );\
+                            got[n] = '\0';                                  \
+                            if ( strcmp( (exs), got ) )                     \
+                                {printf("########### FAIL: produced \"%s\", expected \"%s\".", got, (exs));f+=1;}\
+                            else                                            \
+                                printf("PASS");                             \
+                            printf("\n");                                   \
+                            rewind( fp );                                   \
+                        }while(0);
+
+/*****************************************************************************/
+/**
+    Test output to a single stream.
+**/
+static void test_output( void )
+{
+    FILE *ro;
+
+    printf( "Testing output\n" );
+
+    CHECK( fprintf( fp, "%d %s", 42, "apples" ), 9 );
+    CHECK_FILE( "42 apples" );
+
+    /* Padding and literal text are sent as several spans */
+    CHECK( fprintf( fp, "[%-6s|%06x]", "ab", 255u ), 15 );
+    CHECK_FILE( "[ab    |0000ff]" );
+
+    CHECK( fprintf( fp, "%c", 'z' ), 1 );
+    CHECK_FILE( "z" );
+
+    CHECK( fprintf( fp, "%s", "" ), 0 );
+    CHECK_FILE( "" );
+
+    /* A stream which cannot be written reports an error */
+    ro = fopen( "/dev/null", "r" );
+    if ( ro != NULL )
+    {
+        CHECK( fprintf( ro, "%d", 1 ), -1 );
+        fclose( ro );
+    }
+}
+
+/*****************************************************************************/
+/**
+    Write LINES lines, each built from several spans.
+**/
+static void * writer( void * arg )
+{
+    int id = *(int *)arg;
+    int i;
+
+    for ( i = 0; i < LINES; i++ )
+        fprintf( fp, "thread %d line %5d %-20s end\n", id, i, "-" );
+
+    return NULL;
+}
+
+/*****************************************************************************/
+/**
+    Test that lines written by several threads are not mixed together.  The
+    stream buffer is smaller than a line, so a lock held per span would let
+    other threads write in the middle of a line.
+**/
+static void test_threads( void )
+{
+    static char sbuf[16];
+    pthread_t tid[THREADS];
+    int ids[THREADS];
+    int seen[THREADS] = { 0 };
+    char line[80];
+    int i, bad = 0, total = 0;
+
+    printf( "Testing threads\n" );
+
+    setvbuf( fp, sbuf, _IOFBF, sizeof sbuf );
+
+    for ( i = 0; i < THREADS; i++ )
+    {
+        ids[i] = i;
+        pthread_create( &tid[i], NULL, writer, &ids[i] );
+    }
+    for ( i = 0; i < THREADS; i++ )
+        pthread_join( tid[i], NULL );
+
+    rewind( fp );
+    while ( fgets( line, sizeof line, fp ) != NULL )
+    {
+        int id, n;
+        char end[8];
+
+        if ( strlen( line ) != 45
+             || sscanf( line, "thread %d line %d - %7s", &id, &n, end ) != 3
+             || strcmp( end, "end" )
+             || id < 0 || id >= THREADS || n != seen[id] )
+            bad++;
+        else
+            seen[id]++;
+        total++;
+    }
+
+    CHECK( bad, 0 );
+    CHECK( total, THREADS * LINES );
+}
+
+/*****************************************************************************/
+/**
+    Stream library test application.
+**/
+int main( void )
+{
+    fp = tmpfile();
+    if ( fp == NULL )
+    {
+        printf( "Cannot open a temporary file\n" );
+        return 1;
+    }
+
+    test_output();
+    test_threads();
+    fclose( fp );
+
+    printf( "-----------------------\n"
+            "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
+    return f ? 1 : 0;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
@@ -0,0 +1,545 @@
+# ***************************************************************************
+# * Format - lightweight string formatting library.
+# * Copyright (C) 2016-2023, Neil Johnson
+# * All rights reserved.
+# *
+# * Redistribution and use in source and binary forms,
+# * with or without modification,
+# * are permitted provided that the following conditions are met:
+# *
+# * * Redistributions of source code must retain the above copyright notice,
+# *   this list of conditions and the following disclaimer.
+# * * Redistributions in binary form must reproduce the above copyright notice,
+# *   this list of conditions and the following disclaimer in the
+# *   documentation and/or other materials provided with the distribution.
+# * * Neither the name of nor the names of its contributors
+# *   may be used to endorse or promote products derived from this software
+# *   without specific prior written permission.
+# *
+# * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+# * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# * ************************************************************************* */
+
+# Format string analyser.
+#
+# Scans C sources for calls to format() and the printf family, parses each
+# string literal format with the same grammar as format(), and works out the
+# smallest set of CONFIG_WITH_... options that supports all of them.
+#
+# Usage: awk -f fmtconfig.awk [-v funcs="name:argn ..."] [-v config=file]
+#                             [-v custom=1] [-v verbose=1] file.c ...
+#
+# funcs adds the caller's own wrappers, each with the position of its format
+# argument (for example "lcd_printf:2 log_msg:3"); a missing position is
+# taken as 1.  Without config the options are printed as compiler flags for
+# use with CONFIG_EXPLICIT.  With config set to a copy of format_config.h a
+# tailored version of that file is printed, with each unused option changed
+# from #define to #undef, and each optional feature which is used defined.  Calls whose format is not a string literal, or is
+# built with a macro other than the <inttypes.h> PRI macros, and continuation
+# arguments, cannot be checked and are listed as warnings.  The PRI macros
+# are read as their widest expansion, with a warning.
+# Other letters are taken as custom conversions once a file which calls
+# format_register() has been seen, or throughout with -v custom=1.
+
+BEGIN {
+    split( "format:3 printf:1 sprintf:2 snprintf:3 vprintf:1 vsprintf:2" \
+           " vsnprintf:3 fprintf:2 vfprintf:2 format_template_init:2 " funcs, t, " " )
+    for ( i in t )
+    {
+        if ( t[i] == "" )
+            continue
+        n = split( t[i], u, ":" )
+        fnarg[u[1]] = ( n > 1 ) ? u[2] + 0 : 1
+    }
+
+    nopts = split( "FP_SUPPORT LONG_LONG_SUPPORT GROUPING_SUPPORT" \
+                   " CONV_C CONV_S CONV_Q CONV_N CONV_P CONV_D CONV_U CONV_X" \
+                   " CONV_O CONV_B CONV_BASE CONV_EFG CONV_A CONV_K CONV_T CONV_NET" \
+                   " ENGINEERING UTF8 WIDE_CHARS CONTINUATION ROM_STRINGS POSITIONAL" \
+                   " TEMPLATE SCREEN CUSTOM_CONV", opts, " " )
+    for ( i = 1; i <= nopts; i++ )
+        known[opts[i]] = 1
+
+    split( "c:CONV_C C:CONV_C s:CONV_S q:CONV_Q n:CONV_N p:CONV_P d:CONV_D i:CONV_D" \
+           " I:CONV_D u:CONV_U U:CONV_U x:CONV_X X:CONV_X o:CONV_O b:CONV_B" \
+           " e:CONV_EFG E:CONV_EFG f:CONV_EFG F:CONV_EFG g:CONV_EFG" \
+           " G:CONV_EFG a:CONV_A A:CONV_A k:CONV_K T:CONV_T N:CONV_NET M:CONV_NET", t, " " )
+    for ( i in t )
+    {
+        split( t[i], u, ":" )
+        convopt[u[1]] = u[2]
+    }
+
+    # printable characters, for decoding octal and hex escapes
+    for ( i = 32; i < 127; i++ )
+        chr[i] = sprintf( "%c", i )
+}
+
+function warn(msg)
+{
+    print "fmtconfig: " file ":" line ": " msg > "/dev/stderr"
+    nwarn++
+}
+
+function need(opt, spec)
+{
+    if ( !( opt in used ) )
+        used[opt] = file ":" line ": \"" spec "\""
+}
+
+# ---------------------------------------------------------------------------
+# Tokeniser: sets tok (type) and val, skipping white space and comments.
+
+function octal(s,    i, v)
+{
+    v = 0
+    for ( i = 1; i <= length(s); i++ )
+        v = v * 8 + substr( s, i, 1 )
+    return v
+}
+
+function hex(s,    i, v)
+{
+    v = 0
+    for ( i = 1; i <= length(s); i++ )
+        v = v * 16 + index( "0123456789abcdef", tolower( substr( s, i, 1 ) ) ) - 1
+    return v
+}
+
+function quoted(q,    c, v, s)
+{
+    s = ""
+    for ( pos++; pos <= len; pos++ )
+    {
+        c = substr( src, pos, 1 )
+        if ( c == q || c == "\n" )
+            break
+        if ( c == "\\" )
+        {
+            c = substr( src, ++pos, 1 )
+            if ( c ~ /[0-7]/ )
+            {
+                match( substr( src, pos, 3 ), /^[0-7]+/ )
+                v = octal( substr( src, pos, RLENGTH ) )
+                pos += RLENGTH - 1
+                c = ( v in chr ) ? chr[v] : " "
+            }
+            else if ( c == "x" )
+            {
+                match( substr( src, pos + 1 ), /^[0-9A-Fa-f]+/ )
+                v = hex( substr( src, pos + 1, RLENGTH ) )
+                pos += RLENGTH
+                c = ( v in chr ) ? chr[v] : " "
+            }
+            else if ( c == "\n" )
+            {
+                line++
+                continue
+            }
+            else if ( c != "\\" && c != "\"" && c != "'" && c != "?" )
+                c = " "
+        }
+        s = s c
+    }
+    pos++
+    return s
+}
+
+function next_tok(    c, s, t)
+{
+    for ( ;; )
+    {
+        if ( pos > len )
+        {
+            tok = "eof"
+            return tok
+        }
+        c = substr( src, pos, 1 )
+        if ( c == "\n" )
+        {
+            line++
+            pos++
+        }
+        else if ( c == " " || c == "\t" || c == "\r" || c == "\f" )
+            pos++
+        else if ( substr( src, pos, 2 ) == "/*" )
+        {
+            s = index( substr( src, pos + 2 ), "*/" )
+            s = ( s == 0 ) ? len - pos + 1 : s + 3
+            t = substr( src, pos, s )
+            line += gsub( /\n/, "&", t )
+            pos += s
+        }
+        else if ( substr( src, pos, 2 ) == "//" )
+        {
+            while ( pos <= len && substr( src, pos, 1 ) != "\n" )
+                pos++
+        }
+        else
+            break
+    }
+
+    if ( c == "\"" )
+    {
+        tok = "str"
+        val = quoted( "\"" )
+    }
+    else if ( c == "'" )
+    {
+        tok = "chr"
+        val = quoted( "'" )
+    }
+    else if ( match( substr( src, pos ), /^[A-Za-z_][A-Za-z_0-9]*/ ) )
+    {
+        tok = "id"
+        val = substr( src, pos, RLENGTH )
+        pos += RLENGTH
+        # encoding prefixes of string literals
+        if ( val ~ /^(L|u|U|u8)$/ && substr( src, pos, 1 ) == "\"" )
+        {
+            tok = "str"
+            val = quoted( "\"" )
+        }
+    }
+    else if ( c ~ /[0-9]/ || c == "." && substr( src, pos + 1, 1 ) ~ /[0-9]/ )
+    {
+        match( substr( src, pos ), /^[0-9A-Za-z_.]+/ )
+        tok = "num"
+        val = substr( src, pos, RLENGTH )
+        pos += RLENGTH
+    }
+    else
+    {
+        tok = c
+        val = c
+        pos++
+    }
+    return tok
+}
+
+# ---------------------------------------------------------------------------
+# Parse one format string, following the order of format()'s own parser.
+
+function digits(    c)
+{
+    while ( ( c = substr( fmt, fi, 1 ) ) != "" && index( "0123456789", c ) )
+        fi++
+}
+
+# An argument number, as in "%2$d" or "*3$", needs positional arguments.
+function argnum(start,    s)
+{
+    s = fi
+    digits()
+    if ( fi > s && substr( fmt, fi, 1 ) == "$" )
+        need( "POSITIONAL", substr( fmt, start, ++fi - start ) )
+    else
+        fi = s
+}
+
+function analyse(    c, flags, qual, conv, spec, start, term)
+{
+    nfmts++
+    for ( fi = 1; fi <= length( fmt ); )
+    {
+        if ( substr( fmt, fi++, 1 ) != "%" )
+            continue
+        start = fi - 1
+        argnum( start )
+
+        for ( flags = ""; ( c = substr( fmt, fi, 1 ) ) != "" && index( " +-#0!^", c ); fi++ )
+            flags = flags c
+
+        if ( substr( fmt, fi, 1 ) == "*" )
+        {
+            fi++
+            argnum( start )
+        }
+        else
+            digits()
+
+        if ( substr( fmt, fi, 1 ) == "." )
+        {
+            if ( substr( fmt, ++fi, 1 ) == "*" )
+            {
+                fi++
+                argnum( start )
+            }
+            else
+                digits()
+        }
+
+        if ( substr( fmt, fi, 1 ) == ":" )
+        {
+            need( "CONV_BASE", substr( fmt, start, fi - start + 1 ) )
+            if ( substr( fmt, ++fi, 1 ) == "*" )
+            {
+                fi++
+                argnum( start )
+            }
+            else
+                digits()
+        }
+
+        c = substr( fmt, fi, 1 )
+        if ( c == "[" || c == "{" )
+        {
+            term = ( c == "[" ) ? "]" : "}"
+            c = index( substr( fmt, fi ), term )
+            if ( c == 0 )
+            {
+                warn( "unterminated modifier in \"" fmt "\"" )
+                return
+            }
+            fi += c
+            need( term == "]" ? "GROUPING_SUPPORT" : "CONV_K",
+                  substr( fmt, start, fi - start ) )
+        }
+
+        qual = ""
+        c = substr( fmt, fi, 1 )
+        if ( c != "" && index( "hljztL", c ) )
+        {
+            qual = c
+            if ( substr( fmt, ++fi, 1 ) == c )
+            {
+                qual = c c
+                fi++
+            }
+        }
+
+        conv = substr( fmt, fi++, 1 )
+        if ( conv == "C" )
+            fi++
+        spec = substr( fmt, start, fi - start )
+
+        if ( conv == "" )
+        {
+            need( "CONTINUATION", spec )
+            if ( index( flags, "#" ) )
+                need( "ROM_STRINGS", spec )
+            warn( "continuation in \"" fmt "\" is not checked" )
+        }
+        else if ( conv in convopt )
+        {
+            need( convopt[conv], spec )
+            if ( conv ~ /[IU]/ )
+                need( "CONV_BASE", spec )
+            if ( conv ~ /[eEfF]/ && index( flags, "!" ) )
+                need( "ENGINEERING", spec )
+            if ( conv == "s" && index( flags, "#" ) )
+                need( "ROM_STRINGS", spec )
+            if ( conv == "s" && index( flags, "!" ) && qual != "l" )
+                need( "UTF8", spec )
+            if ( conv ~ /[cs]/ && qual == "l" )
+                need( "WIDE_CHARS", spec )
+            if ( conv ~ /[eEfFgGaAk]/ )
+                need( "FP_SUPPORT", spec )
+            if ( qual == "ll" || conv == "T" )
+                need( "LONG_LONG_SUPPORT", spec )
+            if ( qual == "L" )
+                warn( "long double in \"" spec "\" is not supported" )
+        }
+        else if ( conv ~ /^[A-Za-z]$/ && custom )
+            need( "CUSTOM_CONV", spec )
+        else if ( conv != "%" )
+            warn( "invalid conversion \"" spec "\"" )
+    }
+}
+
+# ---------------------------------------------------------------------------
+# Find calls and pick out their format argument.
+
+function call(name,    argn, depth, lit, have, resume, at, unread, guess, q)
+{
+    resume = pos
+    at = line
+    argn = 1
+    depth = 0
+    lit = 1
+    have = 0
+    fmt = ""
+    unread = ""
+    guess = ""
+
+    while ( next_tok() != "eof" )
+    {
+        if ( depth == 0 && ( tok == ")" || tok == "," ) )
+        {
+            if ( argn == fnarg[name] )
+                break
+            if ( tok == ")" )
+                break
+            argn++
+            continue
+        }
+        if ( argn != fnarg[name] )
+        {
+            if ( tok == "(" || tok == "[" || tok == "{" )
+                depth++
+            else if ( tok == ")" || tok == "]" || tok == "}" )
+                depth--
+            continue
+        }
+
+        if ( tok == "str" && depth == 0 )
+        {
+            fmt = fmt val
+            have = 1
+        }
+        else if ( tok == "id" && depth == 0 && val ~ /^PRI[diouxX]/ )
+        {
+            # <inttypes.h> macros: assume the widest expansion
+            q = ( val ~ /(64|MAX)$/ ? "ll" : "l" ) substr( val, 4, 1 )
+            fmt = fmt q
+            guess = guess ", " val " as \"" q "\""
+        }
+        else
+        {
+            lit = 0
+            if ( tok == "id" && unread == "" )
+                unread = val
+            if ( tok == "(" || tok == "[" || tok == "{" )
+                depth++
+            else if ( tok == ")" || tok == "]" || tok == "}" )
+                depth--
+        }
+    }
+
+    line = at
+    if ( name == "format_template_init" )
+        need( "TEMPLATE", name "()" )
+    if ( argn != fnarg[name] )
+        warn( name "() call has no format argument" )
+    else if ( lit && have )
+    {
+        if ( guess != "" )
+            warn( name "() format is read with " substr( guess, 3 ) )
+        analyse()
+    }
+    else if ( have && unread != "" )
+        warn( name "() format is not checked, as " unread " cannot be read" )
+    else
+        warn( name "() format is not a string literal" )
+
+    # rescan the arguments for nested calls
+    pos = resume
+    line = at
+}
+
+function scan(    prev)
+{
+    len = length( src )
+    if ( index( src, "format_register" ) )
+        custom = 1
+    pos = 1
+    line = 1
+    prev = ""
+    while ( next_tok() != "eof" )
+    {
+        if ( tok == "#" )
+        {
+            # skip preprocessor directives, but scan macro bodies
+            next_tok()
+            if ( tok == "id" && val != "define" )
+            {
+                while ( pos <= len && substr( src, pos, 1 ) != "\n" )
+                    pos++
+                prev = ""
+                continue
+            }
+        }
+        if ( tok == "id" && val == "format_screen_put" )
+            need( "SCREEN", val "()" )
+        if ( tok == "id" && val == "format_register" )
+            need( "CUSTOM_CONV", val "()" )
+        if ( tok == "id" && ( val in fnarg ) && prev != "id" && prev != "*" )
+        {
+            name = val
+            if ( next_tok() == "(" )
+                call( name )
+            prev = "("
+            continue
+        }
+        prev = ( tok == "id" && val != "return" ) ? "id" : tok
+    }
+}
+
+FNR == 1 {
+    if ( NR > 1 )
+        scan()
+    file = FILENAME
+    nfiles++
+    src = ""
+}
+
+{
+    src = src $0 "\n"
+}
+
+END {
+    if ( NR > 0 )
+        scan()
+
+    if ( verbose )
+    {
+        printf( "fmtconfig: %d format strings in %d files\n",
+                nfmts, nfiles ) > "/dev/stderr"
+        for ( i = 1; i <= nopts; i++ )
+            if ( opts[i] in used )
+                printf( "  %-30s %s\n", "CONFIG_WITH_" opts[i],
+                        used[opts[i]] ) > "/dev/stderr"
+    }
+
+    if ( config == "" )
+    {
+        s = "-DCONFIG_EXPLICIT"
+        for ( i = 1; i <= nopts; i++ )
+            if ( opts[i] in used )
+                s = s " -DCONFIG_WITH_" opts[i]
+        print s
+        exit 0
+    }
+
+    while ( ( r = getline l < config ) > 0 )
+    {
+        if ( match( l, /^#define CONFIG_WITH_[A-Z_]+/ ) )
+        {
+            o = substr( l, 21, RLENGTH - 20 )
+            if ( ( o in known ) && !( o in used ) )
+                sub( /^#define/, "#undef ", l )
+        }
+        else if ( match( l, /^\/\* #define CONFIG_WITH_[A-Z_]+ \*\// ) )
+        {
+            # an optional feature, which is left out unless it is needed
+            o = substr( l, 24, RLENGTH - 26 )
+            if ( o in used )
+            {
+                rest = substr( l, RLENGTH + 1 )
+                sub( /^ +/, "", rest )
+                l = sprintf( "%-35s %s", "#define CONFIG_WITH_" o, rest )
+            }
+        }
+        print l
+        if ( l ~ /^#define FORMAT_CONFIG_H/ )
+        {
+            print ""
+            printf( "/* Tailored by fmtconfig.awk for %d format strings" \
+                    " in %d files. */\n", nfmts, nfiles )
+        }
+    }
+    if ( r < 0 )
+    {
+        print "fmtconfig: cannot read " config > "/dev/stderr"
+        exit 1
+    }
+}
@@ -0,0 +1,184 @@
+/* ***************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+/**
+    A memory consumer: the output is copied to wherever arg points, and the
+    new end is returned.  A NULL arg fails.
+**/
+static void * bufwrite( void * p, const char * s, size_t n )
+{
+    if ( p == NULL )
+        return NULL;
+
+    return (char *)memcpy( p, s, n ) + n;
+}
+
+#define FORMAT_SINK     bufwrite
+#include "format_inline.h"
+
+FORMAT_DEFINE( bprintf, bufwrite )
+
+static char buf[256];
+static unsigned int f = 0;
+
+/**
+    Check if two integers are the same and print out accordingly.
+**/
+#define CHECK(a,b)      do { printf("[Check @ %3d] ", __LINE__ );           \
+                            if ((a)==(b))                                   \
+                                printf( "PASS");                            \
+                            else {printf("**** FAIL: got %d, expected %d",(int)(a),(int)(b));f+=1;}\
+                            printf("\n");                                   \
+                        }while(0);
+
+/**
+    Format into buf and check the text and the returned length.
+**/
+#define TEST(exs, fmt, ...) do { int n_ = bprintf( buf, fmt, __VA_ARGS__ ); \
+                            printf("[Test  @ %3d] ", __LINE__ );            \
+                            buf[n_ < 0 ? 0 : n_] = '\0';                    \
+                            if ( strcmp( (exs), buf ) || n_ != (int)strlen(exs) )\
+                                {printf("########### FAIL: produced \"%s\" (%d), expected \"%s\".", buf, n_, (exs));f+=1;}\
+                            else                                            \
+                                printf("PASS");                             \
+                            printf("\n");                                   \
+                        }while(0);
+
+/*****************************************************************************/
+/**
+    Test the header-only build with its consumer bound at compile time.
+**/
+static void test_bound( void )
+{
+    printf( "Testing bound consumer\n" );
+
+    TEST( "42", "%d", 42 );
+    TEST( "[  -17|ab    ]", "[%5d|%-6s]", -17, "ab" );
+    TEST( "0x00ff", "%#06x", 255u );
+    TEST( "                            end", "%31s", "end" );
+#if defined(CONFIG_WITH_FP_SUPPORT)
+    TEST( "3.142 1.50e+03", "%.3f %.2e", 3.14159, 1500.0 );
+#endif
+#if defined(CONFIG_WITH_POSITIONAL)
+    TEST( "b a", "%2$s %1$s", "a", "b" );
+#endif
+
+    /* Failures are still reported */
+    CHECK( bprintf( NULL, "%d", 1 ), EXBADFORMAT );
+    CHECK( bprintf( buf, "%y", 1 ), EXBADFORMAT );
+}
+
+#if defined(CONFIG_WITH_TEMPLATE)
+/*****************************************************************************/
+/**
+    Template update function logging each span as "offset:text|".
+**/
+static void * spanwrite( void * p, size_t offset, const char * s, size_t n )
+{
+    return p == NULL ? NULL
+                     : (char *)p + sprintf( p, "%u:%.*s|", (unsigned)offset,
+                                            (int)n, s );
+}
+
+/*****************************************************************************/
+/**
+    Update a template, logging the spans into buf.
+**/
+static int update( struct format_template * t, ... )
+{
+    va_list ap;
+    int n;
+
+    buf[0] = '\0';
+    va_start( ap, t );
+    n = format_template_update( t, spanwrite, buf, ap );
+    va_end( ap );
+
+    return n;
+}
+
+/*****************************************************************************/
+/**
+    Test that the copy's own consumer for templates is not replaced by the
+    bound one.
+**/
+static void test_template( void )
+{
+    struct format_template t;
+    struct format_cell cells[2];
+    char text[32];
+
+    printf( "Testing templates\n" );
+
+    CHECK( format_template_init( &t, "%% T=%4d F=%-3u", cells, 2,
+                                 text, sizeof text ), 2 );
+    CHECK( strcmp( text, "% T=     F=   " ), 0 );
+    CHECK( update( &t, 21, 50u ), 14 );
+    CHECK( strcmp( buf, "0:% T=  21 F=50 |" ), 0 );
+    CHECK( update( &t, 22, 50u ), 1 );
+    CHECK( strcmp( buf, "7:2|" ), 0 );
+
+    /* The bound consumer still works alongside */
+    TEST( "7", "%d", 7 );
+}
+#endif
+
+/*****************************************************************************/
+/**
+    Run the tests.
+**/
+int main( void )
+{
+    test_bound();
+#if defined(CONFIG_WITH_TEMPLATE)
+    test_template();
+#endif
+
+    printf( "-----------------------\n"
+            "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
+    return f ? 1 : 0;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
@@ -0,0 +1,238 @@
+/* ***************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+#include "logrec.h"
+
+/**
+    A memory sink: the records are appended to buf, and each call to the
+    sink is counted.
+**/
+#define BUF_SZ      ( 1024 )
+
+static char buf[BUF_SZ];
+static size_t len;
+static unsigned int calls;
+static struct logrec_deferred kept;
+static unsigned int f = 0;
+
+/**
+    Check if two integers are the same and print out accordingly.
+**/
+#define CHECK(a,b)      do { printf("[Check @ %3d] ", __LINE__ );           \
+                            if ((a)==(b))                                   \
+                                printf( "PASS");                            \
+                            else {printf("**** FAIL: got %d, expected %d",(int)(a),(int)(b));f+=1;}\
+                            printf("\n");                                   \
+                        }while(0);
+
+/**
+    Check the records sent since the last reset, and how many calls sent
+    them.
+**/
+#define CHECK_BUF(exs, n)   do { printf("[Test  @ %3d] ", __LINE__ );       \
+                            buf[len] = '\0';                                \
+                            if ( strcmp( (exs), buf ) )                     \
+                                {printf("########### FAIL: produced \"%s\", expected \"%s\".", buf, (exs));f+=1;}\
+                            else if ( calls != (n) )                        \
+                                {printf("########### FAIL: %u calls, expected %u.", calls, (unsigned)(n));f+=1;}\
+                            else                                            \
+                                printf("PASS");                             \
+                            printf("\n");                                   \
+                            len = 0; calls = 0;                             \
+                        }while(0);
+
+/*****************************************************************************/
+/**
+    Sink function appending a record to buf.
+**/
+static int mem_write( void * arg, const char * s, size_t n )
+{
+    if ( arg != NULL || len + n >= BUF_SZ )
+        return -1;
+
+    memcpy( buf + len, s, n );
+    len += n;
+    calls++;
+
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+    Sink function keeping a deferred record.
+**/
+static int mem_defer( void * arg, const struct logrec_deferred * rec )
+{
+    (void)arg;
+    kept = *rec;
+    calls++;
+
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+    A fixed monotonic clock.
+**/
+static unsigned long long test_clock( void )
+{
+    return 12345678901ULL;
+}
+
+/*****************************************************************************/
+/**
+    Test text records.
+**/
+static void test_records( void )
+{
+    struct logrec_sink sink = { mem_write, NULL, test_clock, NULL, LOGREC_INFO };
+    char big[LOGREC_BUF_SZ + 10];
+
+    printf( "Testing records\n" );
+
+    CHECK( logrec( &sink, LOGREC_INFO, "started %d", 3 ), 26 );
+    CHECK_BUF( "12.345678 INFO  started 3\n", 1 );
+
+    /* Fields, sent with the record in one call */
+    CHECK( logrec_begin( &sink, LOGREC_WARN, "slow %s", "request" ), 0 );
+    CHECK( logrec_field( "path", "%q", "/a b" ), 0 );
+    CHECK( logrec_field( "ms", "%u", 250u ), 0 );
+    CHECK_BUF( "", 0 );
+    CHECK( logrec_end(), 48 );
+    CHECK_BUF( "12.345678 WARN  slow request path=\"/a b\" ms=250\n", 1 );
+    CHECK( logrec_end(), 0 );
+    CHECK_BUF( "", 0 );
+
+    /* Below the level of the sink */
+    CHECK( logrec_begin( &sink, LOGREC_DEBUG, "detail" ), 0 );
+    CHECK( logrec_field( "x", "%d", 1 ), 0 );
+    CHECK( logrec_end(), 0 );
+    CHECK( logrec( &sink, LOGREC_DEBUG, "detail" ), 0 );
+    CHECK_BUF( "", 0 );
+
+    /* Without a clock */
+    sink.clock = NULL;
+    CHECK( logrec( &sink, LOGREC_ERROR, "%s", "failed" ), 13 );
+    CHECK_BUF( "ERROR failed\n", 1 );
+
+    /* Long records are cut short */
+    memset( big, 'x', sizeof big - 1 );
+    big[sizeof big - 1] = '\0';
+    CHECK( logrec( &sink, LOGREC_INFO, "%s", big ), LOGREC_BUF_SZ );
+    CHECK( buf[LOGREC_BUF_SZ - 2], 'x' );
+    CHECK( buf[LOGREC_BUF_SZ - 1], '\n' );
+    len = 0; calls = 0;
+
+    /* Errors */
+    CHECK( logrec( &sink, LOGREC_INFO, "%y" ), EXBADFORMAT );
+    CHECK( logrec_end(), 0 );
+    CHECK( logrec_begin( &sink, LOGREC_INFO, "ok" ), 0 );
+    CHECK( logrec_field( "bad", "%y" ), EXBADFORMAT );
+    CHECK( logrec_end(), 14 );
+    CHECK_BUF( "INFO  ok bad=\n", 1 );
+    sink.arg = &sink;
+    CHECK( logrec( &sink, LOGREC_INFO, "lost" ), EXBADFORMAT );
+    CHECK_BUF( "", 0 );
+}
+
+/*****************************************************************************/
+/**
+    Test deferred records.
+**/
+static void test_deferred( void )
+{
+    struct logrec_sink sink = { mem_write, mem_defer, test_clock, NULL, LOGREC_INFO };
+    char text[64];
+
+    printf( "Testing deferred records\n" );
+
+    CHECK( LOGREC_DEFER( &sink, LOGREC_WARN, "queue %s at %d%%", "rx", 97 ), 0 );
+    CHECK_BUF( "", 1 );
+    CHECK( kept.nargs, 2 );
+    CHECK( logrec_render( &kept, text, sizeof text ), 32 );
+    CHECK( memcmp( text, "12.345678 WARN  queue rx at 97%\n", 32 ), 0 );
+
+    /* Cut short to the buffer */
+    CHECK( logrec_render( &kept, text, 8 ), 8 );
+    CHECK( memcmp( text, "12.3456\n", 8 ), 0 );
+    CHECK( logrec_render( &kept, text, 1 ), EXBADFORMAT );
+
+    /* Arguments are checked when the record is rendered */
+    CHECK( LOGREC_DEFER( &sink, LOGREC_INFO, "%d", "str" ), 0 );
+    CHECK( logrec_render( &kept, text, sizeof text ), EXBADFORMAT );
+    CHECK( LOGREC_DEFER( &sink, LOGREC_DEBUG, "dropped" ), 0 );
+    CHECK( LOGREC_DEFER( &sink, LOGREC_INFO, "%d%d%d%d%d%d%d%d%d",
+                         1, 2, 3, 4, 5, 6, 7, 8, 9 ), EXBADFORMAT );
+    CHECK_BUF( "", 1 );
+
+    /* Without a defer function the record is written now */
+    sink.defer = NULL;
+    CHECK( LOGREC_DEFER( &sink, LOGREC_INFO, "%ld bytes", 1234567L ), 30 );
+    CHECK_BUF( "12.345678 INFO  1234567 bytes\n", 1 );
+
+    /* ... and leaves a record being built untouched */
+    CHECK( logrec_begin( &sink, LOGREC_INFO, "request %d", 7 ), 0 );
+    CHECK( logrec_field( "path", "%s", "/a" ), 0 );
+    CHECK( LOGREC_DEFER( &sink, LOGREC_WARN, "queue %s full", "rx" ), 30 );
+    CHECK( logrec_field( "ms", "%u", 5u ), 0 );
+    CHECK( logrec_end(), 39 );
+    CHECK_BUF( "12.345678 WARN  queue rx full\n"
+               "12.345678 INFO  request 7 path=/a ms=5\n", 2 );
+}
+
+/*****************************************************************************/
+/**
+    Run the tests.
+**/
+int main( void )
+{
+    test_records();
+    test_deferred();
+
+    printf( "-----------------------\n"
+            "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
+    return f ? 1 : 0;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
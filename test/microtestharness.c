@@ -112,6 +112,7 @@ static unsigned int f = 0;
 
 static char *g_linebuf;
 static size_t g_bufidx;
+static unsigned int g_calls;
 
 /*****************************************************************************/
 /**
@@ -123,10 +124,39 @@ static size_t g_bufidx;
 **/
 int format_putchar( int c )
 {
+    g_calls++;
     g_linebuf[g_bufidx++] = c;
     return c;
 }
 
+#if defined(CONFIG_WITH_BLOCK_OUTPUT)
+/*****************************************************************************/
+/**
+    Microformat test block output functions
+
+    @param s        Pointer to the characters to output
+    @param c        The character to output
+    @param n        Number of characters to output
+
+    @returns The number of characters output, or -1 if failed.
+**/
+int format_write( const char *s, size_t n )
+{
+    g_calls++;
+    memcpy( &g_linebuf[g_bufidx], s, n );
+    g_bufidx += n;
+    return (int)n;
+}
+
+int format_fill( char c, size_t n )
+{
+    g_calls++;
+    memset( &g_linebuf[g_bufidx], c, n );
+    g_bufidx += n;
+    return (int)n;
+}
+#endif
+
 /*****************************************************************************/
 /**
     Example use of format() to implement the standard sprintf()
@@ -377,6 +407,13 @@ static void test_buxX( void )
     TEST( "1101", 4, "%b", 13 );
     TEST( "1234", 4, "%u", 1234 );
 
+    /* Every digit position of a 16-bit value */
+    TEST( "65535", 5, "%u", 65535 );
+    TEST( "10000 9999 1000 999 100 99 10 9", 31, "%u %u %u %u %u %u %u %u",
+          10000, 9999, 1000, 999, 100, 99, 10, 9 );
+    TEST( "1000000000000000", 16, "%b", 0x8000 );
+    TEST( "ffff", 4, "%x", 0xFFFF );
+
     TEST( "12cd", 4, "%x", 0x12cd );
     TEST( "12CD", 4, "%X", 0x12CD );
 
@@ -440,6 +477,23 @@ static void test_buxX( void )
     TEST( "12CD", 4, "%+ X", 0x12cd );
 }
 
+/*****************************************************************************/
+/**
+    Count the calls to the output functions
+**/
+static void test_calls( void )
+{
+    printf( "Testing output calls\n" );
+
+    g_calls = 0;
+    TEST( "   42|ab  |", 11, "%5d|%-4s|", 42, "ab" );
+#if defined(CONFIG_WITH_BLOCK_OUTPUT)
+    CHECK( g_calls, 6 );
+#else
+    CHECK( g_calls, 11 );
+#endif
+}
+
 /*****************************************************************************/
 /**
     Run all tests on format library.
@@ -453,6 +507,7 @@ static void run_tests( void )
     test_p();
     test_d();
     test_buxX();
+    test_calls();
     
     printf( "-----------------------\n"
             "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
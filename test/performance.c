@@ -38,7 +38,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <float.h>
+#include <math.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include "format.h"
 
@@ -94,6 +97,20 @@ static int test_sprintf( char *buf, const char *fmt, ... )
     return done;
 }
 
+/*****************************************************************************/
+
+static int test_sscanf( const char *str, const char *fmt, ... )
+{
+    va_list arg;
+    int done;
+
+    va_start ( arg, fmt );
+    done = format_scan( NULL, (void *)str, fmt, arg );
+    va_end ( arg );
+
+    return done;
+}
+
 /*****************************************************************************/
 /*****************************************************************************/
 
@@ -190,15 +207,399 @@ static void run_perf_tests( void )
     }
 }
 
+/*****************************************************************************/
+/**
+    Sweep the full binary exponent range, timing the %e conversion at each
+    exponent.  The spread between the fastest and slowest exponent shows how
+    much the conversion time depends on the value being converted.
+**/
+
+#define SWEEP_ITER      ( 1000 )
+#define SWEEP_REPEAT    ( 3 )
+
+static void run_sweep_tests( void )
+{
+    static char buf[BUF_SZ];
+    int e, e_min = 0, e_max = 0;
+    double t_min = 0.0, t_max = 0.0;
+
+    printf( "\n>> Sweep: %u iterations of \"%%e\" at each binary exponent "
+            "from %d to %d\n", SWEEP_ITER,
+            DBL_MIN_EXP - DBL_MANT_DIG, DBL_MAX_EXP - 1 );
+
+    for ( e = DBL_MIN_EXP - DBL_MANT_DIG; e < DBL_MAX_EXP; e++ )
+    {
+        double val = ldexp( 4.0 / 3.0, e );
+        double t_best = 0.0;
+        unsigned int i, r;
+
+        /* Take the best of several runs to filter out system noise */
+        for ( r = 0; r < SWEEP_REPEAT; r++ )
+        {
+            struct timeval start, end, delta;
+            double t;
+
+            if ( gettimeofday(&start, NULL) != 0 )
+               exit(EXIT_FAILURE);
+
+            for ( i = 0; i < SWEEP_ITER; i++ )
+                test_sprintf( buf, "%e", val );
+
+            if ( gettimeofday(&end, NULL) != 0 )
+               exit(EXIT_FAILURE);
+
+            timersub(&end, &start, &delta);
+            t = ( delta.tv_sec * 1000000.0 + delta.tv_usec ) / SWEEP_ITER;
+
+            if ( r == 0 || t < t_best )
+                t_best = t;
+        }
+
+        if ( e == DBL_MIN_EXP - DBL_MANT_DIG || t_best < t_min )
+        {
+            t_min = t_best;
+            e_min = e;
+        }
+        if ( e == DBL_MIN_EXP - DBL_MANT_DIG || t_best > t_max )
+        {
+            t_max = t_best;
+            e_max = e;
+        }
+    }
+
+    printf( "   fastest: 2^%d took %fus per iteration\n", e_min, t_min );
+    printf( "   slowest: 2^%d took %fus per iteration\n", e_max, t_max );
+    printf( "   result: slowest is %f times the fastest\n", t_max / t_min );
+}
+
+/*****************************************************************************/
+/**
+    Check the execution time bounds given in the manual.  Each conversion is
+    run across the full range of its argument, and the most steps taken by
+    any one call must not exceed the bound for the configuration.  A step is
+    one pass of a loop in format which does not send a character, counted
+    when format is built with FORMAT_COUNT_STEPS.
+**/
+
+extern unsigned long format_steps;
+
+/**
+    Steps in the radix conversion: six for the bounded-time conversion, and
+    otherwise up to 51 to normalise a denormal, 52 for the significand and
+    1073 for the exponent.
+**/
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+  #define FP_RADIX_STEPS    ( 6 )
+#else
+  #define FP_RADIX_STEPS    ( 51 + 52 + 1073 )
+#endif
+
+/**
+    The bounds, as given in the manual for 64-bit doubles.  Turning the
+    decimal mantissa into digits takes up to 32 steps, and counting the
+    digits of the exponent up to 3 (4 for %a).
+**/
+struct bound {
+    const char *    fmt;    /**< conversion to check            **/
+    char            type;   /**< 'd' double, 'k' fixed point, 'u' integer **/
+    unsigned long   bound;  /**< most steps allowed in one call **/
+};
+
+static const struct bound bounds[] = {
+    { "%e",             'd', FP_RADIX_STEPS + 32 + 3 },
+    { "%f",             'd', FP_RADIX_STEPS + 32 },
+    { "%g",             'd', FP_RADIX_STEPS + 32 + 16 + 3 },
+    { "%!e",            'd', FP_RADIX_STEPS + 32 + 3 },
+    { "%!f",            'd', FP_RADIX_STEPS + 32 + 8 + 3 },
+    { "%a",             'd', FP_RADIX_STEPS + 13 + 4 },
+    { "%{16.16}k",      'k', 32 + 52 + FP_RADIX_STEPS + 32 },
+    { "%{24.24}k",      'k', 48 + 52 + FP_RADIX_STEPS + 32 },
+    { "%llu",           'u', 0 },
+    { "%llx",           'u', 0 },
+    { "%llo",           'u', 0 },
+    { "%llb",           'u', 0 },
+    { NULL,             0,   0 }
+};
+
+/**
+    Run one conversion of the bound being checked, and return the steps
+    it took.
+**/
+static unsigned long count_steps( const struct bound * pb, double d,
+                                  unsigned long long u )
+{
+    static char buf[BUF_SZ];
+
+    format_steps = 0;
+    if ( pb->type == 'd' )
+        test_sprintf( buf, pb->fmt, d );
+    else if ( pb->type == 'k' )
+        test_sprintf( buf, pb->fmt, (long)u );
+    else
+        test_sprintf( buf, pb->fmt, u );
+
+    return format_steps;
+}
+
+static unsigned int run_bound_tests( void )
+{
+    const struct bound *pb;
+    unsigned int failures = 0;
+
+    printf( "\n>> Bounds: most steps taken by one conversion, across the full "
+            "range of its argument\n" );
+
+    for ( pb = bounds; pb->fmt; pb++ )
+    {
+        unsigned long most = 0, steps;
+        int e;
+
+        if ( pb->type == 'd' )
+        {
+            /* Every binary exponent, including denormals, with one and with
+             *  all of the bits of the significand set.
+             */
+            for ( e = DBL_MIN_EXP - DBL_MANT_DIG; e < DBL_MAX_EXP; e++ )
+            {
+                steps = count_steps( pb, ldexp( 1.0, e ), 0 );
+                most  = steps > most ? steps : most;
+                steps = count_steps( pb, -ldexp( 2.0 - DBL_EPSILON, e - 1 ), 0 );
+                most  = steps > most ? steps : most;
+            }
+        }
+        else
+        {
+            /* Every bit position, alone and with all the bits below it */
+            for ( e = 0; e < 64; e++ )
+            {
+                unsigned long long bit = 1ULL << e;
+
+                steps = count_steps( pb, 0.0, bit );
+                most  = steps > most ? steps : most;
+                steps = count_steps( pb, 0.0, bit | ( bit - 1 ) );
+                most  = steps > most ? steps : most;
+            }
+        }
+
+        printf( "   %-10s %5lu steps, bound %5lu  %s\n", pb->fmt, most,
+                pb->bound, most <= pb->bound ? "PASS" : "**** FAIL" );
+        if ( most > pb->bound )
+            failures++;
+    }
+
+    return failures;
+}
+
+/*****************************************************************************/
+/**
+    Time ISO-8601 timestamps advancing 1ms per line, as in a log, built from
+    a struct tm with six integer conversions and with one %T conversion.
+**/
+
+#define TIMESTAMP_BASE  ( 1700000000LL )
+
+static int tm_test( unsigned int count, char *fmt, double val )
+{
+    static char buf[BUF_SZ];
+    unsigned int i;
+
+    (void)val;
+    for ( i = 0; i < count; i++ )
+    {
+        time_t t = (time_t)( TIMESTAMP_BASE + i / 1000 );
+        struct tm tm;
+
+        gmtime_r( &t, &tm );
+        test_sprintf( buf, fmt, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                      tm.tm_hour, tm.tm_min, tm.tm_sec, i % 1000 );
+    }
+
+    return 0;
+}
+
+static int conv_t_test( unsigned int count, char *fmt, double val )
+{
+    static char buf[BUF_SZ];
+    unsigned int i;
+
+    (void)val;
+    for ( i = 0; i < count; i++ )
+        test_sprintf( buf, fmt, TIMESTAMP_BASE * 1000000000LL + i * 1000000LL );
+
+    return 0;
+}
+
+static void run_timestamp_tests( void )
+{
+    static char buf_ts[BUF_SZ];
+    unsigned int Ttm, Tconv;
+
+    printf( "\n>> Timestamps: %u iterations of \"", NUM_ITER );
+    test_sprintf( buf_ts, "%.3T", TIMESTAMP_BASE * 1000000000LL );
+    printf( "%s\"\n", buf_ts );
+
+    Ttm   = run_timed_loop( "struct tm", tm_test, NUM_ITER,
+                            "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", 0.0 );
+    Tconv = run_timed_loop( "%T       ", conv_t_test, NUM_ITER, "%.3T", 0.0 );
+
+    printf( "   result: %%T is %f times faster\n", (double)Ttm / Tconv );
+}
+
+/*****************************************************************************/
+/**
+    Time quoting a JSON string which needs no escapes, and one with an
+    escape every 16 characters, and counting its UTF-8 code points, against
+    copying it with %s.
+**/
+
+static int string_test( unsigned int count, char *fmt, double val )
+{
+    static char buf[BUF_SZ];
+    static char str[512];
+    unsigned int i;
+
+    memset( str, 'x', sizeof( str ) - 1 );
+    if ( val != 0.0 )
+        for ( i = 15; i < sizeof( str ) - 1; i += 16 )
+            str[i] = '\n';
+
+    for ( i = 0; i < count; i++ )
+        test_sprintf( buf, fmt, str );
+
+    return 0;
+}
+
+static void run_quote_tests( void )
+{
+    unsigned int Ts, Tq, Tqe, Tu;
+
+    printf( "\n>> Strings: %u iterations of 511 characters\n", NUM_ITER );
+
+    Ts  = run_timed_loop( "%s          ", string_test, NUM_ITER, "%s", 0.0 );
+    Tq  = run_timed_loop( "%q          ", string_test, NUM_ITER, "%q", 0.0 );
+    Tqe = run_timed_loop( "%q, escapes ", string_test, NUM_ITER, "%q", 1.0 );
+    Tu  = run_timed_loop( "%!.500s     ", string_test, NUM_ITER, "%!.500s", 0.0 );
+
+    printf( "   result: %%q is %f times %%s, %f with escapes\n",
+            (double)Tq / Ts, (double)Tqe / Ts );
+    printf( "   result: %%!.500s is %f times %%s\n", (double)Tu / Ts );
+}
+
+/*****************************************************************************/
+/**
+    Time writing a MAC address and an IPv4 address with the %N and %M
+    conversions, against writing them a byte at a time.
+**/
+
+static int address_test( unsigned int count, char *fmt, double val )
+{
+    static char buf[BUF_SZ];
+    static const unsigned char mac[6] = { 0x00, 0x1a, 0x2b, 0xc3, 0xd4, 0xef };
+    static const unsigned char ip[4]  = { 192, 168, 1, 10 };
+    unsigned int i;
+
+    for ( i = 0; i < count; i++ )
+    {
+        if ( val != 0.0 )
+        {
+            uint32_t addr;
+
+            memcpy( &addr, ip, sizeof addr );
+            test_sprintf( buf, fmt, mac, addr );
+        }
+        else
+            test_sprintf( buf, fmt, mac[0], mac[1], mac[2], mac[3], mac[4],
+                          mac[5], ip[0], ip[1], ip[2], ip[3] );
+    }
+
+    return 0;
+}
+
+static void run_address_tests( void )
+{
+    unsigned int Tbytes, Tconv;
+
+    printf( "\n>> Addresses: %u iterations of \"00:1A:2B:C3:D4:EF 192.168.1.10\"\n",
+            NUM_ITER );
+
+    Tbytes = run_timed_loop( "%02X, %u", address_test, NUM_ITER,
+                             "%02X:%02X:%02X:%02X:%02X:%02X %u.%u.%u.%u", 0.0 );
+    Tconv  = run_timed_loop( "%M %N   ", address_test, NUM_ITER, "%M %N", 1.0 );
+
+    printf( "   result: %%M %%N is %f times faster\n", (double)Tbytes / Tconv );
+}
+
+/*****************************************************************************/
+/**
+    Time reading back a line of integers and a grouped number with
+    format_scan(), against sscanf() without the grouping.
+**/
+
+static int scan_test( unsigned int count, char *fmt, double val )
+{
+    static const char line[] = "1234567890 42 -98765 3141592653";
+    unsigned int i;
+    long a, b, c, d;
+
+    for ( i = 0; i < count; i++ )
+    {
+        if ( val != 0.0 )
+            test_sscanf( line, fmt, &a, &b, &c, &d );
+        else
+            sscanf( line, fmt, &a, &b, &c, &d );
+    }
+
+    return 0;
+}
+
+static int scan_grouped_test( unsigned int count, char *fmt, double val )
+{
+    static const char line[] = "1,234,567,890";
+    unsigned int i;
+    long a;
+
+    (void)val;
+    for ( i = 0; i < count; i++ )
+        test_sscanf( line, fmt, &a );
+
+    return 0;
+}
+
+static void run_scan_tests( void )
+{
+    unsigned int Tnative, Tscan;
+
+    printf( "\n>> Scanning: %u iterations of \"1234567890 42 -98765 3141592653\"\n",
+            NUM_ITER );
+
+    Tnative = run_timed_loop( "sscanf     ", scan_test, NUM_ITER, "%ld %ld %ld %ld", 0.0 );
+    Tscan   = run_timed_loop( "format_scan", scan_test, NUM_ITER, "%ld %ld %ld %ld", 1.0 );
+    run_timed_loop( "%[,3]ld    ", scan_grouped_test, NUM_ITER, "%[,3]ld", 0.0 );
+
+    printf( "   result: format_scan is %f times faster than sscanf\n",
+            (double)Tnative / Tscan );
+}
+
 /*****************************************************************************/
 /* Public functions.                                                         */
 /*****************************************************************************/
 
 int main( int argc, char *argv[] )
 {
+    unsigned int failures;
+
     printf( ":: format performance test harness ::\n");
     run_perf_tests();
-    return 0;
+    run_sweep_tests();
+    failures = run_bound_tests();
+    run_timestamp_tests();
+    run_quote_tests();
+    run_address_tests();
+    run_scan_tests();
+
+    printf( "-----------------------\n"
+            "Summary: %s (%u failures)\n", failures ? "FAIL" : "PASS", failures );
+    return failures ? 1 : 0;
 }
 
 /*****************************************************************************/
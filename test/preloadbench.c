@@ -0,0 +1,116 @@
+/* ***************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+/**
+    Benchmark of the printf shim, lib/preload.c.
+
+    This is an ordinary program using only the C library, so the shim is
+    measured as it would be with an unmodified binary: run it once as it is
+    and once with LD_PRELOAD=./libformatpreload.so, and compare.  Each entry
+    is timed over batches of REPEAT calls of snprintf() into a buffer, and of
+    fprintf() to /dev/null.  The floating point entry is passed on to the C library by
+    the shim, so shows the cost of checking the format string.
+**/
+
+#define REPEAT          ( 100000L )
+
+/*****************************************************************************/
+/* Private functions.  Declare as static.                                    */
+/*****************************************************************************/
+
+static double now_ns( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+    Time one entry, printing the nanoseconds per call for each function.
+    The best of BATCHES batches is taken, to leave out other activity.
+**/
+#define BATCHES         ( 5 )
+
+#define TIME(best, call)    do { int b_; long i_; double t_;               \
+                            for ( best = 1e9, b_ = 0; b_ < BATCHES; b_++ )  \
+                            {                                               \
+                                t_ = now_ns();                              \
+                                for ( i_ = 0; i_ < REPEAT; i_++ )           \
+                                    call;                                   \
+                                t_ = ( now_ns() - t_ ) / REPEAT;            \
+                                best = t_ < best ? t_ : best;               \
+                            }                                               \
+                        }while(0)
+
+#define BENCH(fmt, ...)     do { char buf_[256]; double s_, f_;             \
+                            TIME( s_, snprintf( buf_, sizeof buf_, fmt, __VA_ARGS__ ) );\
+                            TIME( f_, fprintf( null, fmt, __VA_ARGS__ ) );  \
+                            printf( "%-34s %8.1f %8.1f\n", #fmt, s_, f_ );  \
+                        }while(0)
+
+/*****************************************************************************/
+/**
+    Run the benchmarks.
+**/
+int main( void )
+{
+    FILE * null = fopen( "/dev/null", "w" );
+
+    if ( null == NULL )
+        return 1;
+
+    printf( "%-34s %8s %8s\n", "ns per call", "snprintf", "fprintf" );
+
+    BENCH( "%d", 12345 );
+    BENCH( "%s", "hello, world" );
+    BENCH( "%08x %08x", 0xdeadbeefu, 0x1234u );
+    BENCH( "%-12s|%6d|%6u", "name", -42, 42u );
+    BENCH( "id=%lu len=%zu %s", 123456789UL, (size_t)512, "ok" );
+    BENCH( "%lld", -1234567890123456789LL );
+    BENCH( "%.3f", 3.14159 );
+
+    fclose( null );
+    return 0;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
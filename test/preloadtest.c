@@ -0,0 +1,244 @@
+/* ***************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+
+/**
+    Tests of the printf shim, lib/preload.c.  Run with the shim preloaded:
+
+        LD_PRELOAD=./libformatpreload.so ./preloadtest
+
+    Each call through the shim is checked against the C library's own
+    vsnprintf(), both for formats which format writes and for those it
+    passes on to the C library.
+**/
+
+static int (* libc_vsnprintf)( char *, size_t, const char *, va_list );
+static unsigned int f = 0;
+
+extern int __snprintf_chk( char *, size_t, int, size_t, const char *, ... );
+
+/**
+    Check if two integers are the same and print out accordingly.
+**/
+#define CHECK(a,b)      do { printf("[Check @ %3d] ", __LINE__ );           \
+                            if ((a)==(b))                                   \
+                                printf( "PASS");                            \
+                            else {printf("**** FAIL: got %d, expected %d",(int)(a),(int)(b));f+=1;}\
+                            printf("\n");                                   \
+                        }while(0);
+
+/**
+    Compare snprintf() with the C library's vsnprintf(), with a buffer size.
+**/
+#define TESTN(sz, fmt, ...) do { char a_[256], b_[256]; int ra_, rb_;      \
+                            memset( a_, 'x', sizeof a_ );                   \
+                            memset( b_, 'x', sizeof b_ );                   \
+                            ra_ = snprintf( a_, (sz), fmt, __VA_ARGS__ );   \
+                            rb_ = libc_printf( b_, (sz), fmt, __VA_ARGS__ );\
+                            printf("[Test  @ %3d] ", __LINE__ );            \
+                            if ( ra_ != rb_ || memcmp( a_, b_, sizeof a_ ) )\
+                                {printf("########### FAIL: \"%s\" produced \"%.*s\" (%d), expected \"%.*s\" (%d).", fmt, (int)MIN_SZ(sz), a_, ra_, (int)MIN_SZ(sz), b_, rb_);f+=1;}\
+                            else                                            \
+                                printf("PASS");                             \
+                            printf("\n");                                   \
+                        }while(0);
+
+#define TEST(fmt, ...)      TESTN( sizeof a_, fmt, __VA_ARGS__ )
+
+#define MIN_SZ(sz)          ( (sz) < 256 ? (sz) : 256 )
+
+/*****************************************************************************/
+/**
+    The C library's snprintf().
+**/
+static int libc_printf( char * buf, size_t n, const char * fmt, ... )
+{
+    va_list ap;
+    int done;
+
+    va_start( ap, fmt );
+    done = libc_vsnprintf( buf, n, fmt, ap );
+    va_end( ap );
+
+    return done;
+}
+
+/*****************************************************************************/
+/**
+    Test the formats which format writes.
+**/
+static void test_plain( void )
+{
+    printf( "Testing plain formats\n" );
+
+    TEST( "plain %s", "text" );
+    TEST( "%d %i %u %o %x %X", -42, 42, 42u, 42u, 255u, 255u );
+    TEST( "[%-8d|%+08d|% d|%08.3d]", -7, 7, 7, 7 );
+    TEST( "[%#x|%#X|%#o|%#x|%#010x]", 255u, 255u, 8u, 0u, 255u );
+    TEST( "%hhd %hhu %hd %hu", 300, 300, 70000, 70000 );
+    TEST( "%ld %lu %lld %llu", LONG_MIN, ULONG_MAX, LLONG_MIN, ULLONG_MAX );
+    TEST( "%jd %zu %td", (intmax_t)-9, (size_t)9, (ptrdiff_t)-3 );
+    TEST( "%*d|%-*d|%.*d|%*.*d", 5, 1, 5, 2, 3, 3, -6, 2, 4 );
+    TEST( "[%c|%-c]", 'a', 'b' );
+    TEST( "[%s|%10s|%-10s|%.2s|%5.1s]", "abc", "abc", "abc", "abc", "abc" );
+    TEST( "[%s|%.8s]", (char *)NULL, (char *)NULL );
+    TEST( "100%% %s", "done" );
+    TEST( "%300d", 1 );
+
+    /* Bounded output */
+    TESTN( 5, "%s", "truncated" );
+    TESTN( 1, "%d", 12345 );
+    TESTN( 0, "%d", 12345 );
+}
+
+/*****************************************************************************/
+/**
+    Test the formats which are passed on to the C library.
+**/
+static void test_passed( void )
+{
+    int n1 = 0, n2 = 0;
+    char fmt[8];
+
+    printf( "Testing formats passed to the C library\n" );
+
+    TEST( "%f %e %g %a", 0.1, 1e-300, 123456789.0, 1.0 );
+    TEST( "%.20f", 0.1 );
+    TEST( "%p %p", (void *)&f, (void *)NULL );
+    TEST( "[%.3s|%3c|%#o|%#.3o]", (char *)NULL, 'x', 8u, 8u );
+    TEST( "%2$s %1$s", "a", "b" );
+    TEST( "%ls|%lc", L"wide", (wint_t)L'w' );
+    TEST( "%05c|%.3c|%5%", 'a', 'b' );
+    TEST( "[%3c|%-3c|%600d|%.*d]", 'a', 'b', 1, 501, 2 );
+    TEST( "%d%n", 123, &n1 );
+    libc_printf( NULL, 0, "%d%n", 123, &n2 );
+    CHECK( n1, n2 );
+
+    /* A format string changed between calls is checked again */
+    strcpy( fmt, "%d" );
+    TEST( fmt, 12 );
+    strcpy( fmt, "%.1f" );
+    TEST( fmt, 2.5 );
+    strcpy( fmt, "%x" );
+    TEST( fmt, 255u );
+}
+
+/*****************************************************************************/
+/**
+    Test the other members of the family.
+**/
+static void test_family( void )
+{
+    char buf[64], * s = NULL;
+    FILE * fp = tmpfile();
+
+    printf( "Testing the printf family\n" );
+
+    CHECK( sprintf( buf, "%05d:%s", 42, "ok" ), 8 );
+    CHECK( strcmp( buf, "00042:ok" ), 0 );
+
+    CHECK( asprintf( &s, "%s-%d", "asprintf", 99 ), 11 );
+    CHECK( s != NULL && strcmp( s, "asprintf-99" ) == 0, 1 );
+    free( s );
+    CHECK( asprintf( &s, "%.1f", 2.25 ), 3 );
+    CHECK( s != NULL && strcmp( s, "2.2" ) == 0, 1 );
+    free( s );
+
+    CHECK( __snprintf_chk( buf, 4, 1, sizeof buf, "%d", 12345 ), 5 );
+    CHECK( strcmp( buf, "123" ), 0 );
+
+    CHECK( fp != NULL, 1 );
+    if ( fp == NULL )
+        return;
+
+    CHECK( fprintf( fp, "[%6s]", "file" ), 8 );
+    CHECK( fprintf( fp, "%.2f", 0.5 ), 4 );
+    fflush( fp );
+    CHECK( dprintf( fileno( fp ), "%*d|", 600, 1 ), 601 );
+    CHECK( dprintf( fileno( fp ), "%x", 0xbeefu ), 4 );
+
+    rewind( fp );
+    memset( buf, 0, sizeof buf );
+    CHECK( fread( buf, 1, 13, fp ), 13 );
+    CHECK( strcmp( buf, "[  file]0.50 " ), 0 );
+    CHECK( fseek( fp, 12 + 599, SEEK_SET ), 0 );
+    CHECK( fread( buf, 1, 7, fp ), 6 );
+    CHECK( memcmp( buf, "1|beef", 6 ), 0 );
+    fclose( fp );
+}
+
+/*****************************************************************************/
+/**
+    Run the tests.
+**/
+int main( void )
+{
+    void * libc = dlopen( "libc.so.6", RTLD_NOW | RTLD_NOLOAD );
+    void * real = libc ? dlsym( libc, "vsnprintf" ) : NULL;
+
+    if ( real == NULL )
+    {
+        printf( "Cannot find the C library\n" );
+        return 1;
+    }
+    *(void **)&libc_vsnprintf = real;
+
+    /* The shim must be in front of the C library */
+    CHECK( dlsym( RTLD_DEFAULT, "vsnprintf" ) != real, 1 );
+
+    test_plain();
+    test_passed();
+    test_family();
+
+    printf( "-----------------------\n"
+            "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
+    return f ? 1 : 0;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
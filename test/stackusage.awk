@@ -0,0 +1,140 @@
+# ***************************************************************************
+# * Format - lightweight string formatting library.
+# * Copyright (C) 2016-2023, Neil Johnson
+# * All rights reserved.
+# *
+# * Redistribution and use in source and binary forms,
+# * with or without modification,
+# * are permitted provided that the following conditions are met:
+# *
+# * * Redistributions of source code must retain the above copyright notice,
+# *   this list of conditions and the following disclaimer.
+# * * Redistributions in binary form must reproduce the above copyright notice,
+# *   this list of conditions and the following disclaimer in the
+# *   documentation and/or other materials provided with the distribution.
+# * * Neither the name of nor the names of its contributors
+# *   may be used to endorse or promote products derived from this software
+# *   without specific prior written permission.
+# *
+# * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+# * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# * ************************************************************************* */
+
+# Worst-case stack depth report.
+#
+# Reads the call graph written by gcc -fcallgraph-info=su and prints the
+# frame size of each function together with the deepest path below it.
+# Calls to functions outside the graph (the consumer function, libc) are
+# counted as zero and listed at the end, as their usage must be added by
+# the caller.
+#
+# Usage: awk -f stackusage.awk [-v root=format] [-v verbose=1] file.ci
+#
+# Without verbose only a one-line summary is printed, prefixed by tag.
+
+function name(t,    n)
+{
+    n = t
+    sub( /^.*:/, "", n )
+    return n
+}
+
+function depth(f,    i, d, m, c)
+{
+    if ( f in memo )
+        return memo[f]
+    if ( f in busy )
+    {
+        recursive = recursive " " name(f)
+        return 0
+    }
+    busy[f] = 1
+    m = 0
+    path[f] = ""
+    for ( i = 1; i <= ncallee[f]; i++ )
+    {
+        c = callee[f, i]
+        d = depth(c)
+        if ( d > m || path[f] == "" )
+        {
+            m = d
+            path[f] = c
+        }
+    }
+    delete busy[f]
+    memo[f] = frame[f] + m
+    return memo[f]
+}
+
+BEGIN {
+    if ( root == "" )
+        root = "format"
+}
+
+/^node:/ {
+    t = $0; sub( /^.*title: "/, "", t ); sub( /".*$/, "", t )
+    if ( match( $0, /[0-9]+ bytes/ ) )
+    {
+        frame[t] = substr( $0, RSTART, RLENGTH ) + 0
+        funcs[++nfuncs] = t
+    }
+    else
+        external[t] = 1
+    next
+}
+
+/^edge:/ {
+    s = $0; sub( /^.*sourcename: "/, "", s ); sub( /".*$/, "", s )
+    d = $0; sub( /^.*targetname: "/, "", d ); sub( /".*$/, "", d )
+    if ( !( (s, d) in seen ) )
+    {
+        seen[s, d] = 1
+        callee[s, ++ncallee[s]] = d
+    }
+}
+
+END {
+    for ( i = 1; i <= nfuncs; i++ )
+        if ( name(funcs[i]) == root )
+            top = funcs[i]
+    if ( top == "" )
+    {
+        print "stackusage: no function '" root "' in call graph" > "/dev/stderr"
+        exit 1
+    }
+
+    if ( verbose )
+    {
+        printf( "%-40s %6s %6s\n", "function", "frame", "worst" )
+        for ( i = 1; i <= nfuncs; i++ )
+            printf( "%-40s %6d %6d\n", name(funcs[i]), frame[funcs[i]],
+                    depth(funcs[i]) )
+    }
+
+    total = depth(top)
+    s = name(top)
+    for ( f = path[top]; f != "" && !( f in external ); f = path[f] )
+        s = s " > " name(f)
+
+    printf( "%6d  %s(%s)\n", total, tag, s )
+
+    if ( verbose )
+    {
+        ext = ""
+        for ( f in external )
+            ext = ext " " ( f == "__indirect_call" ? "consumer" : f )
+        if ( ext != "" )
+            print "  plus:" ext
+    }
+    if ( recursive != "" )
+        print "  recursion ignored at:" recursive
+}
@@ -148,6 +148,185 @@ static int test_sprintf( char *pbuf, const char *fmt, ... )
     return done;
 }
 
+#if defined(CONFIG_WITH_SCAN)
+/*****************************************************************************/
+/**
+    Example use of format_scan() to implement the standard sscanf()
+
+    @param str      String to scan
+    @param fmt      Format string
+
+    @returns Number of values stored, or -1 if failed.
+**/
+static int test_sscanf( const char *str, const char *fmt, ... )
+{
+    va_list arg;
+    int done;
+
+    va_start ( arg, fmt );
+    done = format_scan( NULL, (void *)str, fmt, arg );
+    va_end ( arg );
+
+    return done;
+}
+
+/**
+    Producer state for test_bscanf(): the rest of the text, and the size of
+    each block it is cut into.
+**/
+struct blocks {
+    const char *    p;
+    size_t          n;
+};
+
+/*****************************************************************************/
+/**
+    Format producer function to read a string in small blocks.
+
+    @param memptr   Pointer to producer state
+    @param pn       Pointer to size of the returned block
+
+    @returns Pointer to the next block, or NULL at the end.
+**/
+static const char * blockread( void * memptr, size_t * pn )
+{
+    struct blocks *b = memptr;
+    const char *p = b->p;
+
+    if ( *p == '\0' )
+        return NULL;
+
+    *pn = strlen( p ) < b->n ? strlen( p ) : b->n;
+    b->p += *pn;
+    return p;
+}
+
+/*****************************************************************************/
+/**
+    Scan a string which is passed to format_scan() a few characters at a
+    time.
+
+    @param str      String to scan
+    @param n        Size of each block
+    @param fmt      Format string
+
+    @returns Number of values stored, or -1 if failed.
+**/
+static int test_bscanf( const char *str, size_t n, const char *fmt, ... )
+{
+    struct blocks b;
+    va_list arg;
+    int done;
+
+    b.p = str;
+    b.n = n;
+    va_start ( arg, fmt );
+    done = format_scan( blockread, &b, fmt, arg );
+    va_end ( arg );
+
+    return done;
+}
+#endif
+
+#if defined(CONFIG_WITH_TEMPLATE)
+/*****************************************************************************/
+/**
+    Template update function to log each span as "offset:text|" in a
+    user-supplied buffer.
+
+    @param memptr   Pointer to output buffer
+    @param offset   Offset of the span in the template text
+    @param pbuf     Pointer to the span
+    @param n        Length of the span
+
+    @returns Address of next output cell.
+**/
+static void * spanwrite( void * memptr, size_t offset, const char * pbuf, size_t n )
+{
+    char *p = memptr;
+
+    p += sprintf( p, "%u:", (unsigned int)offset );
+    memcpy( p, pbuf, n );
+    p[n] = '|';
+    p[n + 1] = '\0';
+
+    return p + n + 1;
+}
+
+/*****************************************************************************/
+/**
+    Update a template, logging the spans sent in buf.
+
+    @param t        Pointer to the template
+    @param ...      Argument list
+
+    @returns Number of characters sent, or -1 if failed.
+**/
+static int test_update( struct format_template *t, ... )
+{
+    va_list arg;
+    int done;
+
+    buf[0] = '\0';
+    va_start ( arg, t );
+    done = format_template_update( t, spanwrite, buf, arg );
+    va_end ( arg );
+
+    return done;
+}
+#endif
+
+#if defined(CONFIG_WITH_SCREEN)
+/*****************************************************************************/
+/**
+    Screen row function to log each run as "(x,y)text|" in a user-supplied
+    buffer.
+
+    @param memptr   Pointer to output buffer
+    @param x        Column of the run
+    @param y        Row of the run
+    @param pbuf     Pointer to the run
+    @param n        Length of the run
+
+    @returns Address of next output cell.
+**/
+static void * rowwrite( void * memptr, unsigned int x, unsigned int y,
+                        const char * pbuf, size_t n )
+{
+    char *p = memptr;
+
+    p += sprintf( p, "(%u,%u)", x, y );
+    memcpy( p, pbuf, n );
+    p[n] = '|';
+    p[n + 1] = '\0';
+
+    return p + n + 1;
+}
+
+/*****************************************************************************/
+/**
+    Format to a screen, logging the runs sent in buf.
+
+    @param sc       Pointer to the screen
+    @param fmt      Format string
+
+    @returns Number of characters printed, or -1 if failed.
+**/
+static int test_screen_printf( struct format_screen *sc, const char *fmt, ... )
+{
+    va_list arg;
+    int done;
+
+    buf[0] = '\0';
+    sc->arg = buf;
+    va_start ( arg, fmt );
+    done = format( format_screen_put, sc, fmt, arg );
+    va_end ( arg );
+
+    return done;
+}
+#endif
+
 /*****************************************************************************/
 /*****************************************************************************/
 
@@ -326,8 +505,92 @@ static void test_s( void )
     TEST( "(null)", 6, "%s", NULL );
 
     /* Check unused flags and lengths are ignored */
-    TEST( "hello", 5, "%+ 0!ls", "hello" );
+    TEST( "hello", 5, "%+ 0hs", "hello" );
+
+#if defined(CONFIG_WITH_UTF8)
+    /* The ! flag counts UTF-8 code points */
     TEST( "hello", 5, "%+ 0!hs", "hello" );
+    TEST( "  h\xc3\xa9llo", 8, "%8s", "h\xc3\xa9llo" );
+    TEST( "   h\xc3\xa9llo", 9, "%!8s", "h\xc3\xa9llo" );
+    TEST( "h\xc3\xa9llo   |", 10, "%!-8s|", "h\xc3\xa9llo" );
+    TEST( "  h\xc3\xa9llo ", 9, "%!^8s", "h\xc3\xa9llo" );
+    TEST( "h\xc3", 2, "%.2s", "h\xc3\xa9llo" );
+    TEST( "h\xc3\xa9", 3, "%!.2s", "h\xc3\xa9llo" );
+    TEST( "", 0, "%!.0s", "\xe2\x82\xac" "5" );
+    TEST( "\xe2\x82\xac", 3, "%!.1s", "\xe2\x82\xac" "5" );
+    TEST( "  \xf0\x9f\x98\x80", 6, "%!3.1s", "\xf0\x9f\x98\x80!" );
+    TEST( "(null)", 6, "%!s", NULL );
+
+    /* Every precision, from every alignment */
+    {
+        static const char pattern[] = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+        char src[56], exs[56];
+        unsigned int k, p, n, c;
+
+        for ( k = 0; k < 8; k++ )
+            src[k] = 'x';
+        for ( src[k] = '\0'; k < 40; k += sizeof( pattern ) - 1 )
+            strcat( src, pattern );
+
+        for ( k = 0; k < 8; k++ )
+            for ( p = 0; p <= 40; p++ )
+            {
+                for ( n = 0, c = 0; src[k + n]; n++ )
+                    if ( ( src[k + n] & 0xC0 ) != 0x80 && c++ == p )
+                        break;
+                memcpy( exs, src + k, n );
+                exs[n] = '\0';
+                TEST( exs, (int)n, "%!.*s", p, src + k );
+            }
+    }
+#else
+    FAIL( "%!s", "hello" );
+#endif
+
+#if defined(CONFIG_WITH_WIDE_CHARS)
+    /* Wide strings are written as UTF-8 */
+    TEST( "hello", 5, "%+ 0ls", L"hello" );
+    TEST( "h\xc3\xa9llo", 6, "%ls", L"h\u00e9llo" );
+    TEST( "  h\xc3\xa9llo", 8, "%8ls", L"h\u00e9llo" );
+    TEST( "h\xc3\xa9llo   |", 10, "%!-8ls|", L"h\u00e9llo" );
+    TEST( "h", 1, "%.2ls", L"h\u00e9llo" );
+    TEST( "h\xc3\xa9", 3, "%.3ls", L"h\u00e9llo" );
+    TEST( "h\xc3\xa9", 3, "%!.2ls", L"h\u00e9llo" );
+    TEST( "  \xe2\x82\xac|", 6, "%5.4ls|", L"\u20ac\u20ac" );
+    TEST( "\xe2\x82\xac\xf0\x9f\x98\x80", 7, "%ls", L"\u20ac\U0001F600" );
+    TEST( "(null)", 6, "%ls", NULL );
+    {
+        static const wchar_t bad[] = { 0xD800, 'x', 0 };
+        TEST( "\xef\xbf\xbdx", 4, "%ls", bad );
+    }
+
+    /* Longer than the staging block */
+    {
+        wchar_t src[32];
+        char exs[100];
+        unsigned int i;
+
+        for ( i = 0; i < 31; i++ )
+        {
+            src[i] = 0x20AC;
+            memcpy( exs + 3 * i, "\xe2\x82\xac", 3 );
+        }
+        src[i] = 0;
+        exs[3 * i] = '\0';
+        TEST( exs, 93, "%ls", src );
+        TEST( exs, 93, "%.93ls", src );
+        exs[3 * 10] = '\0';
+        TEST( exs, 30, "%!.10ls", src );
+        TEST( exs, 30, "%.32ls", src );
+    }
+
+    TEST( "\xc3\xa9", 2, "%lc", L'\u00e9' );
+    TEST( "\xe2\x82\xac\xe2\x82\xac", 6, "%.2lc", L'\u20ac' );
+    TEST( "A", 1, "%lc", L'A' );
+#else
+    FAIL( "%ls", L"hello" );
+    FAIL( "%lc", 'x' );
+#endif
 
 #if defined(__AVR__)
     {
@@ -337,6 +600,67 @@ static void test_s( void )
 #endif
 }
 
+#if defined(CONFIG_WITH_CONV_Q)
+/*****************************************************************************/
+/**
+    Execute tests on 'q' conversion specifier
+**/
+static void test_q( void )
+{
+    char src[48], exs[64];
+    unsigned int i;
+
+    printf( "Testing \"%%q\"\n" );
+
+    /* JSON */
+    TEST( "\"hello\"", 7, "%q", "hello" );
+    TEST( "\"\"", 2, "%q", "" );
+    TEST( "\"a\\\"b\\\\c\"", 9, "%q", "a\"b\\c" );
+    TEST( "\"\\b\\f\\n\\r\\t\"", 12, "%q", "\b\f\n\r\t" );
+    TEST( "\"\\u0001\\u001f\\u0007\"", 20, "%q", "\x01\x1f\a" );
+    TEST( "\"caf\xc3\xa9\x7f\"", 8, "%q", "caf\xc3\xa9\x7f" );
+    TEST( "null", 4, "%q", NULL );
+
+    /* C */
+    TEST( "\"a\\\"b\\n\\a\\v\"", 12, "%#q", "a\"b\n\a\v" );
+    TEST( "\"\\0011\\177\\303\\251\"", 19, "%#q", "\0011\x7f\xc3\xa9" );
+    TEST( "(null)", 6, "%#q", NULL );
+
+    /* CSV */
+    TEST( "\"a,\"\"b\"\"\n\\\"", 11, "%!q", "a,\"b\"\n\\" );
+
+    /* Width and precision */
+    TEST( "  \"a\\nb\"|", 9, "%8q|", "a\nb" );
+    TEST( "\"a\\nb\"  |", 9, "%-8q|", "a\nb" );
+    TEST( " \"a\\nb\" |", 9, "%^8q|", "a\nb" );
+    TEST( "\"a\\nb\"|", 7, "%4q|", "a\nb" );
+    TEST( "\"a\\n\"", 5, "%.2q", "a\nbcd" );
+    TEST( "  \"\\u0001\"|", 11, "%10.1q|", "\x01z" );
+
+    /* An escape at every position of a long string */
+    for ( i = 0; i < 40; i++ )
+    {
+        memset( src, 'x', 40 );
+        src[40] = '\0';
+        src[i]  = '"';
+        memset( exs + 1, 'x', 41 );
+        exs[0]     = '"';
+        exs[i + 1] = '\\';
+        exs[i + 2] = '"';
+        exs[42]    = '"';
+        exs[43]    = '\0';
+        TEST( exs, 43, "%q", src );
+
+        src[i] = (char)0x80;
+        memcpy( exs + i + 1, "\\200", 4 );
+        memset( exs + i + 5, 'x', 39 - i );
+        exs[44] = '"';
+        exs[45] = '\0';
+        TEST( exs, 45, "%#q", src );
+    }
+}
+#endif
+
 /*****************************************************************************/
 /**
     Execute tests on 'p' conversion specifier
@@ -896,7 +1220,13 @@ static void test_aAeEfFgG( void )
     TEST( "0.000000", 8, "%.6f", 0.0000001 );
     TEST( "0.0000001000", 12, "%.10f", 0.0000001 );
 
-    TEST( "1234567800000006000000000000000000000000000000000000000000000"
+#if defined(CONFIG_WITH_FP_BOUNDED_TIME)
+    /* The bounded-time radix conversion is accurate to all 16 digits */
+    #define BIG_F_DIGITS    "1234567800000000"
+#else
+    #define BIG_F_DIGITS    "1234567800000006"
+#endif
+    TEST( BIG_F_DIGITS "000000000000000000000000000000000000000000000"
           "0000000000000000000000000000000000000000000000000000000000000"
           "0000000000000000000000000000000000000000000000000000000000000"
           "0000000000000000000000000000000000000000000000000000000000000"
@@ -1063,12 +1393,134 @@ static void test_k( void )
     s4p8 =  - ( ( ( 1 ) << 8 ) | (int)( 0.5 * 256 ) ); /* -1.50 */
     TEST( "-1.500000", 9, "%{4.8}k", s4p8 );
 
+    /* Most negative value, and bits outside the type */
+    TEST( "-8.000000", 9, "%{4.4}k", 0x80 );
+    TEST( "0.000000", 8, "%{4.4}k", 0x100 );
+
     /* Formatting */
     s4p8 =  ( ( 1 ) << 8 ) | (int)( 0.5 * 256 ); /* 1.50 */
     TEST( "  1.50  ", 8, "%^8.2{4.8}k", s4p8 );  
 }
 #endif /* CONFIG_WITH_FP_SUPPORT */
 
+#if defined(CONFIG_WITH_CONV_T)
+/*****************************************************************************/
+/**
+    Execute tests on T (timestamp) conversion specifier.
+**/
+static void test_T( void )
+{
+    printf( "Testing \"%%T\"\n" );
+
+    /* Epoch */
+    TEST( "1970-01-01T00:00:00Z", 20, "%T", 0LL );
+    TEST( "1970-01-01T00:00:00.000Z", 24, "%.3T", 0LL );
+
+    /* Fraction of a second, then the same second from the cache */
+    TEST( "2023-11-14T22:13:20.123456789Z", 30, "%.9T", 1700000000123456789LL );
+    TEST( "2023-11-14T22:13:20.999Z", 24, "%.3T", 1700000000999999999LL );
+    TEST( "2023-11-14T22:13:20.000000000Z", 30, "%.12T", 1700000000000000000LL );
+
+    /* Next second, and next day */
+    TEST( "2023-11-14T22:13:21Z", 20, "%T", 1700000001000000000LL );
+    TEST( "2023-11-15T22:13:20Z", 20, "%T", 1700086400000000000LL );
+    TEST( "2024-02-29T12:00:00Z", 20, "%T", 1709208000000000000LL );
+
+    /* Before the epoch */
+    TEST( "1969-12-31T23:59:59.999999999Z", 30, "%.9T", -1LL );
+    TEST( "1969-12-31T23:59:59Z", 20, "%T", -1000000000LL );
+
+    /* Two timestamps in one format */
+    TEST( "1970-01-01T00:00:01Z 1970-01-01T00:00:00Z", 41, "%T %T",
+          1000000000LL, 0LL );
+
+    /* Formatting */
+    TEST( "1970-01-01T00:00:00Z  |", 23, "%-22T|", 0LL );
+    TEST( "  1970-01-01T00:00:00Z|", 23, "%22T|", 0LL );
+
+#if defined(CONFIG_WITH_CONV_BASE)
+    /* Other tick lengths */
+    TEST( "2023-11-14T22:13:20.123456Z", 27, "%.6:6T", 1700000000123456LL );
+    TEST( "2023-11-14T22:13:20.123000Z", 27, "%.6:3T", 1700000000123LL );
+    TEST( "9999-12-31T23:59:59.99Z", 23, "%.2:2T", 25340230079999LL );
+    FAIL( "%:2T", 25340230080000LL );
+    FAIL( "%:1T", 0LL );
+    FAIL( "%:10T", 0LL );
+    TEST( "1970-01-01T00:00:00Z", 20, "%T", 0LL );
+#endif
+}
+#endif
+
+#if defined(CONFIG_WITH_CONV_NET)
+/*****************************************************************************/
+/**
+    Make an IPv4 address in network byte order from its four octets.
+**/
+static uint32_t ipv4( unsigned char a, unsigned char b,
+                      unsigned char c, unsigned char d )
+{
+    unsigned char octets[4];
+    uint32_t v;
+
+    octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d;
+    memcpy( &v, octets, sizeof v );
+    return v;
+}
+
+/*****************************************************************************/
+/**
+    Execute tests on 'N' and 'M' conversion specifiers
+**/
+static void test_NM( void )
+{
+    static const unsigned char v6_zero[16]     = { 0 };
+    static const unsigned char v6_loopback[16] = { 0,0, 0,0, 0,0, 0,0,
+                                                   0,0, 0,0, 0,0, 0,1 };
+    static const unsigned char v6_doc[16]      = { 0x20,0x01, 0x0d,0xb8, 0,0, 0,0,
+                                                   0,0, 0,0, 0,0, 0,1 };
+    static const unsigned char v6_prefix[16]   = { 0,1 };
+    static const unsigned char v6_single[16]   = { 0x20,0x01, 0x0d,0xb8, 0,0, 0,1,
+                                                   0,1, 0,1, 0,1, 0,1 };
+    static const unsigned char v6_tied[16]     = { 0x20,0x01, 0,0, 0,0, 0,1,
+                                                   0,0, 0,0, 0,1, 0,1 };
+    static const unsigned char v6_longer[16]   = { 0x20,0x01, 0,0, 0,0, 0,1,
+                                                   0,0, 0,0, 0,0, 0,1 };
+    static const unsigned char v6_full[16]     = { 0xfe,0x80, 0x12,0x34, 0xab,0xcd, 0x0f,0xff,
+                                                   0x00,0x10, 0x01,0x00, 0xf0,0x00, 0xff,0xff };
+    static const unsigned char v6_mapped[16]   = { 0,0, 0,0, 0,0, 0,0,
+                                                   0,0, 0xff,0xff, 192,0, 2,128 };
+    static const unsigned char mac[6]          = { 0x00, 0x1a, 0x2b, 0xc3, 0xd4, 0xef };
+
+    printf( "Testing \"%%N\" and \"%%M\"\n" );
+
+    /* IPv4 */
+    TEST( "0.0.0.0", 7, "%N", ipv4( 0, 0, 0, 0 ) );
+    TEST( "255.255.255.255", 15, "%N", ipv4( 255, 255, 255, 255 ) );
+    TEST( "192.168.1.10", 12, "%N", ipv4( 192, 168, 1, 10 ) );
+    TEST( "10.0.99.100", 11, "%N", ipv4( 10, 0, 99, 100 ) );
+    TEST( "   127.0.0.1", 12, "%12N", ipv4( 127, 0, 0, 1 ) );
+    TEST( "127.0.0.1   |", 13, "%-12N|", ipv4( 127, 0, 0, 1 ) );
+
+    /* IPv6 */
+    TEST( "::", 2, "%#N", v6_zero );
+    TEST( "::1", 3, "%#N", v6_loopback );
+    TEST( "2001:db8::1", 11, "%#N", v6_doc );
+    TEST( "1::", 3, "%#N", v6_prefix );
+    TEST( "2001:db8:0:1:1:1:1:1", 20, "%#N", v6_single );
+    TEST( "2001::1:0:0:1:1", 15, "%#N", v6_tied );
+    TEST( "2001:0:0:1::1", 13, "%#N", v6_longer );
+    TEST( "fe80:1234:abcd:fff:10:100:f000:ffff", 35, "%#N", v6_full );
+    TEST( "::ffff:192.0.2.128", 18, "%#N", v6_mapped );
+    TEST( "  ::1", 5, "%#5N", v6_loopback );
+    TEST( "(null)", 6, "%#N", NULL );
+
+    /* MAC */
+    TEST( "00:1A:2B:C3:D4:EF", 17, "%M", mac );
+    TEST( "00:1A:2B:C3:D4:EF  |", 20, "%-19M|", mac );
+    TEST( "(null)", 6, "%M", NULL );
+}
+#endif
+
 /*****************************************************************************/
 /**
     Test asterisk.
@@ -1096,6 +1548,14 @@ static void test_asterisk( void )
     /* Grouping */
     TEST( "1,2_34", 6, "%[,*_*]d", 1234, 2, 1 );
     TEST( "1234", 4, "%[_1,*]d", 1234, -1 );
+#if defined(CONFIG_WITH_CONV_C)
+    TEST( "1,2_34 x", 8, "%[,*_*]d %c", 1234, 2, 1, 'x' );
+#endif
+    TEST( "1,2_34 5", 8, "%[,*_*]d %d", 1234, 2, 1, 5 );
+#if defined(CONFIG_WITH_CONV_B)
+    TEST( "1111_1111_1111_1111_1111_1111_1111_1111", 39, "%[_4]b", 0xFFFFFFFF );
+#endif
+    TEST( "1_2_3_4_5_6_7_8_9", 17, "%[_1]d", 123456789 );
 #endif
 
     /* Also check maximum precision and widths */
@@ -1177,6 +1637,653 @@ static void test_cont( void )
 #endif
 }
 
+/*****************************************************************************/
+/**
+    Test positional arguments.
+**/
+static void test_positional( void )
+{
+    printf( "Testing positional arguments\n" );
+
+    /* Reordering and reuse */
+    TEST( "b a", 3, "%2$s %1$s", "a", "b" );
+    TEST( "abab", 4, "%1$s%1$s", "ab" );
+    TEST( "x 2 1", 5, "%3$s %2$d %1$d", 1, 2, "x" );
+    TEST( "5%", 2, "%1$d%%", 5 );
+    TEST( "%5", 2, "%%%1$d", 5 );
+
+    /* Same argument, different conversions of the same type */
+    TEST( "255 0xff", 8, "%1$d %1$#x", 255 );
+
+    /* Width and precision arguments */
+    TEST( "  abc", 5, "%2$*1$s", 5, "abc" );
+    TEST( "abc  ", 5, "%2$*1$s", -5, "abc" );
+    TEST( "ab", 2, "%2$.*1$s", 2, "abc" );
+    TEST( "   ab|", 6, "%3$*1$.*2$s|", 5, 2, "abc" );
+
+    /* Length modifiers */
+    TEST( "2 1 3", 5, "%2$ld %1$hd %3$zu", 1, 2L, (size_t)3 );
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    TEST( "1234567890123 7", 15, "%2$lld %1$d", 7, 1234567890123LL );
+#endif
+
+#if defined(CONFIG_WITH_CONV_EFG)
+    TEST( "1.50 3", 6, "%2$.2f %1$d", 3, 1.5 );
+#endif
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    /* Grouping arguments follow the value */
+    TEST( "1,234,567 x", 11, "%1$[,*]d %3$s", 1234567, 3, "x" );
+#endif
+
+#if defined(CONFIG_WITH_CONV_K)
+    /* Fixed-point arguments are read at the width of the fixed-point type */
+    TEST( "x -3.500000", 11, "%2$s %1${24.16}k", -0x38000L, "x" );
+#endif
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT) && defined(CONFIG_WITH_CONV_P)
+    /* %p ignores grouping, but still reads its arguments */
+    if ( sizeof( void * ) == 8 )
+        TEST( "0000000000001234 x", 18, "%1$[:*]p %3$s", (void *)0x1234, 4, "x" );
+#endif
+
+#if defined(CONFIG_WITH_CONV_N)
+    {
+        int n = 0;
+
+        TEST( "abc", 3, "%2$s%1$n", &n, "abc" );
+        CHECK( n, 3 );
+    }
+#endif
+
+    /* Conversions must all be positional or all sequential */
+    FAIL( "%1$d %d", 1, 2 );
+    FAIL( "%d %1$d", 1, 2 );
+    FAIL( "%1$*d", 1, 2 );
+
+    /* Argument numbers must be in range, with no gaps */
+    FAIL( "%0$d", 1 );
+    FAIL( "%17$d", 1 );
+    FAIL( "%1$d %3$d", 1, 2, 3 );
+
+    /* One argument cannot have two types */
+    FAIL( "%1$d %1$s", 1 );
+    FAIL( "%1$d %1$ld", 1 );
+}
+
+#if defined(CONFIG_WITH_SCAN)
+/*****************************************************************************/
+/**
+    Test format_scan(), mostly by reading back the output of format().
+**/
+static void test_scan( void )
+{
+    char s[16], t[16];
+    int i, j, k;
+    long l;
+    unsigned int u;
+    short h;
+    signed char hh;
+    size_t z;
+    void *p;
+
+    printf( "Testing format_scan()\n" );
+
+    /* Literal text, white space and integers */
+    CHECK( test_sscanf( "12 -34", "%d %d", &i, &j ), 2 );
+    CHECK( i, 12 );
+    CHECK( j, -34 );
+    CHECK( test_sscanf( "x=  +7;", "x=%d;", &i ), 1 );
+    CHECK( i, 7 );
+    CHECK( test_sscanf( "7,8", "%d , %d", &i, &j ), 2 );
+    CHECK( j, 8 );
+    CHECK( test_sscanf( "1 2", "%d,%d", &i, &j ), 1 );
+    CHECK( test_sscanf( "x", "%d", &i ), 0 );
+    CHECK( test_sscanf( "", "%d", &i ), 0 );
+
+    /* Field width */
+    CHECK( test_sscanf( "12345", "%2d%3d", &i, &j ), 2 );
+    CHECK( i, 12 );
+    CHECK( j, 345 );
+
+    /* Length qualifiers */
+    CHECK( test_sscanf( "300 -2 100000 70000 9", "%hhd %hd %ld %d %zu",
+                        &hh, &h, &l, &i, &z ), 5 );
+    CHECK( hh, 44 );
+    CHECK( h, -2 );
+    CHECK( (int)l, 100000 );
+    CHECK( i, 70000 );
+    CHECK( (int)z, 9 );
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    {
+        long long ll;
+
+        CHECK( test_sscanf( "-1234567890123456789", "%lld", &ll ), 1 );
+        CHECK( ll == -1234567890123456789LL, 1 );
+        CHECK( test_sscanf( "12345678901234567", "%lld", &ll ), 1 );
+        CHECK( ll == 12345678901234567LL, 1 );
+        CHECK( test_sscanf( "1234567a", "%lld", &ll ), 1 );
+        CHECK( ll == 1234567LL, 1 );
+    }
+#endif
+
+    /* Bases and prefixes */
+    CHECK( test_sscanf( "ff 0xFF 17 0b101 101", "%x %X %o %b %b", &i, &j, &k, &u, &l ), 5 );
+    CHECK( i, 255 );
+    CHECK( j, 255 );
+    CHECK( k, 15 );
+    CHECK( (int)u, 5 );
+    CHECK( (int)l, 5 );
+    CHECK( test_sscanf( "0x", "%x", &i ), 0 );
+    CHECK( test_sscanf( "0xg", "%2x", &i ), 0 );
+#if defined(CONFIG_WITH_CONV_BASE)
+    test_sprintf( buf, "%:36I %:3u", 123456789, 100u );
+    CHECK( test_sscanf( buf, "%:36I %:3U", &i, &u ), 2 );
+    CHECK( i, 123456789 );
+    CHECK( (int)u, 100 );
+#endif
+    test_sprintf( buf, "%p", (void *)buf );
+    CHECK( test_sscanf( buf, "%p", &p ), 1 );
+    CHECK( p == (void *)buf, 1 );
+
+    /* Assignment suppression, %n and %% */
+    CHECK( test_sscanf( "1 2 3", "%*d %d %n%*d", &i, &j ), 1 );
+    CHECK( i, 2 );
+    CHECK( j, 4 );
+    CHECK( test_sscanf( "50 %", "%d %%", &i ), 1 );
+
+    /* Characters and strings */
+    CHECK( test_sscanf( "  ab cd", "%c%3c", s, t ), 2 );
+    CHECK( s[0], ' ' );
+    CHECK( memcmp( t, " ab", 3 ), 0 );
+    CHECK( test_sscanf( " hello world", "%s %s", s, t ), 2 );
+    CHECK( strcmp( s, "hello" ), 0 );
+    CHECK( strcmp( t, "world" ), 0 );
+    CHECK( test_sscanf( "abcdef", "%3s%.4s", s, t ), 2 );
+    CHECK( strcmp( s, "abc" ), 0 );
+    CHECK( strcmp( t, "def" ), 0 );
+    CHECK( test_sscanf( "abcdef", "%.4s%s", s, t ), 2 );
+    CHECK( strcmp( s, "abc" ), 0 );
+    CHECK( strcmp( t, "def" ), 0 );
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    /* Grouping separators are skipped between digits */
+    test_sprintf( buf, "%[,3]d", -1234567 );
+    CHECK( test_sscanf( buf, "%[,3]d", &i ), 1 );
+    CHECK( i, -1234567 );
+    test_sprintf( buf, "%[_4]x", 0xDEADBEEF );
+    CHECK( test_sscanf( buf, "%[_4]x", &u ), 1 );
+    CHECK( u == 0xDEADBEEF, 1 );
+    CHECK( test_sscanf( "1,234,", "%[,3]d%n", &i, &j ), 1 );
+    CHECK( i, 1234 );
+    CHECK( j, 5 );
+    CHECK( test_sscanf( "1,2", "%d,%d", &i, &j ), 2 );
+    CHECK( test_sscanf( "1;2", "%[,3]d", &i ), 1 );
+    CHECK( i, 1 );
+#endif
+
+    /* Input read in blocks */
+    CHECK( test_bscanf( "1234567890 -42 abc,1,234", 1, "%d %d %s", &i, &j, s ), 3 );
+    CHECK( i, 1234567890 );
+    CHECK( j, -42 );
+    CHECK( strcmp( s, "abc,1,234" ), 0 );
+    CHECK( test_bscanf( "0x1f 7", 1, "%x %d", &i, &j ), 2 );
+    CHECK( i, 31 );
+    CHECK( j, 7 );
+    CHECK( test_bscanf( "1234567890 9", 5, "%ld %d", &l, &j ), 2 );
+    CHECK( l == 1234567890L, 1 );
+    CHECK( j, 9 );
+#if defined(CONFIG_WITH_LONG_LONG_SUPPORT)
+    {
+        long long ll;
+
+        CHECK( test_bscanf( "123456789012345678 9", 9, "%lld %d", &ll, &j ), 2 );
+        CHECK( ll == 123456789012345678LL, 1 );
+        CHECK( j, 9 );
+    }
+#endif
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    CHECK( test_bscanf( "1,234,567,", 2, "%[,3]d%n", &i, &j ), 1 );
+    CHECK( i, 1234567 );
+    CHECK( j, 9 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_EFG) && defined(CONFIG_WITH_CONV_A) \
+ && defined(CONFIG_WITH_CONV_K) && defined(CONFIG_WITH_ENGINEERING)
+    {
+        static char huge[200002];
+        double d, e;
+        float g;
+
+        CHECK( test_sscanf( "1.5 -2.5e3 0.1", "%lf %le %f", &d, &e, &g ), 3 );
+        CHECK( d == 1.5, 1 );
+        CHECK( e == -2500.0, 1 );
+        CHECK( g == 0.1f, 1 );
+        CHECK( test_sscanf( "0x1.8p1 inf", "%la %lg", &d, &e ), 2 );
+        CHECK( d == 3.0, 1 );
+        CHECK( isinf( e ), 1 );
+        CHECK( test_sscanf( "1e", "%lf", &d ), 0 );
+        CHECK( test_sscanf( "1", "%Lf", &d ), EXBADFORMAT );
+
+        /* More digits than the buffer holds */
+        CHECK( test_sscanf( "1234567890123456789012345678901234567890"
+                            "1234567890123456789012345678901234567890.5",
+                            "%lf", &d ), 1 );
+        CHECK( d == 1234567890123456789012345678901234567890e40, 1 );
+        memset( huge, '1', sizeof huge - 1 );
+        huge[sizeof huge - 1] = '\0';
+        CHECK( test_sscanf( huge, "%lf%n", &d, &i ), 1 );
+        CHECK( isinf( d ), 1 );
+        CHECK( i, (int)sizeof huge - 1 );
+
+        CHECK( test_bscanf( "0.10000000000000001", 3, "%lf", &d ), 1 );
+        CHECK( d == 0.1, 1 );
+
+        /* SI multipliers */
+        test_sprintf( buf, "%!f|", 0.0015 );
+        CHECK( test_sscanf( buf, "%!lf|", &d ), 1 );
+        CHECK( d == 0.0015, 1 );
+        CHECK( test_sscanf( "2.5 k 3", "%!lf %d", &d, &i ), 2 );
+        CHECK( d == 2500.0, 1 );
+        CHECK( i, 3 );
+        CHECK( test_sscanf( "2.5 x", "%!lf %n", &d, &i ), 1 );
+        CHECK( d == 2.5, 1 );
+        CHECK( i, 4 );
+
+        /* Fixed-point */
+        test_sprintf( buf, "%.4k", 0x18000 );
+        CHECK( test_sscanf( buf, "%k", &i ), 1 );
+        CHECK( i, 0x18000 );
+        CHECK( test_sscanf( "-1.25", "%{8.8}k", &i ), 1 );
+        CHECK( i, -0x140 );
+    }
+#endif
+
+    /* Bad formats and arguments */
+    CHECK( test_sscanf( "1", "%y", &i ), EXBADFORMAT );
+    CHECK( test_sscanf( "1", "%ls", s ), EXBADFORMAT );
+    CHECK( test_sscanf( "1", "%.0s", s ), EXBADFORMAT );
+    CHECK( test_sscanf( "1", NULL ), EXBADFORMAT );
+    CHECK( test_sscanf( NULL, "%d", &i ), EXBADFORMAT );
+}
+#endif
+
+#if defined(CONFIG_WITH_TEMPLATE)
+/*****************************************************************************/
+/**
+    Test display templates.
+**/
+static void test_template( void )
+{
+    struct format_template t;
+    struct format_cell cells[4];
+    char text[64];
+    char name[8];
+
+    printf( "Testing display templates\n" );
+
+    CHECK( format_template_init( &t, "T=%4d%% F=%-3u [%5s]", cells, 4,
+                                 text, sizeof text ), 3 );
+    CHECK( (int)t.len, 21 );
+    CHECK( strcmp( text, "T=    % F=    [     ]" ), 0 );
+
+    /* The first update sends everything */
+    strcpy( name, "ok" );
+    CHECK( test_update( &t, 21, 50u, name ), 21 );
+    CHECK( strcmp( buf, "0:T=  21% F=50  [   ok]|" ), 0 );
+
+    /* Then only what changes */
+    CHECK( test_update( &t, 21, 50u, name ), 0 );
+    CHECK( strcmp( buf, "" ), 0 );
+    CHECK( test_update( &t, 22, 50u, name ), 1 );
+    CHECK( strcmp( buf, "5:2|" ), 0 );
+    CHECK( test_update( &t, -122, 7u, name ), 4 );
+    CHECK( strcmp( buf, "2:-1|10:7 |" ), 0 );
+    CHECK( strcmp( text, "T=-122% F=7   [   ok]" ), 0 );
+
+    /* Strings are compared by their text */
+    strcpy( name, "on" );
+    CHECK( test_update( &t, -122, 7u, name ), 1 );
+    CHECK( strcmp( buf, "19:n|" ), 0 );
+
+    /* A value too wide for its cell is truncated */
+    CHECK( test_update( &t, 123456, 7u, name ), 4 );
+    CHECK( strcmp( buf, "2:1234|" ), 0 );
+
+    /* Clearing valid sends everything again */
+    t.valid = 0;
+    CHECK( test_update( &t, 123456, 7u, name ), 21 );
+    CHECK( strcmp( buf, "0:T=1234% F=7   [   on]|" ), 0 );
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT) && defined(CONFIG_WITH_CONV_C)
+    CHECK( format_template_init( &t, "%.3C-%9[,3]ld%.2C-", cells, 4,
+                                 text, sizeof text ), 1 );
+    CHECK( test_update( &t, 1234567L ), 14 );
+    CHECK( strcmp( buf, "0:---1,234,567--|" ), 0 );
+    CHECK( test_update( &t, 1234568L ), 1 );
+    CHECK( strcmp( buf, "11:8|" ), 0 );
+#endif
+
+#if defined(CONFIG_WITH_FP_SUPPORT)
+    CHECK( format_template_init( &t, "%5.1f", cells, 4, text, sizeof text ), 1 );
+    CHECK( test_update( &t, 0.0 ), 5 );
+    CHECK( test_update( &t, 0.0 ), 0 );
+    CHECK( test_update( &t, -0.0 ), 1 );
+    CHECK( strcmp( buf, "1:-|" ), 0 );
+#endif
+
+    /* Every cell needs a fixed width */
+    CHECK( format_template_init( &t, "%d", cells, 4, text, sizeof text ), EXBADFORMAT );
+    CHECK( format_template_init( &t, "%*d", cells, 4, text, sizeof text ), EXBADFORMAT );
+    CHECK( format_template_init( &t, "%3.*d", cells, 4, text, sizeof text ), EXBADFORMAT );
+    CHECK( format_template_init( &t, "%3n", cells, 4, text, sizeof text ), EXBADFORMAT );
+    CHECK( format_template_init( &t, "%3", cells, 4, text, sizeof text ), EXBADFORMAT );
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    CHECK( format_template_init( &t, "%9[,*]d", cells, 4, text, sizeof text ), EXBADFORMAT );
+#endif
+
+    /* and must fit */
+    CHECK( format_template_init( &t, "%2d%2d", cells, 1, text, sizeof text ), EXBADFORMAT );
+    CHECK( format_template_init( &t, "%2d", cells, 1, text, 2 ), EXBADFORMAT );
+    CHECK( format_template_init( &t, "abc", cells, 0, text, 3 ), EXBADFORMAT );
+    CHECK( format_template_init( &t, "abc", NULL, 0, text, 4 ), 0 );
+    CHECK( test_update( &t ), 3 );
+    CHECK( strcmp( buf, "0:abc|" ), 0 );
+}
+#endif
+
+#if defined(CONFIG_WITH_SCREEN)
+/*****************************************************************************/
+/**
+    Test positioned output to a screen.
+**/
+static void test_screen( void )
+{
+    struct format_screen sc;
+    char line[8];
+
+    printf( "Testing screen output\n" );
+
+    /* Without staging each piece of output is a run */
+    format_screen_init( &sc, rowwrite, buf, 8, 3, NULL );
+    CHECK( test_screen_printf( &sc, "ab%5d", 42 ), 7 );
+    CHECK( strcmp( buf, "(0,0)ab|(2,0)   |(5,0)42|" ), 0 );
+    CHECK( (int)sc.x, 7 );
+
+    /* Runs are split where the output wraps */
+    CHECK( test_screen_printf( &sc, "%s", "xyz" ), 3 );
+    CHECK( strcmp( buf, "(7,0)x|(0,1)yz|" ), 0 );
+
+    /* and at newlines */
+    CHECK( test_screen_printf( &sc, "1\n\n2" ), 4 );
+    CHECK( strcmp( buf, "(2,1)1|(0,0)2|" ), 0 );
+    CHECK( (int)sc.y, 0 );
+
+    /* With staging each row is sent once */
+    format_screen_init( &sc, rowwrite, buf, 8, 3, line );
+    CHECK( format_screen_move( &sc, 1, 1 ), 0 );
+    CHECK( test_screen_printf( &sc, "ab%5d", 42 ), 7 );
+    CHECK( strcmp( buf, "(1,1)ab   42|" ), 0 );
+    CHECK( test_screen_printf( &sc, "%-12s|", "wrap" ), 13 );
+    CHECK( strcmp( buf, "(0,2)wrap    |" ), 0 );
+    CHECK( format_screen_flush( &sc ), 0 );
+    CHECK( strcmp( buf, "(0,2)wrap    |(0,0)    ||" ), 0 );
+    CHECK( format_screen_flush( &sc ), 0 );
+
+    /* Moving sends what is staged first */
+    CHECK( test_screen_printf( &sc, "%c", 'z' ), 1 );
+    CHECK( strcmp( buf, "" ), 0 );
+    CHECK( format_screen_move( &sc, 20, 20 ), 0 );
+    CHECK( strcmp( buf, "(5,0)z|" ), 0 );
+    CHECK( (int)sc.x, 7 );
+    CHECK( (int)sc.y, 2 );
+
+    /* Rows of any length */
+    format_screen_init( &sc, rowwrite, buf, 0, 0, line );
+    CHECK( sc.line == NULL, 1 );
+    CHECK( test_screen_printf( &sc, "%s\n%s", "abcdefghijklmnopqrst", "b" ), 22 );
+    CHECK( strcmp( buf, "(0,0)abcdefghijklmnopqrst|(0,1)b|" ), 0 );
+}
+#endif
+
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+/**
+    A currency amount in cents, formatted by a custom conversion.
+**/
+struct money {
+    long    cents;
+};
+
+/*****************************************************************************/
+/**
+    Custom conversion handler writing a currency amount as "$1.23", or
+    "USD 1.23" with the '#' flag.
+
+    @param cons     Pointer to consumer function.
+    @param parg     Pointer to opaque pointer updated by cons.
+    @param conv     The parsed conversion.
+    @param value    Pointer to the amount.
+
+    @returns Number of characters sent, or EXBADFORMAT.
+**/
+static int conv_money( void * (* cons)(void *, const char *, size_t),
+                       void * * parg,
+                       const struct format_conv * conv,
+                       const void * value )
+{
+    const struct money *m = value;
+    char text[32];
+    long c;
+    int n;
+
+    if ( m == NULL )
+        return EXBADFORMAT;
+
+    c = m->cents < 0 ? -m->cents : m->cents;
+    n = sprintf( text, "%s%s%ld.%02ld", m->cents < 0 ? "-" : "",
+                 ( conv->flags & FORMAT_FHASH ) ? "USD " : "$", c / 100, c % 100 );
+
+    return format_field( cons, parg, conv, text, (size_t)n );
+}
+
+/*****************************************************************************/
+/**
+    Test custom conversions.
+**/
+static void test_custom( void )
+{
+    struct money price = { 1234 }, refund = { -5 };
+
+    printf( "Testing custom conversions\n" );
+
+    /* Registration */
+    CHECK( format_register( 'R', conv_money ), 0 );
+    CHECK( format_register( 'd', conv_money ), EXBADFORMAT );
+    CHECK( format_register( 'l', conv_money ), EXBADFORMAT );
+    CHECK( format_register( '!', conv_money ), EXBADFORMAT );
+    CHECK( format_register( '[', conv_money ), EXBADFORMAT );
+
+    TEST( "$12.34", 6, "%R", &price );
+    TEST( "-$0.05 USD 12.34", 16, "%R %#R", &refund, &price );
+
+    /* Width, precision and justification */
+    TEST( "    $12.34|", 11, "%10R|", &price );
+    TEST( "$12.34    |", 11, "%-10R|", &price );
+    TEST( "  $12.34  |", 11, "%^10R|", &price );
+    TEST( "   $12|", 7, "%6.3R|", &price );
+    TEST( "$12.34  |", 9, "%*R|", -8, &price );
+    TEST( "x$12.34y", 8, "x%Ry", &price );
+
+#if defined(CONFIG_WITH_POSITIONAL)
+    TEST( "$12.34 7 -$0.05", 15, "%2$R %3$d %1$R", &refund, &price, 7 );
+#endif
+
+    /* The handler's failure is passed on */
+    FAIL( "%R", (struct money *)NULL );
+
+    /* Removed */
+    CHECK( format_register( 'R', NULL ), 0 );
+    FAIL( "%R", &price );
+}
+#endif
+
+/*****************************************************************************/
+/**
+    Test the optional conversions and features are present or absent as
+    configured.
+**/
+static void test_options( void )
+{
+    printf( "Testing optional conversions and features\n" );
+
+#if defined(CONFIG_WITH_CONV_C)
+    TEST( "x", 1, "%c", 'x' );
+    TEST( "xx", 2, "%.2Cx", UNUSED );
+#else
+    FAIL( "%c", 'x' );
+    FAIL( "%Cx", UNUSED );
+#endif
+
+#if defined(CONFIG_WITH_CONV_S)
+    TEST( "str", 3, "%s", "str" );
+#else
+    FAIL( "%s", "str" );
+#endif
+
+#if defined(CONFIG_WITH_CONV_Q)
+    TEST( "\"a\\n\"", 5, "%q", "a\n" );
+#else
+    FAIL( "%q", "a\n" );
+#endif
+
+#if defined(CONFIG_WITH_CONV_N)
+    {
+        int n = 0;
+        TEST( "ab", 2, "ab%n", &n );
+        CHECK( n, 2 );
+    }
+#else
+    FAIL( "ab%n", NULL );
+#endif
+
+#if defined(CONFIG_WITH_CONV_P)
+    CHECK( test_sprintf( buf, "%p", NULL ), (int)( sizeof( void * ) * 2 ) );
+#else
+    FAIL( "%p", NULL );
+#endif
+
+#if defined(CONFIG_WITH_CONV_D)
+    TEST( "-12 -12", 7, "%d %i", -12, -12 );
+#else
+    FAIL( "%d", -12 );
+    FAIL( "%i", -12 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_U)
+    TEST( "12", 2, "%u", 12 );
+#else
+    FAIL( "%u", 12 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_X)
+    TEST( "ff FF", 5, "%x %X", 255, 255 );
+#else
+    FAIL( "%x", 255 );
+    FAIL( "%X", 255 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_O)
+    TEST( "10", 2, "%o", 8 );
+#else
+    FAIL( "%o", 8 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_B)
+    TEST( "101", 3, "%b", 5 );
+#else
+    FAIL( "%b", 5 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_D) && defined(CONFIG_WITH_CONV_BASE)
+    TEST( "-12 FF", 6, "%:3i %:16I", -5, 255 );
+#elif defined(CONFIG_WITH_CONV_D)
+    FAIL( "%:3i", -5 );
+    FAIL( "%I", 255 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_U) && defined(CONFIG_WITH_CONV_BASE)
+    TEST( "12 FF", 5, "%:3u %:16U", 5, 255 );
+#elif defined(CONFIG_WITH_CONV_U)
+    FAIL( "%:3u", 5 );
+    FAIL( "%U", 255 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_EFG)
+    TEST( "1.500000 1.5 1.500000e+00", 25, "%f %.3g %e", 1.5, 1.5, 1.5 );
+#else
+    FAIL( "%f", 1.5 );
+    FAIL( "%g", 1.5 );
+    FAIL( "%e", 1.5 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_EFG) && defined(CONFIG_WITH_ENGINEERING)
+    TEST( "1.500000 k 12.345000e+03", 24, "%!f %!e", 1500.0, 12345.0 );
+#elif defined(CONFIG_WITH_CONV_EFG)
+    FAIL( "%!f", 1500.0 );
+    FAIL( "%!e", 12345.0 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_A)
+    TEST( "0x1p+0", 6, "%a", 1.0 );
+#else
+    FAIL( "%a", 1.0 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_K)
+    TEST( "1.5", 3, "%.1k", 0x18000 );
+    TEST( "1.5", 3, "%.1{8.8}k", 0x180 );
+#else
+    FAIL( "%k", 0x18000 );
+#endif
+
+#if defined(CONFIG_WITH_CONV_T)
+    TEST( "1970-01-01T00:00:00Z", 20, "%T", 0LL );
+#else
+    FAIL( "%T", 0LL );
+#endif
+
+#if defined(CONFIG_WITH_CONV_NET)
+    TEST( "0.0.0.0", 7, "%N", 0 );
+#else
+    FAIL( "%N", 0 );
+    FAIL( "%M", NULL );
+#endif
+
+#if defined(CONFIG_WITH_UTF8)
+    TEST( " \xc3\xa9", 3, "%!2s", "\xc3\xa9" );
+#elif defined(CONFIG_WITH_CONV_S)
+    FAIL( "%!2s", "\xc3\xa9" );
+#endif
+
+#if defined(CONFIG_WITH_CONTINUATION)
+    TEST( "ab", 2, "a%", "b" );
+#else
+    FAIL( "a%", "b" );
+#endif
+
+#if defined(CONFIG_WITH_GROUPING_SUPPORT)
+    TEST( "1,234", 5, "%[,3]d", 1234 );
+#elif defined(CONFIG_WITH_CONV_D)
+    FAIL( "%[,3]d", 1234 );
+#endif
+
+#if defined(CONFIG_WITH_POSITIONAL) && defined(CONFIG_WITH_CONV_S)
+    TEST( "b a", 3, "%2$s %1$s", "a", "b" );
+#elif defined(CONFIG_WITH_CONV_S)
+    FAIL( "%2$s %1$s", "a", "b" );
+#endif
+}
+
 /*****************************************************************************/
 /**
     Run all tests on format library.
@@ -1184,29 +2291,117 @@ static void test_cont( void )
 static void run_tests( char * passes )
 {
     if ( !passes )
-        passes = "S%cnspdb"
-#if defined(CONFIG_WITH_FP_SUPPORT)
-		"ak"
+        passes = "S%o"
+#if defined(CONFIG_WITH_CONV_C)
+                 "c"
+#endif
+#if defined(CONFIG_WITH_CONV_N)
+                 "n"
+#endif
+#if defined(CONFIG_WITH_CONV_S)
+                 "s"
+#endif
+#if defined(CONFIG_WITH_CONV_Q)
+                 "q"
+#endif
+#if defined(CONFIG_WITH_CONV_P) && defined(CONFIG_WITH_CONV_D)
+                 "p"
+#endif
+#if defined(CONFIG_WITH_CONV_D) && defined(CONFIG_WITH_CONV_BASE)
+                 "d"
+#endif
+#if defined(CONFIG_WITH_CONV_B) && defined(CONFIG_WITH_CONV_O) \
+ && defined(CONFIG_WITH_CONV_U) && defined(CONFIG_WITH_CONV_X) \
+ && defined(CONFIG_WITH_CONV_BASE)
+                 "b"
+#endif
+#if defined(CONFIG_WITH_CONV_EFG) && defined(CONFIG_WITH_CONV_A) \
+ && defined(CONFIG_WITH_ENGINEERING) && defined(CONFIG_WITH_CONV_C) \
+ && defined(CONFIG_WITH_CONV_D) && defined(CONFIG_WITH_CONV_S) \
+ && defined(CONFIG_WITH_CONV_O) && defined(CONFIG_WITH_CONV_X)
+                 "a"
+#endif
+#if defined(CONFIG_WITH_CONV_K)
+                 "k"
 #endif
-		"*\"";
+#if defined(CONFIG_WITH_CONV_T)
+                 "T"
+#endif
+#if defined(CONFIG_WITH_CONV_NET)
+                 "N"
+#endif
+#if defined(CONFIG_WITH_CONV_D)
+                 "*"
+#endif
+#if defined(CONFIG_WITH_CONTINUATION) && defined(CONFIG_WITH_CONV_C) \
+ && defined(CONFIG_WITH_CONV_D) && defined(CONFIG_WITH_CONV_S)
+                 "\""
+#endif
+#if defined(CONFIG_WITH_POSITIONAL) && defined(CONFIG_WITH_CONV_D) \
+ && defined(CONFIG_WITH_CONV_S) && defined(CONFIG_WITH_CONV_X) \
+ && defined(CONFIG_WITH_CONV_U)
+                 "$"
+#endif
+#if defined(CONFIG_WITH_TEMPLATE) && defined(CONFIG_WITH_CONV_D) \
+ && defined(CONFIG_WITH_CONV_U) && defined(CONFIG_WITH_CONV_S)
+                 "m"
+#endif
+#if defined(CONFIG_WITH_SCREEN) && defined(CONFIG_WITH_CONV_D) \
+ && defined(CONFIG_WITH_CONV_C) && defined(CONFIG_WITH_CONV_S)
+                 "l"
+#endif
+#if defined(CONFIG_WITH_CUSTOM_CONV) && defined(CONFIG_WITH_CONV_D)
+                 "x"
+#endif
+#if defined(CONFIG_WITH_SCAN) && defined(CONFIG_WITH_CONV_D) \
+ && defined(CONFIG_WITH_CONV_U) && defined(CONFIG_WITH_CONV_X) \
+ && defined(CONFIG_WITH_CONV_O) && defined(CONFIG_WITH_CONV_B) \
+ && defined(CONFIG_WITH_CONV_C) && defined(CONFIG_WITH_CONV_S) \
+ && defined(CONFIG_WITH_CONV_N) && defined(CONFIG_WITH_CONV_P)
+                 "r"
+#endif
+                 ;
 
     if ( !strcmp( passes, "-help" ) )
     {
         printf( "Passes:\n"
                 " S    - strings\n"
                 " %%    - percent\n"
+                " o    - optional conversions and features\n"
                 " c    - %%c character conversion\n"
                 " n    - %%n conversion\n"
                 " s    - %%s string conversion\n"
+#if defined(CONFIG_WITH_CONV_Q)
+                " q    - %%q quoted string conversion\n"
+#endif
                 " p    - %%p pointer conversion\n"
                 " d    - %%d, %%i integer conversions\n"
                 " b    - %%b, %%o, %%u, %%x, %%X fixed base conversions\n"
 #if defined(CONFIG_WITH_FP_SUPPORT)
 		" a    - %%a, %%A, %%e, %%E, %%f, %%F, %%g, %%G floating point conversions\n"
                 " k    - %%k fixed-point conversion\n"
+#endif
+#if defined(CONFIG_WITH_CONV_T)
+                " T    - %%T timestamp conversion\n"
+#endif
+#if defined(CONFIG_WITH_CONV_NET)
+                " N    - %%N, %%M network address conversions\n"
 #endif
                 " *    - asterisk parameters (width, precision\n"
                 " \"    - continuation\n"
+                " $    - positional arguments\n"
+#if defined(CONFIG_WITH_TEMPLATE)
+                " m    - display templates\n"
+#endif
+#if defined(CONFIG_WITH_SCREEN)
+                " l    - screen output\n"
+#endif
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+                " x    - custom conversions\n"
+#endif
+#if defined(CONFIG_WITH_SCAN)
+                " r    - format_scan() scanner\n"
+#endif
                 );
         return;
     }
@@ -1219,18 +2414,41 @@ static void run_tests( char * passes )
         {
             case 'S': test_strings(); break;
             case '%': test_pc();      break;
+            case 'o': test_options(); break;
             case 'c': test_cC();      break;
             case 'n': test_n();       break;
             case 's': test_s();       break;
+#if defined(CONFIG_WITH_CONV_Q)
+            case 'q': test_q();       break;
+#endif
             case 'p': test_p();       break;
             case 'd': test_di();      break;
             case 'b': test_bouxX();   break;
 #if defined(CONFIG_WITH_FP_SUPPORT)
 	    case 'a': test_aAeEfFgG(); break;
             case 'k': test_k();        break;
+#endif
+#if defined(CONFIG_WITH_CONV_T)
+            case 'T': test_T();        break;
+#endif
+#if defined(CONFIG_WITH_CONV_NET)
+            case 'N': test_NM();       break;
 #endif
             case '*': test_asterisk(); break;
             case '\"': test_cont();   break;
+            case '$': test_positional(); break;
+#if defined(CONFIG_WITH_TEMPLATE)
+            case 'm': test_template(); break;
+#endif
+#if defined(CONFIG_WITH_SCREEN)
+            case 'l': test_screen();   break;
+#endif
+#if defined(CONFIG_WITH_CUSTOM_CONV)
+            case 'x': test_custom();   break;
+#endif
+#if defined(CONFIG_WITH_SCAN)
+            case 'r': test_scan();     break;
+#endif
             default: printf( "Unknown test '%c'\n", *passes ); break;
         }
         passes++;
@@ -376,6 +376,13 @@ static void test_buxX( void )
     TEST( "1101", 4, "%b", 13 );
     TEST( "1234", 4, "%u", 1234 );
 
+    /* Every digit position of a 16-bit value */
+    TEST( "65535", 5, "%u", 65535 );
+    TEST( "10000 9999 1000 999 100 99 10 9", 31, "%u %u %u %u %u %u %u %u",
+          10000, 9999, 1000, 999, 100, 99, 10, 9 );
+    TEST( "1000000000000000", 16, "%b", 0x8000 );
+    TEST( "ffff", 4, "%x", 0xFFFF );
+
     TEST( "12cd", 4, "%x", 0x12cd );
     TEST( "12CD", 4, "%X", 0x12CD );
 
@@ -460,6 +467,57 @@ static void test_cont( void )
     TEST( "hello world", 11, "hello % +-12.24", "world" );
 }
 
+/*****************************************************************************/
+/**
+    Format consumer function counting its calls and the characters sent.
+**/
+static unsigned int ncalls;
+
+static void * countwrite( void * memptr, const char * pbuf, size_t n )
+{
+    ncalls++;
+    return bufwrite( memptr, pbuf, n );
+}
+
+/*****************************************************************************/
+/**
+    Format with countwrite, returning the number of consumer calls.
+**/
+static int test_calls( const char *fmt, ... )
+{
+    va_list arg;
+    int done;
+
+    ncalls = 0;
+    va_start ( arg, fmt );
+    done = format( countwrite, buf, fmt, arg );
+    va_end ( arg );
+
+    return done < 0 ? done : (int)ncalls;
+}
+
+/*****************************************************************************/
+/**
+    Check that padding is sent in blocks, not one character at a time.
+**/
+#if defined(CONFIG_TINY_PAD_RUN)
+  #define BLOCKS(n)     ( ( (n) + CONFIG_TINY_PAD_RUN - 1 ) / CONFIG_TINY_PAD_RUN )
+#else
+  #define BLOCKS(n)     ( ( (n) + 7 ) / 8 )
+#endif
+
+static void test_blocks( void )
+{
+    printf( "Testing padding blocks\n" );
+
+    CHECK( test_calls( "%8d", 1 ), BLOCKS( 7 ) + 1 );
+    CHECK( test_calls( "%08d", -1 ), 1 + BLOCKS( 6 ) + 1 );
+    CHECK( test_calls( "%-20s", "ab" ), 1 + BLOCKS( 18 ) );
+    CHECK( test_calls( "%.80c", '-' ), BLOCKS( 80 ) );
+    CHECK( test_calls( "%c", '-' ), 1 );
+    TEST( "       1|-0000001|ab                  |", 39, "%8d|%08d|%-20s|", 1, -1, "ab" );
+}
+
 /*****************************************************************************/
 /**
     Run all tests on format library.
@@ -474,6 +532,7 @@ static void run_tests( void )
     test_d();
     test_buxX();
     test_cont();
+    test_blocks();
 
     printf( "-----------------------\n"
             "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
@@ -0,0 +1,259 @@
+/* ***************************************************************************
+ * Format - lightweight string formatting library.
+ * Copyright (C) 2010-2023, Neil Johnson
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ************************************************************************* */
+
+/*****************************************************************************/
+/* System Includes                                                           */
+/*****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+/*****************************************************************************/
+/* Project Includes                                                          */
+/*****************************************************************************/
+
+#include "format.h"
+
+/**
+    Set the size of the test buffers
+**/
+#define BUF_SZ      ( 1024 )
+
+static char buf[BUF_SZ];
+static unsigned int f = 0;
+
+/*****************************************************************************/
+/**
+    Format consumer function to write characters to a user-supplied buffer.
+
+    @param memptr   Pointer to output buffer
+    @param pbuf     Pointer to buffer of characters to consume from
+    @param n        Number of characters from @p buf to consume
+
+    @returns NULL if failed, else address of next output cell.
+**/
+static void * bufwrite( void * memptr, const char * pbuf, size_t n )
+{
+    return ( (char *)memcpy( memptr, pbuf, n ) + n );
+}
+
+/*****************************************************************************/
+/**
+    Check the result of a format call and print out accordingly.
+
+    @param line             Line number of the test
+    @param r                Returned value
+    @param exs              Expected result string
+    @param rtn              Expected return value
+**/
+static void check( int line, int r, const char *exs, int rtn )
+{
+    if ( 0 <= r )
+        buf[r] = '\0';
+    printf( "[Test  @ %3d] ", line );
+    if ( r != rtn )
+        {printf("########### FAIL: produced \"%s\", returned %d, expected %d.", buf, r, rtn );f+=1;}
+    else if ( rtn >= 0 && strcmp( exs, buf ) )
+        {printf("########### FAIL: produced \"%s\", expected \"%s\".", buf, exs);f+=1;}
+    else
+        printf("PASS");
+    printf("\n");
+}
+
+/**
+    Wrapper macros to standardise checking of test results, as in
+    testharness.c.  The arguments are passed through FORMAT().
+
+    @param exs              Expected result string
+    @param rtn              Expected return value
+    @param fmt              Test format string
+    @param ...              Argument list
+**/
+#define TEST(exs, rtn, ...)                                                 \
+            check( __LINE__, FORMAT( bufwrite, buf, __VA_ARGS__ ),          \
+                   (exs), (rtn) )
+
+#define FAIL(...)                                                           \
+            check( __LINE__, FORMAT( bufwrite, buf, __VA_ARGS__ ),          \
+                   "", EXBADFORMAT )
+
+/**
+    Check if two integers are the same and print out accordingly.
+**/
+#define CHECK(a,b)      do { printf("[Check @ %3d] ", __LINE__ );           \
+                            if ((a)==(b))                                   \
+                                printf( "PASS");                            \
+                            else {printf("**** FAIL: got %d, expected %d",(a),(b));f+=1;}\
+                            printf("\n");                                   \
+                        }while(0);
+
+/*****************************************************************************/
+/**
+    Execute tests on text and the integer conversions.
+**/
+static void test_integers( void )
+{
+    printf( "Testing text and integers\n" );
+
+    TEST( "", 0, "" );
+    TEST( "hello world", 11, "hello world" );
+    TEST( "% %", 3, "%% %5%" );
+
+    TEST( "42", 2, "%d", 42 );
+    TEST( "  -42|", 6, "%5d|", -42 );
+    TEST( "ff FF 0xff", 10, "%x %X %#x", 255, 255U, 255 );
+    TEST( "4294967295", 10, "%u", 0xFFFFFFFFU );
+    TEST( "-1 255", 6, "%hhd %hhu", (signed char)-1, (unsigned char)255 );
+    TEST( "-1 65535", 8, "%hd %hu", (short)-1, (unsigned short)65535 );
+
+    /* the qualifier comes from the type of the argument */
+    TEST( "-1234567890123", 14, "%d", -1234567890123LL );
+    TEST( "-7 65 123", 9, "%ld %lld %u", -7, 'A', 123L );
+    TEST( "18446744073709551615", 20, "%u",
+          0xFFFFFFFFFFFFFFFFULL );
+    TEST( "123 456 789", 11, "%d %zu %jd", 123L, (size_t)456, (intmax_t)789 );
+
+    TEST( "   12", 5, "%*d", 5, 12 );
+    TEST( "00012", 5, "%.*d", 5, 12 );
+    TEST( "1,234,567", 9, "%[,3]d", 1234567 );
+    TEST( "12_345_67", 9, "%[_*_*]d", 1234567, 2, 3 );
+
+    /* a width must be an int */
+    FAIL( "%*d", 5L, 12 );
+    FAIL( "%[_*]d", 1234567, 3L );
+}
+
+/*****************************************************************************/
+/**
+    Execute tests on the other conversions.
+**/
+static void test_others( void )
+{
+    int n = 0;
+    short sn = 0;
+    const char *ps = "world";
+    char s[] = "mutable";
+    const unsigned char v6[16] = { 0 };
+    const unsigned char mac[6] = { 0, 0, 0, 0, 0, 42 };
+
+    printf( "Testing other conversions\n" );
+
+    TEST( "A", 1, "%c", 'A' );
+    TEST( "hello world", 11, "hello %s", ps );
+    TEST( "mut", 3, "%.3s", s );
+    TEST( "\"a\\\"b\"", 6, "%q", "a\"b" );
+    TEST( "\xc3\xa9t\xc3\xa9 \xe2\x82\xac", 9, "%ls %lc", L"\u00e9t\u00e9", L'\u20ac' );
+    TEST( "abc", 3, "abc%n", &n );
+    CHECK( n, 3 );
+    TEST( "abcdef", 6, "abc%hndef", &sn );
+    CHECK( sn, 3 );
+    TEST( "0000000000001234", 16, "%p", (void *)0x1234 );
+
+    /* floats are not promoted, but read as double */
+    TEST( "1.500000", 8, "%f", 1.5 );
+    TEST( "1.50", 4, "%.2f", 1.5f );
+    TEST( "1.2e+03", 7, "%.1e", 1234.0 );
+    TEST( "2023-11-14T22:13:20.123Z", 24, "%.3T", 1700000000123456789LL );
+    /* int64_t is long on some targets, and long long on others */
+    TEST( "2023-11-14T22:13:20Z", 20, "%T", (int64_t)1700000000000000000LL );
+    TEST( "0.0.0.0 ::", 10, "%N %#N", (uint32_t)0, v6 );
+    TEST( "00:00:00:00:00:2A", 17, "%M", mac );
+
+    TEST( "hello old world", 15, "hello %", "old %", "world" );
+    TEST( "One: 1,Two: 2", 13, "One: %d,%", 1, "Two: %d", 2 );
+}
+
+/*****************************************************************************/
+/**
+    Execute tests on arguments which do not match their conversions.
+**/
+static void test_mismatch( void )
+{
+    int n = 0;
+
+    printf( "Testing mismatched arguments\n" );
+
+    FAIL( "%d", "string" );
+    FAIL( "%s", 42 );
+    FAIL( "%f", 42 );
+    FAIL( "%d", 1.5 );
+    FAIL( "%n", 42 );
+    FAIL( "%s", &n );
+    FAIL( "%c", 65L );
+    FAIL( "%p", 42 );
+    FAIL( "%T", 0 );
+    FAIL( "%q", 42 );
+    FAIL( "%M", 42 );
+    FAIL( "%ls", 42 );
+    FAIL( "%#N", 0 );
+
+    /* missing arguments */
+    FAIL( "%d" );
+    FAIL( "%d %d", 1 );
+    FAIL( "%*d", 5 );
+    FAIL( "%[_*]d", 1234567 );
+    FAIL( "One: %d,%", 1 );
+}
+
+#if defined(CONFIG_WITH_POSITIONAL)
+/*****************************************************************************/
+/**
+    Execute tests with positional arguments.
+**/
+static void test_positional( void )
+{
+    printf( "Testing positional arguments\n" );
+
+    TEST( "b a", 3, "%2$s %1$s", "a", "b" );
+    TEST( "   42 1000", 10, "%2$*1$d %3$d", 5, 42, 1000LL );
+    FAIL( "%2$s %1$d", "a", "b" );
+    FAIL( "%3$d", 1, 2 );
+}
+#endif
+
+/*****************************************************************************/
+/* Public functions.  Defined in header file.                                */
+/*****************************************************************************/
+
+int main( void )
+{
+    test_integers();
+    test_others();
+    test_mismatch();
+#if defined(CONFIG_WITH_POSITIONAL)
+    test_positional();
+#endif
+
+    printf( "-----------------------\n"
+            "Summary: %s (%u failures)\n", f ? "FAIL" : "PASS", f );
+    return f ? 1 : 0;
+}